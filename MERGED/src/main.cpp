@@ -5,11 +5,34 @@
 
 #include <Arduino.h>
 #include <WiFi.h>
-#include <WiFiClientSecure.h>
-#include <HTTPClient.h>
+#include <ESPmDNS.h>
+#include <lwip/sockets.h>
 #include <ArduinoJson.h>
-#include <Adafruit_NeoPixel.h>
-#include <DHT.h>
+#include <atomic>
+#include <esp_heap_caps.h>
+#include <esp_pm.h>
+#include <esp_sntp.h>
+#include <Preferences.h>
+
+#include "connection_manager.h"
+#include "delay_watcher.h"
+#include "device_clock.h"
+#include "dht22_reader.h"
+#include "histogram.h"
+#include "json_codec.h"
+#include "led_effects.h"
+#include "littlefs_storage.h"
+#include "local_control.h"
+#include "rate_controller.h"
+#include "reading_buffer.h"
+#include "reading_log.h"
+#include "rmt_pixel_output.h"
+#include "sample_filter.h"
+#include "scheduler.h"
+#include "swinging_door.h"
+#include "telemetry.h"
+#include "wifi_reconnect.h"
+#include "wire_format.h"
 
 // ============================================
 // CONFIGURATION - UPDATE PASSWORD BELOW!
@@ -18,23 +41,98 @@
 const char* WIFI_SSID = "Eagle";
 const char* WIFI_PASSWORD = "eagle786"; // ← CHANGE THIS!
 
-const char* API_URL_SENSOR = "https://monitor-dashboard-newf.vercel.app/api/sensor";
+// dedupe=off: readings are already compressed on the device (swinging door)
+const char* API_URL_SENSOR = "https://monitor-dashboard-newf.vercel.app/api/sensor?dedupe=off";
 const char* API_URL_DELAY = "https://monitor-dashboard-newf.vercel.app/api/delay";
-
-// DHT22 Sensor
+const char* API_URL_TELEMETRY = "https://monitor-dashboard-newf.vercel.app/api/telemetry";
+
+// SNTP (resyncs hourly); readings are stamped with the synced time
+const char* NTP_SERVER_1 = "pool.ntp.org";
+const char* NTP_SERVER_2 = "time.google.com";
+
+// LAN control: http://climate-monitor.local/delay answers in
+// milliseconds; local changes are pushed on to the cloud. Requests must
+// carry Authorization: Bearer LOCAL_CONTROL_TOKEN (the dashboard's
+// "LAN token" setting); left empty, every request is refused.
+const char* LOCAL_HOSTNAME = "climate-monitor";
+const char* LOCAL_CONTROL_TOKEN = "";   // ← SET THIS to enable LAN control
+const uint16_t LOCAL_CONTROL_PORT = 80;
+const size_t LOCAL_RECV_CHUNK = 128;            // headers stream through this
+const size_t LOCAL_RESPONSE_SIZE = 512;
+const unsigned long LOCAL_READ_TIMEOUT = 200;   // ms per recv()
+const unsigned long LOCAL_REQUEST_DEADLINE = 1500;  // ms for a whole request
+
+// DHT22 Sensor (captured by RMT, see dht22_reader.h)
 #define DHTPIN 38
-#define DHTTYPE DHT22
-DHT dht(DHTPIN, DHTTYPE);
+#define DHT_RMT_CHANNEL RMT_CHANNEL_4   // ESP32-S3 RX channels are 4-7
+Dht22Reader dhtReader((gpio_num_t)DHTPIN, DHT_RMT_CHANNEL);
+
+// Raw readings go through a sliding median (drops single glitches)
+// and an EMA before compression
+const size_t FILTER_WINDOW = 5;
+const float FILTER_ALPHA = 0.5;
+SampleFilter<FILTER_WINDOW> temperatureFilter(FILTER_ALPHA);
+SampleFilter<FILTER_WINDOW> humidityFilter(FILTER_ALPHA);
 
-// NeoPixel
+// NeoPixel strip (WS2812 driven by RMT, see rmt_pixel_output.h)
 #define NEOPIXEL_PIN    48
-#define NUM_PIXELS      1
+#define NUM_PIXELS      1       // strips of several hundred pixels work too
 #define PIXEL_BRIGHTNESS 150
+#define LED_RMT_CHANNEL RMT_CHANNEL_0   // ESP32-S3 TX channels are 0-3
+const LedEffect LED_EFFECT = LedEffect::Blink;
+const Rgb LED_COLOR = { 0, 150, 255 };
+// Animated effects render a frame this often (ms)
+const int64_t LED_FRAME_INTERVAL = 20;
+// A frame waits this long for the previous one to leave the wire (24
+// bits of 1.25 us per pixel), and is retried this often if it still
+// could not be sent (ms)
+const uint32_t LED_SHOW_WAIT = NUM_PIXELS * 30 / 1000 + 1;
+const int64_t LED_RETRY_INTERVAL = 2;
 
 // Timing
-const unsigned long SENSOR_POLL_INTERVAL = 2000;
-const unsigned long DELAY_POLL_INTERVAL = 3000;
 const unsigned long HTTP_TIMEOUT = 5000;
+const unsigned long DIAGNOSTICS_REPORT_INTERVAL = 60000;
+// Wi-Fi state is re-checked this often while connecting (events wake
+// the loop immediately); loop() never sleeps longer than MAX_IDLE
+const unsigned long WIFI_POLL_INTERVAL = 1000;
+const unsigned long DHT_POLL_STEP = 5;
+const unsigned long MAX_IDLE = 1000;
+
+// Delay updates are long-polled: the server holds the request for up
+// to DELAY_LONG_POLL_WAIT ms and answers as soon as the delay changes
+const unsigned long DELAY_LONG_POLL_WAIT = 8000;
+const unsigned long DELAY_RETRY_INTERVAL = 3000;
+
+// Batching: readings are queued and uploaded together once
+// BATCH_SIZE readings are waiting or the oldest is BATCH_MAX_AGE old
+const size_t BATCH_SIZE = 10;
+const size_t BATCH_CAPACITY = 60;
+const unsigned long BATCH_MAX_AGE = 20000;
+
+// Store-and-forward: batches that can't be uploaded go to a flash log
+// (LOG_CAPACITY readings) and are drained one batch per LOG_DRAIN_INTERVAL
+// once the link is back. A batch the server refuses with a 4xx other than
+// 408/429 is dropped instead: it would be refused every time
+const uint32_t LOG_CAPACITY = 2048;
+const unsigned long LOG_DRAIN_INTERVAL = 1000;
+
+// Upload batches in the compact binary format (wire_format.h) instead of JSON
+const bool USE_BINARY_UPLOADS = true;
+
+// Preallocated request/response buffers; the upload buffer fits a full
+// batch in the worst case of either format
+const size_t UPLOAD_BUFFER_SIZE = jsonBatchMaxSize(BATCH_SIZE);
+static_assert(UPLOAD_BUFFER_SIZE >= wireEncodedSize(BATCH_SIZE), "binary batch exceeds the upload buffer");
+const size_t ERROR_BODY_SIZE = 96;
+const size_t TELEMETRY_BUFFER_SIZE = 896;
+
+// Adaptive rates (rate_controller.h): sampling speeds up to
+// minSampleMs while readings move and relaxes to maxSampleMs when
+// steady. The server may push other limits with an upload response;
+// those are kept in NVS and clamped to the DHT22's 2 s and to 1 h.
+const uint32_t DHT_MIN_INTERVAL = 2000;
+const uint32_t MAX_RATE_INTERVAL = 3600000;
+const char* RATE_PREFS_NAMESPACE = "rate";
 
 // Delay limits
 const int MIN_DELAY = 50;
@@ -45,32 +143,137 @@ const int DEFAULT_DELAY = 500;
 // GLOBAL VARIABLES
 // ============================================
 
-Adafruit_NeoPixel pixel(NUM_PIXELS, NEOPIXEL_PIN, NEO_GRB + NEO_KHZ800);
-
-float lastTemperature = 0;
-float lastHumidity = 0;
-const float CHANGE_THRESHOLD = 0.1;
-
-volatile int blinkDelay = DEFAULT_DELAY;
-volatile bool ledState = false;
-unsigned long lastBlinkTime = 0;
-
-bool wifiConnected = false;
-
-WiFiClientSecure secureClient;
-HTTPClient httpSensor;
-HTTPClient httpDelay;
-
-unsigned long previousSensorMillis = 0;
-unsigned long previousDelayMillis = 0;
+RmtPixelOutput ledOutput((gpio_num_t)NEOPIXEL_PIN, LED_RMT_CHANNEL);
+LedRenderer ledRenderer(LED_EFFECT, LED_COLOR, PIXEL_BRIGHTNESS);
+// Double buffer: one frame is rendered while the other is on the wire
+uint8_t ledFrames[2][NUM_PIXELS * 3];
+int ledBackFrame = 0;
+// Latest filtered temperature for LedEffect::TemperatureBands
+std::atomic<float> latestTemperature(NAN);
+
+// Trend compression: a reading is uploaded only when the trend line through
+// uploaded readings would miss it by more than the channel's error bound,
+// or as a heartbeat after MAX_SILENCE without uploads
+const float TEMPERATURE_ERROR_BOUND = 0.1;   // °C
+const float HUMIDITY_ERROR_BOUND = 0.1;      // %RH
+const unsigned long MAX_SILENCE = 300000;
+const float TREND_ERROR_BOUNDS[2] = { TEMPERATURE_ERROR_BOUND, HUMIDITY_ERROR_BOUND };
+SwingingDoor<2> trendCompressor(TREND_ERROR_BOUNDS, MAX_SILENCE);
+
+// Sampling interval from how fast raw readings move (in error bounds);
+// uploads wait out 429/503 Retry-After and back off on other failures.
+// Both run on the loop task only.
+AdaptiveSampler<2> sampler(TREND_ERROR_BOUNDS, RateLimits());
+UploadThrottle uploadThrottle(UploadThrottleConfig(), (uint32_t)esp_random());
+RateLimits rateLimits;
+Preferences ratePrefs;
+
+// Written by the delay watch task, read by the LED task
+std::atomic<int> blinkDelay(DEFAULT_DELAY);
+TaskHandle_t ledTaskHandle = nullptr;
+
+// LED toggle jitter: |actual - requested| period in microseconds,
+// 100 us buckets up to 5 ms
+Histogram<50> ledJitter(100);
+portMUX_TYPE ledJitterMux = portMUX_INITIALIZER_UNLOCKED;
+
+// Starts/aborts association attempts for the reconnect state machine
+struct ArduinoWiFiDriver {
+    void begin();
+    void disconnect();
+};
+
+ArduinoWiFiDriver wifiDriver;
+WiFiReconnect<ArduinoWiFiDriver> wifiLink(wifiDriver, WiFiReconnectConfig(), (uint32_t)esp_random());
+WiFiReconnect<ArduinoWiFiDriver>::State lastWifiState = WiFiReconnect<ArduinoWiFiDriver>::State::Idle;
+
+ReadingBuffer<BATCH_CAPACITY> readingBuffer(BATCH_SIZE, BATCH_MAX_AGE);
+uint32_t deviceId = 0;
+char deviceName[9] = "";
+uint32_t uploadSequence = 0;
+uint32_t rejectedReadings = 0;      // refused with a 4xx and dropped
+uint8_t uploadBuffer[UPLOAD_BUFFER_SIZE];
+Reading uploadBatch[BATCH_SIZE];
+
+// millis() anchored to the last SNTP sync; sync() runs on the lwIP task
+DeviceClock deviceClock;
+portMUX_TYPE deviceClockMux = portMUX_INITIALIZER_UNLOCKED;
+
+LittleFsStorage logStorage("/readings.log",
+                           ReadingLog<LittleFsStorage>::RECORDS_OFFSET + LOG_CAPACITY * ReadingLog<LittleFsStorage>::RECORD_SIZE);
+ReadingLog<LittleFsStorage> readingLog(logStorage);
+bool readingLogReady = false;
+char errorBody[ERROR_BODY_SIZE];
+
+ConnectionManager connection(HTTP_TIMEOUT);
+// Held open by the long-poll, so the control channel gets its own
+// connection: two TLS sessions per boot (and per Wi-Fi reconnect), not one
+ConnectionManager controlConnection(DELAY_LONG_POLL_WAIT + HTTP_TIMEOUT);
+// Bumped on every Wi-Fi (re)connect; delayWatchTask owns controlConnection
+// and drops its socket itself when this changes
+std::atomic<uint32_t> wifiSessions(0);
+// A delay set over the LAN waits here until the loop task has posted
+// it to /api/delay (-1: nothing pending)
+std::atomic<int> pendingCloudDelay(-1);
+bool localAnnounced = false;
+
+// Conditional long-poll of /api/delay (only used by delayWatchTask)
+DelayWatcher delayWatcher(controlConnection, API_URL_DELAY, MIN_DELAY, MAX_DELAY, DELAY_LONG_POLL_WAIT);
+
+// Per-stage timing histograms, posted to /api/telemetry with the
+// diagnostics report and then reset
+Telemetry telemetry;
+Telemetry::Stats telemetrySnapshot;
+char telemetryBuffer[TELEMETRY_BUFFER_SIZE];
+uint32_t dhtStartUs = 0;
+
+// loop() runs whatever is due, then sleeps until the next deadline
+Scheduler<6> scheduler;
+int wifiJob = Scheduler<6>::NO_JOB;
+int dhtPollJob = Scheduler<6>::NO_JOB;
+int sensorJob = Scheduler<6>::NO_JOB;
+int cloudSyncJob = Scheduler<6>::NO_JOB;
+// Woken early by Wi-Fi events
+TaskHandle_t loopTaskHandle = nullptr;
 
 // ============================================
 // FUNCTION DECLARATIONS
 // ============================================
-void connectToWiFi();
-void sendSensorData();
-void fetchDelayFromAPI();
-void updateLED();
+void setupWiFi();
+void setupPowerSaving();
+void setupTimeSync();
+void loadRateLimits();
+void applyRateLimits(const RateLimits& limits);
+void storeRateLimits(const RateLimits& limits);
+void onTimeSync(struct timeval* tv);
+int64_t epochAt(uint32_t ms);
+void wifiStep(uint32_t nowMs);
+void sensorStep(uint32_t nowMs);
+void dhtPollStep(uint32_t nowMs);
+void drainStep(uint32_t nowMs);
+void diagnosticsStep(uint32_t nowMs);
+void cloudSyncStep(uint32_t nowMs);
+void localControlTask(void* param);
+void announceLocalControl(bool connected);
+void onWiFiEvent(WiFiEvent_t event);
+void logWiFiState();
+void sendSensorData(const DhtFrame& frame);
+bool uploadsThrottled(uint32_t nowMs);
+void flushReadings();
+UploadOutcome uploadReadings(const Reading* batch, size_t count);
+void spillToLog(size_t count);
+void drainReadingLog();
+int postBinaryBatch(const Reading* batch, size_t count);
+int postJsonBatch(const Reading* batch, size_t count);
+bool fetchDelayFromAPI();
+void delayWatchTask(void* param);
+void ledTask(void* param);
+void setBlinkDelay(int newDelay);
+bool showLedFrame(bool blinkOn);
+void showTestColor(Rgb color);
+void reportLedJitter();
+void reportHeap();
+void reportTelemetry();
 
 // ============================================
 // SETUP
@@ -79,182 +282,700 @@ void setup() {
     Serial.begin(115200);
     delay(500);
 
-    dht.begin();
-    pixel.begin();
-    pixel.setBrightness(PIXEL_BRIGHTNESS);
-    pixel.clear();
-    pixel.show();
+    if (!dhtReader.begin()) {
+        Serial.println("[Sensor] ❌ RMT setup failed");
+    }
+    if (!ledOutput.begin()) {
+        Serial.println("[LED] ❌ RMT setup failed");
+    }
 
     // LED test
-    pixel.setPixelColor(0, pixel.Color(255, 0, 0)); pixel.show(); delay(200);
-    pixel.setPixelColor(0, pixel.Color(0, 255, 0)); pixel.show(); delay(200);
-    pixel.setPixelColor(0, pixel.Color(0, 0, 255)); pixel.show(); delay(200);
-    pixel.clear(); pixel.show();
+    showTestColor({ 255, 0, 0 }); delay(200);
+    showTestColor({ 0, 255, 0 }); delay(200);
+    showTestColor({ 0, 0, 255 }); delay(200);
+    showTestColor({ 0, 0, 0 });
+
+    deviceId = (uint32_t)ESP.getEfuseMac();
+    snprintf(deviceName, sizeof(deviceName), "%08lx", (unsigned long)deviceId);
 
-    connectToWiFi();
-    secureClient.setInsecure();
+    Serial.printf("[Telemetry] Probe overhead %lu ns\n", (unsigned long)telemetry.calibrate());
+
+    readingLogReady = logStorage.begin() && readingLog.mount();
+    if (readingLogReady) {
+        if (readingLog.erasedOldLayout()) Serial.println("[Log] ⚠️ Erased a log left by older firmware");
+        Serial.printf("[Log] %u readings waiting from before reboot\n", (unsigned)readingLog.size());
+    } else {
+        Serial.println("[Log] ❌ Offline log unavailable, offline readings stay in RAM");
+    }
+
+    loadRateLimits();
+
+    connection.begin();
+    controlConnection.begin();
+    connection.setTelemetry(&telemetry);
+    delayWatcher.setTelemetry(&telemetry);
+    loopTaskHandle = xTaskGetCurrentTaskHandle();
+    setupWiFi();
+    setupPowerSaving();
+    setupTimeSync();
+
+    // LED runs on core 0 above loop() priority so network I/O can't stall it
+    xTaskCreatePinnedToCore(ledTask, "led", 4096, nullptr, 10, &ledTaskHandle, 0);
+    xTaskCreatePinnedToCore(delayWatchTask, "delayWatch", 8192, nullptr, 1, nullptr, 1);
+    xTaskCreatePinnedToCore(localControlTask, "localControl", 4096, nullptr, 2, nullptr, 1);
+
+    uint32_t now = millis();
+    wifiJob = scheduler.once(wifiStep);
+    scheduler.at(wifiJob, now + WIFI_POLL_INTERVAL);
+    dhtPollJob = scheduler.once(dhtPollStep);
+    cloudSyncJob = scheduler.once(cloudSyncStep);
+    // Re-armed after each reading with the sampler's interval
+    sensorJob = scheduler.once(sensorStep);
+    scheduler.at(sensorJob, now + sampler.intervalMs());
+    scheduler.every(LOG_DRAIN_INTERVAL, drainStep, now + LOG_DRAIN_INTERVAL);
+    scheduler.every(DIAGNOSTICS_REPORT_INTERVAL, diagnosticsStep, now + DIAGNOSTICS_REPORT_INTERVAL);
 
     Serial.println("\n✅ System Ready!");
-    previousSensorMillis = millis();
-    previousDelayMillis = millis();
 }
 
 // ============================================
 // MAIN LOOP
 // ============================================
 void loop() {
-    updateLED();
+    scheduler.runDue(millis());
+
+    // Idle until the next deadline: the idle task lets the CPU clock
+    // down (or light-sleep, see setupPowerSaving) instead of spinning
+    uint32_t idleMs = scheduler.idleTime(millis(), MAX_IDLE);
+    if (idleMs > 0 && ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(idleMs)) > 0) {
+        // Woken by a Wi-Fi event or a local delay change
+        scheduler.at(wifiJob, millis());
+        scheduler.at(cloudSyncJob, millis());
+    }
+}
+
+// ============================================
+// SCHEDULED JOBS
+// ============================================
+void wifiStep(uint32_t nowMs) {
+    using State = WiFiReconnect<ArduinoWiFiDriver>::State;
+    wifiLink.poll(nowMs);
+    logWiFiState();
+    if (wifiLink.connected() != localAnnounced) {
+        announceLocalControl(wifiLink.connected());
+    }
+
+    // Connected: nothing to time, the next event wakes us
+    switch (wifiLink.state()) {
+        case State::Connected:
+            break;
+        case State::Backoff:
+            scheduler.at(wifiJob, wifiLink.retryAtMs());
+            break;
+        default:
+            scheduler.at(wifiJob, nowMs + WIFI_POLL_INTERVAL);
+            break;
+    }
+}
+
+void sensorStep(uint32_t nowMs) {
+    // The capture runs in the background and is collected by dhtPollStep,
+    // which schedules the next one
+    if (dhtReader.start(nowMs)) {
+        dhtStartUs = Telemetry::nowUs();
+        scheduler.at(dhtPollJob, nowMs + DHT_POLL_STEP);
+    } else {
+        scheduler.at(sensorJob, nowMs + DHT_MIN_INTERVAL);
+    }
+}
 
-    unsigned long currentMillis = millis();
+void dhtPollStep(uint32_t nowMs) {
+    DhtFrame frame;
+    if (!dhtReader.poll(nowMs, frame)) {
+        scheduler.at(dhtPollJob, nowMs + DHT_POLL_STEP);
+        return;
+    }
+    telemetry.record(Stage::DhtRead, dhtStartUs);
+    sendSensorData(frame);
+    scheduler.at(sensorJob, nowMs + sampler.intervalMs());
+    if (readingBuffer.shouldFlush(nowMs)) {
+        flushReadings();
+    }
+}
+
+void drainStep(uint32_t nowMs) {
+    // Drain readings saved while offline, oldest first and rate-limited
+    if (readingLogReady && !readingLog.empty() && wifiLink.connected() && !uploadsThrottled(nowMs)) {
+        drainReadingLog();
+    }
+}
+
+void diagnosticsStep(uint32_t nowMs) {
+    reportLedJitter();
+    reportHeap();
+    Serial.printf("[Sched] Worst lateness %lu ms, %lu periods skipped\n",
+                  (unsigned long)scheduler.maxLatenessMs(), (unsigned long)scheduler.skippedPeriods());
+    scheduler.resetStats();
+    Serial.printf("[Rate] Sampling every %lu ms, %lu upload backoffs\n",
+                  (unsigned long)sampler.intervalMs(), (unsigned long)uploadThrottle.backoffs());
+    reportTelemetry();
+}
+
+// Pushes a delay set over the LAN to the cloud so the dashboard and the
+// long-poll agree with it; retried until it goes through
+void cloudSyncStep(uint32_t nowMs) {
+    int pending = pendingCloudDelay.exchange(-1);
+    if (pending < 0) return;
+
+    bool ok = false;
+    if (wifiLink.connected()) {
+        char body[24];
+        int length = snprintf(body, sizeof(body), "{\"delay\":%d}", pending);
+        int httpCode = connection.post(API_URL_DELAY, "application/json", (const uint8_t*)body, length);
+        ok = httpCode == 200;
+        if (!ok) Serial.printf("[Local] ❌ Cloud sync HTTP %d\n", httpCode);
+        connection.end();
+    }
 
-    if (currentMillis - previousSensorMillis >= SENSOR_POLL_INTERVAL) {
-        previousSensorMillis = currentMillis;
-        if (wifiConnected && WiFi.status() == WL_CONNECTED) {
-            sendSensorData();
-        } else {
-            connectToWiFi();
+    if (!ok) {
+        // Keep it unless a newer local change arrived meanwhile
+        int none = -1;
+        pendingCloudDelay.compare_exchange_strong(none, pending);
+        scheduler.at(cloudSyncJob, nowMs + DELAY_RETRY_INTERVAL);
+    }
+}
+
+// ============================================
+// LOCAL CONTROL (LAN)
+// ============================================
+// Target for handleControlRequest()
+struct LocalDelayTarget {
+    int delay() const { return blinkDelay.load(); }
+    bool setDelay(int newDelay) {
+        if (newDelay < MIN_DELAY || newDelay > MAX_DELAY) return false;
+        Serial.printf("[Local] Delay set to %dms\n", newDelay);
+        setBlinkDelay(newDelay);
+        pendingCloudDelay.store(newDelay);
+        if (loopTaskHandle) xTaskNotifyGive(loopTaskHandle);
+        return true;
+    }
+};
+
+void announceLocalControl(bool connected) {
+    localAnnounced = connected;
+    if (!connected) {
+        MDNS.end();
+        return;
+    }
+    if (MDNS.begin(LOCAL_HOSTNAME)) {
+        MDNS.addService("http", "tcp", LOCAL_CONTROL_PORT);
+        Serial.printf("[Local] Control at http://%s.local/delay\n", LOCAL_HOSTNAME);
+    } else {
+        Serial.println("[Local] ❌ mDNS start failed");
+    }
+}
+
+// Plain BSD sockets (lwIP): accept() blocks, so the task costs nothing
+// while idle. One request per connection: read until complete or
+// LOCAL_REQUEST_DEADLINE, answer, close. Headers are parsed as they
+// arrive and dropped, so their size doesn't matter.
+void localControlTask(void* param) {
+    static ControlRequest request;
+    static char chunk[LOCAL_RECV_CHUNK];
+    static char response[LOCAL_RESPONSE_SIZE];
+    LocalDelayTarget target;
+
+    int listener = socket(AF_INET, SOCK_STREAM, IPPROTO_IP);
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(LOCAL_CONTROL_PORT);
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    if (listener < 0 || bind(listener, (sockaddr*)&addr, sizeof(addr)) != 0 || listen(listener, 2) != 0) {
+        Serial.println("[Local] ❌ Control socket setup failed");
+        if (listener >= 0) close(listener);
+        vTaskDelete(nullptr);
+        return;
+    }
+
+    for (;;) {
+        int client = accept(listener, nullptr, nullptr);
+        if (client < 0) {
+            vTaskDelay(pdMS_TO_TICKS(100));
+            continue;
         }
+
+        receiveControlRequest(request, chunk, sizeof(chunk), LOCAL_READ_TIMEOUT, LOCAL_REQUEST_DEADLINE,
+            [client](char* buffer, size_t size, uint32_t timeoutMs) {
+                timeval timeout = { (long)(timeoutMs / 1000), (long)(timeoutMs % 1000) * 1000 };
+                setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+                return (int)recv(client, buffer, size, 0);
+            },
+            [] { return (uint32_t)millis(); });
+
+        size_t responseLength = handleControlRequest(request, target, LOCAL_CONTROL_TOKEN, response, sizeof(response));
+        send(client, response, responseLength, 0);
+        close(client);
     }
+}
 
-    if (currentMillis - previousDelayMillis >= DELAY_POLL_INTERVAL) {
-        previousDelayMillis = currentMillis;
-        if (wifiConnected && WiFi.status() == WL_CONNECTED) {
-            fetchDelayFromAPI();
-        } else {
-            connectToWiFi();
+// ============================================
+// LED TASK
+// ============================================
+void ledTask(void* param) {
+    bool ledState = false;
+    int64_t lastToggleUs = esp_timer_get_time();
+    int requestedDelay = blinkDelay.load();
+    bool delayChanged = false;
+    LedFramePacer pacer(LED_FRAME_INTERVAL, LED_RETRY_INTERVAL);
+
+    for (;;) {
+        int64_t elapsedMs = (esp_timer_get_time() - lastToggleUs) / 1000;
+        int64_t remainingMs = requestedDelay - elapsedMs;
+        // Animated effects also wake for every frame in between, and a
+        // frame the transmitter refused is retried until it lands
+        int64_t waitMs = pacer.waitMs(remainingMs, ledRenderer.animated());
+
+        // Sleep until the next frame/toggle, or wake early when the delay changes
+        if (waitMs > 0 && ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(waitMs)) > 0) {
+            requestedDelay = blinkDelay.load();
+            delayChanged = true;
+            continue;
+        }
+
+        if (waitMs < remainingMs) {
+            if (pacer.frameDue(ledRenderer.animated())) pacer.sent(showLedFrame(ledState));
+            continue;
         }
+
+        int64_t nowUs = esp_timer_get_time();
+        int64_t periodUs = nowUs - lastToggleUs;
+        lastToggleUs = nowUs;
+
+        ledState = !ledState;
+        pacer.sent(showLedFrame(ledState));
+
+        // Periods cut short by a delay change are not jitter
+        if (!delayChanged) {
+            int64_t errorUs = periodUs - (int64_t)requestedDelay * 1000;
+            portENTER_CRITICAL(&ledJitterMux);
+            ledJitter.record((uint32_t)(errorUs < 0 ? -errorUs : errorUs));
+            portEXIT_CRITICAL(&ledJitterMux);
+        }
+
+        requestedDelay = blinkDelay.load();
+        delayChanged = false;
+    }
+}
+
+// Renders into the idle buffer and starts sending it, waiting up to
+// LED_SHOW_WAIT for the previous frame to finish. False when it could
+// not be sent; ledTask then retries it (see LedFramePacer).
+bool showLedFrame(bool blinkOn) {
+    LedFrameInput input = { (uint32_t)millis(), (uint32_t)blinkDelay.load(), blinkOn, latestTemperature.load() };
+
+    uint32_t start = Telemetry::nowUs();
+    ledRenderer.render(input, ledFrames[ledBackFrame], NUM_PIXELS);
+    telemetry.record(Stage::LedRender, start);
+
+    start = Telemetry::nowUs();
+    if (!ledOutput.show(ledFrames[ledBackFrame], sizeof(ledFrames[ledBackFrame]), LED_SHOW_WAIT)) return false;
+    telemetry.record(Stage::PixelShow, start);
+    ledBackFrame ^= 1;
+    return true;
+}
+
+// Solid colour, sent synchronously (boot test only)
+void showTestColor(Rgb color) {
+    LedRenderer solid(LedEffect::Blink, color, PIXEL_BRIGHTNESS);
+    LedFrameInput input = { 0, 0, true, NAN };
+    solid.render(input, ledFrames[0], NUM_PIXELS);
+    ledOutput.show(ledFrames[0], sizeof(ledFrames[0]));
+    ledOutput.wait();
+}
+
+void setBlinkDelay(int newDelay) {
+    blinkDelay.store(newDelay);
+    if (ledTaskHandle) xTaskNotifyGive(ledTaskHandle);
+}
+
+void reportLedJitter() {
+    portENTER_CRITICAL(&ledJitterMux);
+    Histogram<50> snapshot = ledJitter;
+    ledJitter.reset();
+    portEXIT_CRITICAL(&ledJitterMux);
+
+    if (snapshot.total() == 0) return;
+    Serial.printf("[LED] Jitter over %u toggles: mean %u us, p99 <%u us, max %u us, <1ms %.1f%%\n",
+                  (unsigned)snapshot.total(), (unsigned)snapshot.mean(),
+                  (unsigned)snapshot.percentile(99), (unsigned)snapshot.max(),
+                  100.0 * snapshot.countBelow(1000) / snapshot.total());
+}
+
+// Heap health: a falling minimum or shrinking largest block means fragmentation
+uint32_t minFreeHeap() {
+    return ESP.getMinFreeHeap();
+}
+
+uint32_t largestFreeBlock() {
+    return heap_caps_get_largest_free_block(MALLOC_CAP_8BIT);
+}
+
+void reportHeap() {
+    Serial.printf("[Heap] Free %u, min free %u, largest block %u\n",
+                  (unsigned)ESP.getFreeHeap(), (unsigned)minFreeHeap(), (unsigned)largestFreeBlock());
+}
+
+// Posts the stage histograms of the last window; dropped when offline
+void reportTelemetry() {
+    telemetry.takeSnapshot(telemetrySnapshot);
+    // Also dropped while the server asked us to back off
+    if (!wifiLink.connected() || uploadsThrottled(millis())) return;
+
+    size_t length = encodeTelemetryJson(telemetrySnapshot, deviceName, millis(), telemetry.probeOverheadNs(),
+                                        telemetryBuffer, sizeof(telemetryBuffer));
+    if (length == 0) {
+        Serial.println("[Telemetry] ❌ Report does not fit the buffer");
+        return;
     }
 
-    yield();
+    int httpCode = connection.post(API_URL_TELEMETRY, "application/json", (const uint8_t*)telemetryBuffer, length);
+    if (httpCode != 200 && httpCode != 201) {
+        Serial.printf("[Telemetry] ❌ HTTP %d\n", httpCode);
+    }
+    connection.end();
 }
 
 // ============================================
-// UPDATE LED
+// TIME
 // ============================================
-void updateLED() {
-    unsigned long currentMillis = millis();
-    if (currentMillis - lastBlinkTime >= (unsigned long)blinkDelay) {
-        lastBlinkTime = currentMillis;
-        ledState = !ledState;
-        pixel.setPixelColor(0, ledState ? pixel.Color(0, 150, 255) : pixel.Color(0, 0, 0));
-        pixel.show();
+// SNTP runs in the background and retries on its own until Wi-Fi is up
+void setupTimeSync() {
+    sntp_set_time_sync_notification_cb(onTimeSync);
+    configTime(0, 0, NTP_SERVER_1, NTP_SERVER_2);
+}
+
+void onTimeSync(struct timeval* tv) {
+    int64_t epochMs = (int64_t)tv->tv_sec * 1000 + tv->tv_usec / 1000;
+    uint32_t now = millis();
+
+    portENTER_CRITICAL(&deviceClockMux);
+    deviceClock.sync(epochMs, now);
+    uint32_t syncs = deviceClock.syncs();
+    portEXIT_CRITICAL(&deviceClockMux);
+
+    Serial.printf("[Time] ✅ SNTP sync #%u\n", (unsigned)syncs);
+}
+
+// Epoch ms at a millis() value, 0 before the first sync
+int64_t epochAt(uint32_t ms) {
+    portENTER_CRITICAL(&deviceClockMux);
+    int64_t epochMs = deviceClock.epochAt(ms);
+    portEXIT_CRITICAL(&deviceClockMux);
+    return epochMs;
+}
+
+// ============================================
+// RATE LIMITS
+// ============================================
+// Limits pushed by the server survive reboots; version 0 (nothing
+// stored) keeps the built-in defaults
+void loadRateLimits() {
+    RateLimits limits;
+    if (ratePrefs.begin(RATE_PREFS_NAMESPACE, true)) {
+        limits.version = ratePrefs.getUInt("version", 0);
+        limits.minSampleMs = ratePrefs.getUInt("min_sample", limits.minSampleMs);
+        limits.maxSampleMs = ratePrefs.getUInt("max_sample", limits.maxSampleMs);
+        limits.minUploadGapMs = ratePrefs.getUInt("min_upload", limits.minUploadGapMs);
+        ratePrefs.end();
+    }
+    applyRateLimits(limits);
+}
+
+void applyRateLimits(const RateLimits& limits) {
+    rateLimits = clampRateLimits(limits, DHT_MIN_INTERVAL, MAX_RATE_INTERVAL);
+    sampler.setLimits(rateLimits);
+    uploadThrottle.setMinGapMs(rateLimits.minUploadGapMs);
+    Serial.printf("[Rate] Limits v%lu: sample %lu-%lu ms, upload gap %lu ms\n",
+                  (unsigned long)rateLimits.version, (unsigned long)rateLimits.minSampleMs,
+                  (unsigned long)rateLimits.maxSampleMs, (unsigned long)rateLimits.minUploadGapMs);
+}
+
+// Only called when the version changes, so NVS sees few writes
+void storeRateLimits(const RateLimits& limits) {
+    if (!ratePrefs.begin(RATE_PREFS_NAMESPACE, false)) {
+        Serial.println("[Rate] ❌ NVS unavailable, limits kept until reboot");
+        return;
     }
+    ratePrefs.putUInt("version", limits.version);
+    ratePrefs.putUInt("min_sample", limits.minSampleMs);
+    ratePrefs.putUInt("max_sample", limits.maxSampleMs);
+    ratePrefs.putUInt("min_upload", limits.minUploadGapMs);
+    ratePrefs.end();
 }
 
 // ============================================
-// CONNECT TO WIFI
+// WIFI
 // ============================================
-void connectToWiFi() {
-    Serial.println("[WiFi] Connecting to: " + String(WIFI_SSID));
-    WiFi.disconnect(true, true);
-    delay(100);
+void setupWiFi() {
+    Serial.printf("[WiFi] Connecting to: %s\n", WIFI_SSID);
     WiFi.mode(WIFI_STA);
-    WiFi.begin(WIFI_SSID, WIFI_PASSWORD); // ✅ Now uses password
+    WiFi.setAutoReconnect(false);   // wifiLink owns reconnects
+    WiFi.onEvent(onWiFiEvent);
+    wifiLink.poll(millis());
+}
 
-    int attempts = 0;
-    while (WiFi.status() != WL_CONNECTED && attempts < 30) {
-        delay(300);
-        Serial.print(".");
-        attempts++;
-        updateLED();
+// Modem sleep between DTIM beacons, and let the power manager scale the
+// CPU clock (and light-sleep when the core was built with tickless idle)
+// while loop() and the other tasks are blocked
+void setupPowerSaving() {
+    WiFi.setSleep(WIFI_PS_MIN_MODEM);
+
+#if CONFIG_PM_ENABLE
+    esp_pm_config_esp32s3_t pm = {};
+    pm.max_freq_mhz = 240;
+    pm.min_freq_mhz = 80;
+#if CONFIG_FREERTOS_USE_TICKLESS_IDLE
+    pm.light_sleep_enable = true;
+#endif
+    esp_err_t err = esp_pm_configure(&pm);
+    if (err != ESP_OK) {
+        Serial.printf("[Power] ❌ esp_pm_configure failed: %d\n", err);
     }
+#endif
+}
 
-    if (WiFi.status() == WL_CONNECTED) {
-        wifiConnected = true;
-        Serial.println("\n✅ WiFi connected! IP: " + WiFi.localIP().toString());
-    } else {
-        wifiConnected = false;
-        Serial.println("\n❌ WiFi connection failed!");
-        Serial.print("[WiFi] Status code: ");
-        Serial.println(WiFi.status());
+void onWiFiEvent(WiFiEvent_t event) {
+    switch (event) {
+        case ARDUINO_EVENT_WIFI_STA_GOT_IP:
+            wifiLink.onConnected();
+            break;
+        case ARDUINO_EVENT_WIFI_STA_DISCONNECTED:
+        case ARDUINO_EVENT_WIFI_STA_LOST_IP:
+            wifiLink.onDisconnected();
+            break;
+        default:
+            return;
+    }
+    // Run wifiStep now instead of at its next deadline
+    if (loopTaskHandle) xTaskNotifyGive(loopTaskHandle);
+}
+
+void ArduinoWiFiDriver::begin() {
+    connection.reset();
+    wifiSessions++;
+    WiFi.begin(WIFI_SSID, WIFI_PASSWORD);
+}
+
+void ArduinoWiFiDriver::disconnect() {
+    WiFi.disconnect();
+}
+
+void logWiFiState() {
+    using State = WiFiReconnect<ArduinoWiFiDriver>::State;
+    State state = wifiLink.state();
+    if (state == lastWifiState) return;
+    lastWifiState = state;
+
+    switch (state) {
+        case State::Connected:
+            Serial.print("[WiFi] ✅ Connected! IP: ");
+            Serial.println(WiFi.localIP());
+            break;
+        case State::Backoff:
+            Serial.printf("[WiFi] ❌ Attempt failed (%u in a row), retrying in %lu ms\n",
+                          (unsigned)wifiLink.failures(), (unsigned long)(wifiLink.retryAtMs() - millis()));
+            break;
+        case State::Connecting:
+            Serial.printf("[WiFi] Attempt %u...\n", (unsigned)wifiLink.attempts());
+            break;
+        default:
+            break;
     }
 }
 
 // ============================================
 // SEND SENSOR DATA
 // ============================================
-void sendSensorData() {
-    float humidity = dht.readHumidity();
-    float temperature = dht.readTemperature();
-
-    if (isnan(humidity) || isnan(temperature)) {
-        Serial.println("[Sensor] Failed to read from DHT22");
+void sendSensorData(const DhtFrame& frame) {
+    if (frame.status != DhtStatus::Ok) {
+        Serial.printf("[Sensor] DHT22 frame dropped (%s)\n",
+                      frame.status == DhtStatus::Checksum ? "checksum" : "timeout");
         return;
     }
 
-    bool tempChanged = abs(temperature - lastTemperature) >= CHANGE_THRESHOLD;
-    bool humidChanged = abs(humidity - lastHumidity) >= CHANGE_THRESHOLD;
+    // Raw values: the median filter lags several samples at long intervals
+    const float raw[2] = { frame.temperature, frame.humidity };
+    sampler.onSample(millis(), raw);
 
-    if (tempChanged || humidChanged || lastTemperature == 0) {
-        Serial.printf("[Sensor] Sending: T=%.1f°C, H=%.1f%%\n", temperature, humidity);
+    float temperature = temperatureFilter.add(frame.temperature);
+    float humidity = humidityFilter.add(frame.humidity);
+    latestTemperature.store(temperature);
 
-        StaticJsonDocument<128> jsonDoc;
-        jsonDoc["temperature"] = round(temperature * 100) / 100.0;
-        jsonDoc["humidity"] = round(humidity * 100) / 100.0;
+    SwingingDoor<2>::Sample sample = { (uint32_t)millis(), { temperature, humidity } };
+    SwingingDoor<2>::Sample kept;
 
-        String jsonString;
-        serializeJson(jsonDoc, jsonString);
+    if (trendCompressor.offer(sample, kept)) {
+        Serial.printf("[Sensor] Queued: T=%.1f°C, H=%.1f%%\n", kept.values[0], kept.values[1]);
 
-        httpSensor.begin(secureClient, API_URL_SENSOR);
-        httpSensor.addHeader("Content-Type", "application/json");
-        httpSensor.addHeader("Content-Length", String(jsonString.length()));
-
-        int httpCode = httpSensor.POST(jsonString);
-        String response = httpSensor.getString();
-        httpSensor.end();
-
-        if (httpCode == 200 || httpCode == 201) {
-            Serial.println("[Sensor] ✅ Success!");
-            lastTemperature = temperature;
-            lastHumidity = humidity;
-        } else {
-            Serial.printf("[Sensor] ❌ HTTP %d: %s\n", httpCode, response.c_str());
+        Reading reading = { kept.values[0], kept.values[1], kept.timeMs, epochAt(kept.timeMs) };
+        if (!readingBuffer.push(reading)) {
+            Serial.println("[Sensor] ⚠️ Buffer full, oldest reading dropped");
         }
     } else {
-        Serial.println("[Sensor] No significant change");
+        Serial.println("[Sensor] On trend, not queued");
     }
 }
 
 // ============================================
-// FETCH DELAY FROM API
+// FLUSH QUEUED READINGS
 // ============================================
-void fetchDelayFromAPI() {
-    httpDelay.begin(secureClient, API_URL_DELAY);
-    httpDelay.addHeader("Content-Type", "application/json");
-
-    int httpCode = httpDelay.GET();
-
-    if (httpCode == HTTP_CODE_OK) {
-        String payload = httpDelay.getString();
-        Serial.print("[Delay] Raw response: ");
-        Serial.println(payload); // ← LOG RAW RESPONSE
+// True while the server's Retry-After or our backoff is running
+bool uploadsThrottled(uint32_t nowMs) {
+    return !uploadThrottle.allowed(nowMs);
+}
 
-        StaticJsonDocument<256> doc;
-        DeserializationError error = deserializeJson(doc, payload);
+void flushReadings() {
+    size_t count = min(readingBuffer.size(), BATCH_SIZE);
+    if (count == 0) return;
 
-        if (!error) {
-            int newDelay = doc["delay"].as<int>();
-            newDelay = max(MIN_DELAY, min(MAX_DELAY, newDelay));
+    // Older readings are still in the log: queue behind them to keep order.
+    // A throttled batch waits there too and drains once uploads resume.
+    if (!wifiLink.connected() || uploadsThrottled(millis()) || (readingLogReady && !readingLog.empty())) {
+        spillToLog(count);
+        return;
+    }
 
-            Serial.print("[Delay] Received: ");
-            Serial.print(newDelay);
-            Serial.println("ms");
+    for (size_t i = 0; i < count; i++) uploadBatch[i] = readingBuffer.at(i);
+    if (uploadReadings(uploadBatch, count) == UploadOutcome::Retry) {
+        spillToLog(count);
+    } else {
+        readingBuffer.drop(count);
+    }
+}
 
-            if (newDelay != blinkDelay) {
-                Serial.println("\n★ DELAY CHANGED!");
-                blinkDelay = newDelay;
-            }
-        } else {
-            Serial.println("[Delay] JSON parse failed");
+// Delivered and Rejected batches are done with; only Retry keeps them
+UploadOutcome uploadReadings(const Reading* batch, size_t count) {
+    Serial.printf("[Sensor] Uploading batch of %u readings\n", (unsigned)count);
+
+    int httpCode = USE_BINARY_UPLOADS ? postBinaryBatch(batch, count) : postJsonBatch(batch, count);
+    // A batch that doesn't encode never will
+    UploadOutcome outcome = httpCode == HTTPC_ERROR_TOO_LESS_RAM ? UploadOutcome::Rejected : uploadOutcome(httpCode);
+    uint32_t now = millis();
+    uploadThrottle.onResult(now, httpCode, connection.retryAfterMs());
+
+    if (outcome == UploadOutcome::Delivered) {
+        Serial.println("[Sensor] ✅ Success!");
+        uploadSequence++;
+        // Uploads and the delay long-poll each hold a connection, so
+        // expect two handshakes per Wi-Fi session
+        Serial.printf("[HTTP] Handshakes: %u, reused: %u (delay long-poll: %u, %u)\n",
+                      (unsigned)connection.handshakes(), (unsigned)connection.reusedRequests(),
+                      (unsigned)controlConnection.handshakes(), (unsigned)controlConnection.reusedRequests());
+
+        // The response may carry new rate limits
+        RateLimits pushed = rateLimits;
+        if (!parseRateLimitsJson(connection.body(), pushed) && pushed.version != rateLimits.version) {
+            applyRateLimits(pushed);
+            storeRateLimits(rateLimits);
         }
     } else {
-        Serial.printf("[Delay] HTTP Error: %d\n", httpCode);
+        if (httpCode > 0) connection.readBody(errorBody, sizeof(errorBody));
+        Serial.printf("[Sensor] ❌ HTTP %d: %s\n", httpCode, httpCode > 0 ? errorBody : "");
+        if (outcome == UploadOutcome::Rejected) {
+            rejectedReadings += count;
+            Serial.printf("[Sensor] 🗑 Batch refused, %u readings dropped (%lu in total)\n",
+                          (unsigned)count, (unsigned long)rejectedReadings);
+        }
+        if (uploadsThrottled(now)) {
+            Serial.printf("[Sensor] ⏸ Uploads paused for %lu ms\n",
+                          (unsigned long)(uploadThrottle.resumeAtMs() - now));
+        }
     }
+    connection.end();
+    return outcome;
+}
 
-    httpDelay.end();
+// ============================================
+// STORE AND FORWARD
+// ============================================
+void spillToLog(size_t count) {
+    if (!readingLogReady) return;   // keep them in RAM instead
+
+    size_t saved = 0;
+    while (saved < count && readingLog.append(readingBuffer.at(saved))) saved++;
+    readingBuffer.drop(saved);
+    Serial.printf("[Log] Saved %u readings offline (%u waiting)\n",
+                  (unsigned)saved, (unsigned)readingLog.size());
 }
 
+void drainReadingLog() {
+    // A refused batch is consumed too, or it would block the log for good
+    size_t count = readingLog.peek(uploadBatch, BATCH_SIZE);
+    if (count > 0 && uploadReadings(uploadBatch, count) == UploadOutcome::Retry) return;
 
+    readingLog.consume();
+    Serial.printf("[Log] Drained %u readings (%u waiting, %u lost)\n",
+                  (unsigned)count, (unsigned)readingLog.size(), (unsigned)readingLog.lost());
+}
 
+int postBinaryBatch(const Reading* batch, size_t count) {
+    WireEncoder encoder(uploadBuffer, sizeof(uploadBuffer), deviceId, uploadSequence);
+    for (size_t i = 0; i < count; i++) {
+        encoder.add(batch[i].temperature, batch[i].humidity, batch[i].epochMs);
+    }
+    if (encoder.length() == 0) {
+        Serial.println("[Sensor] ❌ Batch does not fit the upload buffer");
+        return HTTPC_ERROR_TOO_LESS_RAM;
+    }
+    return connection.post(API_URL_SENSOR, WIRE_CONTENT_TYPE, uploadBuffer, encoder.length());
+}
+
+int postJsonBatch(const Reading* batch, size_t count) {
+    size_t length = encodeJsonBatch<BATCH_SIZE>(batch, count, (char*)uploadBuffer, sizeof(uploadBuffer));
+    if (length == 0) {
+        Serial.println("[Sensor] ❌ Batch does not fit the upload buffer");
+        return HTTPC_ERROR_TOO_LESS_RAM;
+    }
+    return connection.post(API_URL_SENSOR, "application/json", uploadBuffer, length);
+}
+
+// ============================================
+// DELAY WATCH TASK
+// ============================================
+void delayWatchTask(void* param) {
+    uint32_t session = wifiSessions.load();
+    for (;;) {
+        bool ok = false;
+        if (wifiLink.connected()) {
+            // The socket from before a reconnect is dead; reusing it
+            // would only fail after the full long-poll timeout
+            uint32_t current = wifiSessions.load();
+            if (current != session) {
+                controlConnection.reset();
+                session = current;
+            }
+            ok = fetchDelayFromAPI();
+        }
+        // A long-poll returns on change or timeout; re-arm immediately,
+        // only back off when the request itself failed (longer if the
+        // server sent Retry-After)
+        if (!ok) {
+            uint32_t waitMs = max((uint32_t)DELAY_RETRY_INTERVAL, controlConnection.retryAfterMs());
+            vTaskDelay(pdMS_TO_TICKS(waitMs));
+        }
+    }
+}
 
+// ============================================
+// FETCH DELAY FROM API
+// ============================================
+bool fetchDelayFromAPI() {
+    int newDelay = blinkDelay.load();
+    if (!delayWatcher.poll(newDelay)) return false;
 
+    if (newDelay != blinkDelay.load()) {
+        Serial.println("\n★ DELAY CHANGED!");
+        setBlinkDelay(newDelay);
+    }
+    return true;
+}
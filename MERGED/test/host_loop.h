@@ -0,0 +1,157 @@
+// ============================================
+// HOST LOOP
+// The sensor path of src/main.cpp (sensorStep -> sendSensorData
+// -> flushReadings -> post) rebuilt on the native shims, for the
+// loop tests and the loop() benchmark. Constants match main.cpp;
+// the DHT shim stands in for the RMT capture and HTTPClient for
+// the connection, the offline log is left out.
+// ============================================
+
+#pragma once
+
+#include <Arduino.h>
+#include <DHT.h>
+#include <HTTPClient.h>
+
+#include "device_clock.h"
+#include "json_codec.h"
+#include "rate_controller.h"
+#include "reading_buffer.h"
+#include "sample_filter.h"
+#include "scheduler.h"
+#include "swinging_door.h"
+#include "wire_format.h"
+
+class HostLoop {
+public:
+    static const size_t BATCH_SIZE = 10;
+    static const size_t BATCH_CAPACITY = 60;
+    static const uint32_t BATCH_MAX_AGE = 20000;
+    static const uint32_t DHT_MIN_INTERVAL = 2000;
+    static const uint32_t MAX_SILENCE = 300000;
+    static const uint32_t MAX_IDLE = 1000;
+    static const size_t UPLOAD_BUFFER_SIZE = jsonBatchMaxSize(BATCH_SIZE);
+
+    // Epoch of the fake clock's zero, as if SNTP had synced at boot
+    static const int64_t BOOT_EPOCH_MS = 1790000000000LL;
+
+    explicit HostLoop(bool binaryUploads)
+        : _binary(binaryUploads),
+          _sampler(ERROR_BOUNDS, RateLimits()),
+          _door(ERROR_BOUNDS, MAX_SILENCE),
+          _buffer(BATCH_SIZE, BATCH_MAX_AGE) {
+        _current = this;
+        _clock.sync(BOOT_EPOCH_MS, 0);
+        _dht.begin();
+        _sensorJob = _scheduler.once(sensorStep);
+        _scheduler.at(_sensorJob, millis() + _sampler.intervalMs());
+    }
+
+    // One pass of loop() without the idle wait
+    size_t loopBody() { return _scheduler.runDue(millis()); }
+
+    // loop() for ms of fake time: run what is due, sleep to the next deadline
+    void run(uint32_t ms) {
+        uint32_t end = millis() + ms;
+        while ((int32_t)(end - millis()) > 0) {
+            loopBody();
+            uint32_t idle = _scheduler.idleTime(millis(), MAX_IDLE);
+            uint32_t left = end - millis();
+            FakeClock::advanceMs(idle == 0 ? 1 : (idle < left ? idle : left));
+        }
+    }
+
+    uint32_t samples() const { return _samples; }
+    uint32_t queued() const { return _queued; }
+    uint32_t uploads() const { return _uploads; }
+    uint32_t failedUploads() const { return _failed; }
+    uint32_t rejectedReadings() const { return _rejected; }
+    size_t waiting() const { return _buffer.size(); }
+    uint32_t sampleIntervalMs() const { return _sampler.intervalMs(); }
+    const UploadThrottle& throttle() const { return _throttle; }
+
+private:
+    static void sensorStep(uint32_t nowMs) { _current->sense(nowMs); }
+
+    void sense(uint32_t nowMs) {
+        float temperature = _dht.readTemperature();
+        float humidity = _dht.readHumidity();
+        if (isnan(temperature) || isnan(humidity)) {
+            _scheduler.at(_sensorJob, nowMs + DHT_MIN_INTERVAL);
+            return;
+        }
+        _samples++;
+
+        const float raw[2] = { temperature, humidity };
+        _sampler.onSample(nowMs, raw);
+
+        SwingingDoor<2>::Sample sample = { nowMs, { _temperatureFilter.add(temperature), _humidityFilter.add(humidity) } };
+        SwingingDoor<2>::Sample kept;
+        if (_door.offer(sample, kept)) {
+            Reading reading = { kept.values[0], kept.values[1], kept.timeMs, _clock.epochAt(kept.timeMs) };
+            _buffer.push(reading);
+            _queued++;
+        }
+
+        _scheduler.at(_sensorJob, nowMs + _sampler.intervalMs());
+        if (_buffer.shouldFlush(nowMs)) flush(nowMs);
+    }
+
+    void flush(uint32_t nowMs) {
+        if (!_throttle.allowed(nowMs)) return;   // stays queued in RAM
+        size_t count = _buffer.size() < BATCH_SIZE ? _buffer.size() : BATCH_SIZE;
+        for (size_t i = 0; i < count; i++) _batch[i] = _buffer.at(i);
+
+        size_t length;
+        if (_binary) {
+            WireEncoder encoder(_uploadBuffer, sizeof(_uploadBuffer), 0x5eed, _uploads);
+            for (size_t i = 0; i < count; i++) encoder.add(_batch[i].temperature, _batch[i].humidity, _batch[i].epochMs);
+            length = encoder.length();
+        } else {
+            length = encodeJsonBatch<BATCH_SIZE>(_batch, count, (char*)_uploadBuffer, sizeof(_uploadBuffer));
+        }
+        if (length == 0) {
+            _failed++;
+            return;
+        }
+
+        int httpCode = _http.POST(_uploadBuffer, length);
+        const char* retryAfter = _http.header("Retry-After");
+        _throttle.onResult(nowMs, httpCode, parseRetryAfterMs(retryAfter));
+        UploadOutcome outcome = uploadOutcome(httpCode);
+        if (outcome == UploadOutcome::Delivered) {
+            _buffer.drop(count);
+            _uploads++;
+        } else {
+            _failed++;
+            if (outcome == UploadOutcome::Rejected) {
+                _buffer.drop(count);
+                _rejected += count;
+            }
+        }
+        _http.end();
+    }
+
+    static constexpr float ERROR_BOUNDS[2] = { 0.1f, 0.1f };
+    static inline HostLoop* _current = nullptr;
+
+    bool _binary;
+    DHT _dht{ 38, DHT22 };
+    HTTPClient _http;
+    DeviceClock _clock;
+    SampleFilter<5> _temperatureFilter{ 0.5f };
+    SampleFilter<5> _humidityFilter{ 0.5f };
+    AdaptiveSampler<2> _sampler;
+    SwingingDoor<2> _door;
+    UploadThrottle _throttle;
+    ReadingBuffer<BATCH_CAPACITY> _buffer;
+    Scheduler<3> _scheduler;
+    int _sensorJob = Scheduler<3>::NO_JOB;
+    uint8_t _uploadBuffer[UPLOAD_BUFFER_SIZE];
+    Reading _batch[BATCH_SIZE];
+    uint32_t _samples = 0;
+    uint32_t _queued = 0;
+    uint32_t _uploads = 0;
+    uint32_t _failed = 0;
+    uint32_t _rejected = 0;
+};
@@ -0,0 +1,163 @@
+// Host tests of the DHT22 decoder on recorded pulse-width captures and
+// of the median/EMA filter behind it (pio test -e native -f test_dht22_decoder)
+#include <unity.h>
+
+#include <string.h>
+
+#include "dht22_decoder.h"
+#include "sample_filter.h"
+
+// Captures as Dht22Reader hands them over: the tail of the host's
+// release, the 80/80 us response, 40 bits with the usual few us of
+// jitter, the closing low and the RMT end marker (zero duration,
+// idle level)
+
+// 65.2 %RH, 23.1 °C (02 8c 00 e7, checksum 75)
+const DhtLevel CAPTURE_ROOM[] = {
+    { 1, 31 }, { 0, 84 }, { 1, 86 }, { 0, 54 }, { 1, 29 }, { 0, 55 }, { 1, 25 }, { 0, 49 },
+    { 1, 30 }, { 0, 54 }, { 1, 24 }, { 0, 48 }, { 1, 29 }, { 0, 51 }, { 1, 24 }, { 0, 48 },
+    { 1, 75 }, { 0, 47 }, { 1, 28 }, { 0, 54 }, { 1, 69 }, { 0, 56 }, { 1, 22 }, { 0, 55 },
+    { 1, 23 }, { 0, 47 }, { 1, 22 }, { 0, 50 }, { 1, 70 }, { 0, 56 }, { 1, 67 }, { 0, 54 },
+    { 1, 27 }, { 0, 54 }, { 1, 25 }, { 0, 55 }, { 1, 25 }, { 0, 51 }, { 1, 29 }, { 0, 47 },
+    { 1, 23 }, { 0, 54 }, { 1, 26 }, { 0, 53 }, { 1, 30 }, { 0, 48 }, { 1, 26 }, { 0, 52 },
+    { 1, 25 }, { 0, 55 }, { 1, 26 }, { 0, 47 }, { 1, 68 }, { 0, 56 }, { 1, 68 }, { 0, 53 },
+    { 1, 68 }, { 0, 51 }, { 1, 28 }, { 0, 48 }, { 1, 22 }, { 0, 47 }, { 1, 70 }, { 0, 50 },
+    { 1, 67 }, { 0, 54 }, { 1, 73 }, { 0, 53 }, { 1, 28 }, { 0, 48 }, { 1, 70 }, { 0, 51 },
+    { 1, 72 }, { 0, 48 }, { 1, 71 }, { 0, 52 }, { 1, 22 }, { 0, 53 }, { 1, 68 }, { 0, 49 },
+    { 1, 25 }, { 0, 48 }, { 1, 67 }, { 0, 48 }, { 1, 0 },
+};
+
+// 35.0 %RH, -10.1 °C (01 5e 80 65, checksum 44)
+const DhtLevel CAPTURE_FREEZER[] = {
+    { 1, 31 }, { 0, 84 }, { 1, 85 }, { 0, 49 }, { 1, 30 }, { 0, 50 }, { 1, 29 }, { 0, 55 },
+    { 1, 25 }, { 0, 49 }, { 1, 28 }, { 0, 53 }, { 1, 23 }, { 0, 53 }, { 1, 28 }, { 0, 50 },
+    { 1, 22 }, { 0, 51 }, { 1, 71 }, { 0, 47 }, { 1, 25 }, { 0, 49 }, { 1, 73 }, { 0, 56 },
+    { 1, 23 }, { 0, 47 }, { 1, 69 }, { 0, 50 }, { 1, 74 }, { 0, 51 }, { 1, 67 }, { 0, 56 },
+    { 1, 72 }, { 0, 51 }, { 1, 28 }, { 0, 48 }, { 1, 68 }, { 0, 48 }, { 1, 25 }, { 0, 56 },
+    { 1, 25 }, { 0, 47 }, { 1, 27 }, { 0, 52 }, { 1, 29 }, { 0, 49 }, { 1, 29 }, { 0, 56 },
+    { 1, 24 }, { 0, 53 }, { 1, 24 }, { 0, 49 }, { 1, 26 }, { 0, 50 }, { 1, 70 }, { 0, 50 },
+    { 1, 69 }, { 0, 55 }, { 1, 25 }, { 0, 53 }, { 1, 29 }, { 0, 56 }, { 1, 68 }, { 0, 53 },
+    { 1, 22 }, { 0, 48 }, { 1, 68 }, { 0, 47 }, { 1, 30 }, { 0, 51 }, { 1, 70 }, { 0, 53 },
+    { 1, 26 }, { 0, 53 }, { 1, 29 }, { 0, 51 }, { 1, 30 }, { 0, 49 }, { 1, 68 }, { 0, 49 },
+    { 1, 25 }, { 0, 54 }, { 1, 30 }, { 0, 49 }, { 1, 0 },
+};
+
+const size_t ROOM_LEVELS = sizeof(CAPTURE_ROOM) / sizeof(CAPTURE_ROOM[0]);
+const size_t FREEZER_LEVELS = sizeof(CAPTURE_FREEZER) / sizeof(CAPTURE_FREEZER[0]);
+
+void setUp() {}
+void tearDown() {}
+
+void test_decodes_room_capture() {
+    DhtFrame frame = decodeDht22(CAPTURE_ROOM, ROOM_LEVELS);
+    TEST_ASSERT_TRUE(frame.status == DhtStatus::Ok);
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 65.2f, frame.humidity);
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 23.1f, frame.temperature);
+}
+
+void test_decodes_negative_temperature() {
+    DhtFrame frame = decodeDht22(CAPTURE_FREEZER, FREEZER_LEVELS);
+    TEST_ASSERT_TRUE(frame.status == DhtStatus::Ok);
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 35.0f, frame.humidity);
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, -10.1f, frame.temperature);
+}
+
+void test_capture_without_handshake() {
+    // The receiver started late and only saw the data bits
+    DhtFrame frame = decodeDht22(CAPTURE_ROOM + 3, ROOM_LEVELS - 3);
+    TEST_ASSERT_TRUE(frame.status == DhtStatus::Ok);
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 23.1f, frame.temperature);
+}
+
+void test_capture_without_end_marker() {
+    DhtFrame frame = decodeDht22(CAPTURE_ROOM, ROOM_LEVELS - 1);
+    TEST_ASSERT_TRUE(frame.status == DhtStatus::Ok);
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 65.2f, frame.humidity);
+}
+
+void test_flipped_bit_fails_checksum() {
+    DhtLevel capture[ROOM_LEVELS];
+    memcpy(capture, CAPTURE_ROOM, sizeof(capture));
+    capture[4].durationUs = 70;             // first humidity bit 0 -> 1
+    TEST_ASSERT_TRUE(decodeDht22(capture, ROOM_LEVELS).status == DhtStatus::Checksum);
+
+    memcpy(capture, CAPTURE_ROOM, sizeof(capture));
+    capture[ROOM_LEVELS - 3].durationUs = 26;   // last checksum bit 1 -> 0
+    TEST_ASSERT_TRUE(decodeDht22(capture, ROOM_LEVELS).status == DhtStatus::Checksum);
+}
+
+void test_lost_edge_is_rejected() {
+    // One bit missing shifts the rest of the frame
+    DhtLevel capture[ROOM_LEVELS];
+    size_t n = 0;
+    for (size_t i = 0; i < ROOM_LEVELS; i++) {
+        if (i == 41 || i == 42) continue;
+        capture[n++] = CAPTURE_ROOM[i];
+    }
+    TEST_ASSERT_FALSE(decodeDht22(capture, n).status == DhtStatus::Ok);
+}
+
+void test_truncated_capture_is_too_short() {
+    TEST_ASSERT_TRUE(decodeDht22(CAPTURE_ROOM, 60).status == DhtStatus::TooShort);
+    TEST_ASSERT_TRUE(decodeDht22(CAPTURE_ROOM, 0).status == DhtStatus::TooShort);
+    // 39 data bits and the end marker
+    TEST_ASSERT_TRUE(decodeDht22(CAPTURE_ROOM + 5, ROOM_LEVELS - 5).status == DhtStatus::TooShort);
+}
+
+void test_median_rejects_single_glitch() {
+    SampleFilter<5> filter(1.0f);           // median only
+    const float raw[] = { 21.0f, 21.1f, 85.0f, 21.2f, 21.1f, -40.0f, 21.0f };
+    for (float v : raw) {
+        float out = filter.add(v);
+        TEST_ASSERT_FLOAT_WITHIN(0.5f, 21.1f, out);
+    }
+}
+
+void test_median_of_partial_window() {
+    SampleFilter<5> filter(1.0f);
+    TEST_ASSERT_FALSE(filter.ready());
+    TEST_ASSERT_EQUAL_FLOAT(20.0f, filter.add(20.0f));
+    TEST_ASSERT_EQUAL_FLOAT(21.0f, filter.add(22.0f));      // mean of the middle two
+    TEST_ASSERT_EQUAL_FLOAT(22.0f, filter.add(30.0f));
+    TEST_ASSERT_EQUAL_size_t(3, filter.count());
+}
+
+void test_ema_converges_on_step() {
+    SampleFilter<5> filter(0.5f);
+    for (int i = 0; i < 10; i++) filter.add(20.0f);
+    TEST_ASSERT_EQUAL_FLOAT(20.0f, filter.value());
+
+    // The median holds the old level for two samples, then the
+    // average halves the gap every sample
+    float out[8];
+    for (int i = 0; i < 8; i++) out[i] = filter.add(24.0f);
+    TEST_ASSERT_EQUAL_FLOAT(20.0f, out[1]);
+    TEST_ASSERT_EQUAL_FLOAT(22.0f, out[2]);
+    TEST_ASSERT_EQUAL_FLOAT(23.0f, out[3]);
+    for (int i = 3; i < 7; i++) TEST_ASSERT_TRUE(out[i + 1] > out[i]);
+    TEST_ASSERT_FLOAT_WITHIN(0.1f, 24.0f, out[7]);
+}
+
+void test_reset_forgets_history() {
+    SampleFilter<5> filter(0.5f);
+    for (int i = 0; i < 5; i++) filter.add(30.0f);
+    filter.reset();
+    TEST_ASSERT_FALSE(filter.ready());
+    TEST_ASSERT_EQUAL_FLOAT(18.0f, filter.add(18.0f));
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_decodes_room_capture);
+    RUN_TEST(test_decodes_negative_temperature);
+    RUN_TEST(test_capture_without_handshake);
+    RUN_TEST(test_capture_without_end_marker);
+    RUN_TEST(test_flipped_bit_fails_checksum);
+    RUN_TEST(test_lost_edge_is_rejected);
+    RUN_TEST(test_truncated_capture_is_too_short);
+    RUN_TEST(test_median_rejects_single_glitch);
+    RUN_TEST(test_median_of_partial_window);
+    RUN_TEST(test_ema_converges_on_step);
+    RUN_TEST(test_reset_forgets_history);
+    return UNITY_END();
+}
@@ -0,0 +1,247 @@
+// Host tests of the LED frame renderer: frames compared byte for byte
+// with what Adafruit_NeoPixel would hold, and with a float reference of
+// the gamma and waveform curves, and the frame pacing that keeps a Blink
+// edge from being dropped (pio test -e native -f test_led_effects)
+#include <unity.h>
+
+#include <Adafruit_NeoPixel.h>
+#include <math.h>
+
+#include "led_effects.h"
+
+const size_t STRIP = 300;
+
+uint8_t frame[STRIP * 3];
+
+// Same GRB value computed in floats instead of from the tables
+uint8_t reference(uint8_t channel, uint8_t level, uint8_t brightness) {
+    float perceived = floorf(channel * level * brightness / (255.0f * 255.0f)) / 255.0f;
+    return (uint8_t)(powf(perceived, 2.2f) * 255.0f + 0.5f);
+}
+
+void assertPixel(const uint8_t* px, Rgb color, uint8_t level, uint8_t brightness) {
+    TEST_ASSERT_INT_WITHIN(1, reference(color.g, level, brightness), px[0]);
+    TEST_ASSERT_INT_WITHIN(1, reference(color.r, level, brightness), px[1]);
+    TEST_ASSERT_INT_WITHIN(1, reference(color.b, level, brightness), px[2]);
+}
+
+void setUp() {
+    memset(frame, 0xAA, sizeof(frame));
+}
+
+void tearDown() {}
+
+void test_full_on_matches_neopixel_buffer() {
+    // At full level and brightness gamma is the identity for 0 and 255,
+    // so the frame must equal the library's own GRB buffer
+    const Rgb colors[] = { { 255, 0, 0 }, { 0, 255, 0 }, { 0, 0, 255 }, { 255, 255, 0 }, { 255, 255, 255 } };
+    for (Rgb color : colors) {
+        Adafruit_NeoPixel strip(STRIP, 48, NEO_GRB + NEO_KHZ800);
+        for (uint16_t i = 0; i < STRIP; i++) strip.setPixelColor(i, Adafruit_NeoPixel::Color(color.r, color.g, color.b));
+
+        LedRenderer renderer(LedEffect::Blink, color, 255);
+        renderer.render({ 0, 500, true, NAN }, frame, STRIP);
+        TEST_ASSERT_EQUAL_MEMORY(strip.getPixels(), frame, STRIP * 3);
+    }
+}
+
+void test_blink_off_matches_cleared_strip() {
+    Adafruit_NeoPixel strip(STRIP, 48, NEO_GRB + NEO_KHZ800);
+    strip.clear();
+
+    LedRenderer renderer(LedEffect::Blink, { 0, 150, 255 }, 150);
+    renderer.render({ 1234, 500, false, NAN }, frame, STRIP);
+    TEST_ASSERT_EQUAL_MEMORY(strip.getPixels(), frame, STRIP * 3);
+}
+
+void test_blink_on_is_gamma_corrected() {
+    const Rgb color = { 0, 150, 255 };
+    LedRenderer renderer(LedEffect::Blink, color, 150);
+    renderer.render({ 0, 500, true, NAN }, frame, STRIP);
+    for (size_t i = 0; i < STRIP; i++) assertPixel(frame + i * 3, color, 255, 150);
+}
+
+void test_breathe_follows_the_wave() {
+    const Rgb color = { 0, 150, 255 };
+    const uint32_t period = 500;
+    LedRenderer renderer(LedEffect::Breathe, color, 255);
+
+    // One breath lasts two blink periods: dark, full at half way, dark again
+    const uint32_t times[] = { 0, 250, 500, 750, 999, 1000 };
+    for (uint32_t t : times) {
+        renderer.render({ t, period, true, NAN }, frame, STRIP);
+        uint8_t phase = (uint8_t)((t % (period * 2)) * 256 / (period * 2));
+        uint8_t level = (uint8_t)((1.0f - cosf(phase * 6.2831853f / 256.0f)) * 0.5f * 255.0f + 0.5f);
+        assertPixel(frame, color, level, 255);
+        // Every pixel of a breathing strip is the same
+        for (size_t i = 1; i < STRIP; i++) TEST_ASSERT_EQUAL_MEMORY(frame, frame + i * 3, 3);
+    }
+
+    renderer.render({ 0, period, true, NAN }, frame, 1);
+    TEST_ASSERT_EQUAL_UINT8(0, frame[2]);
+    renderer.render({ period, period, true, NAN }, frame, 1);
+    TEST_ASSERT_EQUAL_UINT8(255, frame[2]);
+}
+
+void test_wave_travels_along_the_strip() {
+    // 256 pixels: one table step per pixel; a 10 ms step of a 2560 ms
+    // cycle moves the wave by one pixel
+    const size_t pixels = 256;
+    const uint32_t period = 1280;
+    LedRenderer renderer(LedEffect::Wave, { 255, 255, 255 }, 255);
+    static uint8_t before[256 * 3];
+
+    renderer.render({ 0, period, true, NAN }, before, pixels);
+    for (uint32_t shift = 1; shift <= 5; shift++) {
+        renderer.render({ shift * 10, period, true, NAN }, frame, pixels);
+        for (size_t i = 0; i + shift < pixels; i++) {
+            TEST_ASSERT_EQUAL_MEMORY(before + (i + shift) * 3, frame + i * 3, 3);
+        }
+    }
+}
+
+void test_wave_spans_one_period() {
+    LedRenderer renderer(LedEffect::Wave, { 0, 0, 255 }, 255);
+    renderer.render({ 0, 500, true, NAN }, frame, STRIP);
+
+    // Dark at both ends, rising to full in the middle and falling again
+    TEST_ASSERT_EQUAL_UINT8(0, frame[2]);
+    TEST_ASSERT_LESS_THAN(3, frame[(STRIP - 1) * 3 + 2]);
+    TEST_ASSERT_EQUAL_UINT8(255, frame[(STRIP / 2) * 3 + 2]);
+    for (size_t i = 1; i <= STRIP / 2; i++) TEST_ASSERT_TRUE(frame[i * 3 + 2] >= frame[(i - 1) * 3 + 2]);
+    for (size_t i = STRIP / 2 + 1; i < STRIP; i++) TEST_ASSERT_TRUE(frame[i * 3 + 2] <= frame[(i - 1) * 3 + 2]);
+}
+
+void test_temperature_bands_pick_colour() {
+    LedRenderer renderer(LedEffect::TemperatureBands, { 0, 0, 0 }, 255);
+    const struct { float celsius; Rgb color; } cases[] = {
+        { -10.0f, { 0, 80, 255 } },
+        { 17.9f, { 0, 80, 255 } },
+        { 18.0f, { 0, 255, 60 } },
+        { 23.9f, { 0, 255, 60 } },
+        { 26.0f, { 255, 140, 0 } },
+        { 35.0f, { 255, 0, 0 } },
+        { NAN, { 0, 80, 255 } },
+    };
+    for (const auto& c : cases) {
+        // Half way through the cycle: full level
+        renderer.render({ 500, 500, true, c.celsius }, frame, STRIP);
+        assertPixel(frame, c.color, 255, 255);
+        assertPixel(frame + (STRIP - 1) * 3, c.color, 255, 255);
+    }
+}
+
+void test_frames_are_reproducible() {
+    static uint8_t again[STRIP * 3];
+    const LedEffect effects[] = { LedEffect::Blink, LedEffect::Breathe, LedEffect::Wave, LedEffect::TemperatureBands };
+    for (LedEffect effect : effects) {
+        LedRenderer a(effect, { 30, 200, 90 }, 180);
+        LedRenderer b(effect, { 30, 200, 90 }, 180);
+        for (uint32_t t = 0; t < 5000; t += 377) {
+            a.render({ t, 700, ((t / 700) & 1) != 0, 22.5f }, frame, STRIP);
+            b.render({ t, 700, ((t / 700) & 1) != 0, 22.5f }, again, STRIP);
+            TEST_ASSERT_EQUAL_MEMORY(frame, again, sizeof(frame));
+        }
+    }
+}
+
+void test_render_writes_only_its_pixels() {
+    LedRenderer renderer(LedEffect::Wave, { 255, 255, 255 }, 255);
+    renderer.render({ 100, 500, true, NAN }, frame, 10);
+    for (size_t i = 30; i < sizeof(frame); i++) TEST_ASSERT_EQUAL_UINT8(0xAA, frame[i]);
+}
+
+void test_pacer_wakes_for_frames_and_retries() {
+    LedFramePacer pacer(20, 2);
+    TEST_ASSERT_EQUAL_INT(500, (int)pacer.waitMs(500, false));
+    TEST_ASSERT_EQUAL_INT(20, (int)pacer.waitMs(500, true));
+    TEST_ASSERT_EQUAL_INT(5, (int)pacer.waitMs(5, true));
+    TEST_ASSERT_FALSE(pacer.frameDue(false));
+
+    pacer.sent(false);
+    TEST_ASSERT_TRUE(pacer.pending());
+    TEST_ASSERT_EQUAL_INT(2, (int)pacer.waitMs(500, false));
+    TEST_ASSERT_EQUAL_INT(1, (int)pacer.waitMs(1, false));
+    TEST_ASSERT_TRUE(pacer.frameDue(false));
+
+    pacer.sent(true);
+    TEST_ASSERT_FALSE(pacer.pending());
+    TEST_ASSERT_EQUAL_INT(500, (int)pacer.waitMs(500, false));
+}
+
+// RMT on a fake clock: a frame is refused while the last is on the wire
+struct FakeTransmitter {
+    int64_t wireMs;
+    int64_t busyUntil = 0;
+    bool shown = false;
+    int refused = 0;
+
+    bool show(int64_t now, bool on) {
+        if (now < busyUntil) {
+            refused++;
+            return false;
+        }
+        busyUntil = now + wireMs;
+        shown = on;
+        return true;
+    }
+};
+
+// ledTask's Blink loop on a fake clock, periods[i] ms per half period.
+// Returns the ms the strip spent out of step with the blink state.
+// honourRefusals false is the old behaviour: a refused frame is dropped.
+int64_t runBlink(FakeTransmitter& tx, const int64_t* periods, size_t count, bool honourRefusals) {
+    LedFramePacer pacer(20, 2);
+    int64_t now = 0;
+    int64_t lastToggle = 0;
+    bool state = false;
+    int64_t wrongMs = 0;
+    size_t period = 0;
+    while (period < count) {
+        int64_t remaining = periods[period] - (now - lastToggle);
+        int64_t wait = pacer.waitMs(remaining, false);
+        if (wait > 0) {
+            if (tx.shown != state) wrongMs += wait;
+            now += wait;
+        }
+        if (wait < remaining) {
+            if (pacer.frameDue(false)) pacer.sent(tx.show(now, state) || !honourRefusals);
+            continue;
+        }
+        lastToggle = now;
+        state = !state;
+        period++;
+        pacer.sent(tx.show(now, state) || !honourRefusals);
+    }
+    return wrongMs;
+}
+
+void test_blink_edge_refused_while_busy_is_retried() {
+    // The delay drops to 5 ms right after an edge, so the next edge comes
+    // while that edge's 300-pixel frame (9 ms) is still on the wire
+    const int64_t periods[] = { 1, 5, 500, 500 };
+
+    FakeTransmitter tx = { 9 };
+    int64_t wrongMs = runBlink(tx, periods, 4, true);
+    TEST_ASSERT_GREATER_THAN(0, tx.refused);
+    TEST_ASSERT_LESS_OR_EQUAL(9 + 2, wrongMs);
+
+    FakeTransmitter dropping = { 9 };
+    TEST_ASSERT_GREATER_OR_EQUAL(500, runBlink(dropping, periods, 4, false));
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_full_on_matches_neopixel_buffer);
+    RUN_TEST(test_blink_off_matches_cleared_strip);
+    RUN_TEST(test_blink_on_is_gamma_corrected);
+    RUN_TEST(test_breathe_follows_the_wave);
+    RUN_TEST(test_wave_travels_along_the_strip);
+    RUN_TEST(test_wave_spans_one_period);
+    RUN_TEST(test_temperature_bands_pick_colour);
+    RUN_TEST(test_frames_are_reproducible);
+    RUN_TEST(test_render_writes_only_its_pixels);
+    RUN_TEST(test_pacer_wakes_for_frames_and_retries);
+    RUN_TEST(test_blink_edge_refused_while_busy_is_retried);
+    return UNITY_END();
+}
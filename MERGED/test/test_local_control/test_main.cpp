@@ -0,0 +1,229 @@
+// Host tests of the LAN control protocol: browser-sized requests fed in
+// recv()-sized pieces, the bearer token, every error response, and the
+// per-request deadline against a client that trickles bytes
+// (pio test -e native -f test_local_control)
+#include <unity.h>
+
+#include <string>
+
+#include "local_control.h"
+
+const char* TOKEN = "s3cret-lan-token";
+
+struct FakeTarget {
+    int value = 500;
+    int delay() const { return value; }
+    bool setDelay(int d) {
+        if (d < 50 || d > 2000) return false;
+        value = d;
+        return true;
+    }
+};
+
+// What Chrome sends from the dashboard: about 1.4 KB of headers
+std::string browserRequest(const char* method, const std::string& auth, const std::string& body) {
+    std::string r = std::string(method) + " /delay HTTP/1.1\r\n";
+    r += "Host: climate-monitor.local\r\n";
+    r += "Connection: keep-alive\r\n";
+    r += "sec-ch-ua: \"Chromium\";v=\"129\", \"Not=A?Brand\";v=\"8\", \"Google Chrome\";v=\"129\"\r\n";
+    r += "sec-ch-ua-platform: \"Windows\"\r\n";
+    r += "User-Agent: Mozilla/5.0 (Windows NT 10.0; Win64; x64) AppleWebKit/537.36 (KHTML, like Gecko) "
+         "Chrome/129.0.0.0 Safari/537.36\r\n";
+    r += "Accept: */*\r\n";
+    r += "Origin: http://localhost:3000\r\n";
+    r += "Referer: http://localhost:3000/\r\n";
+    r += "Accept-Encoding: gzip, deflate, br, zstd\r\n";
+    r += "Accept-Language: en-GB,en-US;q=0.9,en;q=0.8\r\n";
+    r += "Cookie: " + std::string(900, 'c') + "\r\n";
+    if (!auth.empty()) r += "authorization: " + auth + "\r\n";
+    if (!body.empty()) {
+        r += "Content-Type: application/json\r\n";
+        r += "Content-Length: " + std::to_string(body.size()) + "\r\n";
+    }
+    r += "\r\n" + body;
+    return r;
+}
+
+// Feeds raw in pieces of chunk bytes, as recv() would hand them over
+std::string exchange(const std::string& raw, FakeTarget& target, size_t chunk = 128) {
+    ControlRequest request;
+    for (size_t i = 0; i < raw.size() && !request.done(); i += chunk) {
+        request.feed(raw.data() + i, raw.size() - i < chunk ? raw.size() - i : chunk);
+    }
+    char out[512];
+    size_t n = handleControlRequest(request, target, TOKEN, out, sizeof(out));
+    return std::string(out, n);
+}
+
+bool hasStatus(const std::string& response, int status) {
+    return response.compare(0, 12, "HTTP/1.1 " + std::to_string(status)) == 0;
+}
+
+std::string bodyOf(const std::string& response) {
+    size_t p = response.find("\r\n\r\n");
+    return p == std::string::npos ? "" : response.substr(p + 4);
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_browser_post_sets_delay() {
+    FakeTarget target;
+    std::string raw = browserRequest("POST", std::string("Bearer ") + TOKEN, "{\"delay\":750}");
+    TEST_ASSERT_GREATER_THAN(1024, raw.size());
+
+    const size_t chunks[] = { 1, 7, 128, 1460 };
+    for (size_t chunk : chunks) {
+        target.value = 500;
+        std::string response = exchange(raw, target, chunk);
+        TEST_ASSERT_TRUE(hasStatus(response, 200));
+        TEST_ASSERT_EQUAL_STRING("{\"delay\":750}", bodyOf(response).c_str());
+        TEST_ASSERT_EQUAL_INT(750, target.value);
+    }
+}
+
+void test_get_returns_delay() {
+    FakeTarget target;
+    std::string response = exchange(browserRequest("GET", std::string("Bearer ") + TOKEN, ""), target);
+    TEST_ASSERT_TRUE(hasStatus(response, 200));
+    TEST_ASSERT_EQUAL_STRING("{\"delay\":500}", bodyOf(response).c_str());
+}
+
+void test_token_is_required() {
+    FakeTarget target;
+    const std::string bad[] = { "", "Bearer wrong-token-value", std::string("Basic ") + TOKEN,
+                                std::string("Bearer ") + TOKEN + "x", "Bearer s3cret-lan-toke" };
+    for (const std::string& auth : bad) {
+        std::string response = exchange(browserRequest("POST", auth, "{\"delay\":750}"), target);
+        TEST_ASSERT_TRUE(hasStatus(response, 401));
+    }
+    TEST_ASSERT_EQUAL_INT(500, target.value);
+}
+
+void test_empty_token_refuses_everything() {
+    FakeTarget target;
+    ControlRequest request;
+    const char raw[] = "GET /delay HTTP/1.1\r\nAuthorization: Bearer \r\n\r\n";
+    request.feed(raw, sizeof(raw) - 1);
+    char out[512];
+    std::string response(out, handleControlRequest(request, target, "", out, sizeof(out)));
+    TEST_ASSERT_TRUE(hasStatus(response, 401));
+}
+
+void test_preflight_allows_authorization() {
+    FakeTarget target;
+    std::string raw = "OPTIONS /delay HTTP/1.1\r\nOrigin: http://localhost:3000\r\n"
+                      "Access-Control-Request-Headers: authorization,content-type\r\n\r\n";
+    std::string response = exchange(raw, target);
+    TEST_ASSERT_TRUE(hasStatus(response, 204));
+    TEST_ASSERT_TRUE(response.find("Access-Control-Allow-Headers: Authorization, Content-Type") != std::string::npos);
+}
+
+void test_error_responses() {
+    FakeTarget target;
+    std::string auth = std::string("Bearer ") + TOKEN;
+    TEST_ASSERT_TRUE(hasStatus(exchange(browserRequest("POST", auth, "{\"delay\":9999}"), target), 400));
+    TEST_ASSERT_TRUE(hasStatus(exchange(browserRequest("POST", auth, "{\"speed\":1}"), target), 400));
+    TEST_ASSERT_TRUE(hasStatus(exchange(browserRequest("DELETE", auth, ""), target), 405));
+    TEST_ASSERT_TRUE(hasStatus(exchange("GET /other HTTP/1.1\r\n\r\n", target), 404));
+    TEST_ASSERT_TRUE(hasStatus(exchange("GET /delayed HTTP/1.1\r\n\r\n", target), 404));
+    TEST_ASSERT_TRUE(hasStatus(exchange("garbage\r\n\r\n", target), 400));
+    TEST_ASSERT_TRUE(hasStatus(exchange("POST /delay HTTP/1.1\r\nContent-Length: 1x\r\n\r\n", target), 400));
+
+    // Connection closed before the body arrived
+    std::string cut = browserRequest("POST", auth, "{\"delay\":750}");
+    TEST_ASSERT_TRUE(hasStatus(exchange(cut.substr(0, cut.size() - 4), target), 400));
+    TEST_ASSERT_EQUAL_INT(500, target.value);
+}
+
+void test_oversized_requests() {
+    FakeTarget target;
+    std::string auth = std::string("Bearer ") + TOKEN;
+    std::string big = browserRequest("POST", auth, "{\"delay\":750," + std::string(100, ' ') + "}");
+    TEST_ASSERT_TRUE(hasStatus(exchange(big, target), 413));
+
+    std::string flood = "GET /delay HTTP/1.1\r\n";
+    while (flood.size() < CONTROL_HEADERS_MAX + 100) flood += "X-Filler: " + std::string(100, 'f') + "\r\n";
+    flood += "\r\n";
+    TEST_ASSERT_TRUE(hasStatus(exchange(flood, target), 431));
+}
+
+// A client on a fake clock that sends `step` bytes every `gapMs`
+struct TrickleClient {
+    std::string raw;
+    size_t step;
+    uint32_t gapMs;
+    uint32_t now = 0;
+    size_t sent = 0;
+    int calls = 0;
+
+    // recv() with a receive timeout: waits for the next piece, or gives up
+    int recv(char* buffer, size_t size, uint32_t timeoutMs) {
+        calls++;
+        if (sent == raw.size()) return 0;
+        if (gapMs > timeoutMs) {
+            now += timeoutMs;
+            return -1;
+        }
+        now += gapMs;
+        size_t n = raw.size() - sent < step ? raw.size() - sent : step;
+        if (n > size) n = size;
+        memcpy(buffer, raw.data() + sent, n);
+        sent += n;
+        return (int)n;
+    }
+};
+
+std::string receive(TrickleClient& client, FakeTarget& target, uint32_t recvTimeoutMs, uint32_t deadlineMs) {
+    ControlRequest request;
+    char chunk[128];
+    receiveControlRequest(request, chunk, sizeof(chunk), recvTimeoutMs, deadlineMs,
+        [&](char* buffer, size_t size, uint32_t timeoutMs) { return client.recv(buffer, size, timeoutMs); },
+        [&] { return client.now; });
+    char out[512];
+    return std::string(out, handleControlRequest(request, target, TOKEN, out, sizeof(out)));
+}
+
+void test_slow_client_hits_the_deadline() {
+    FakeTarget target;
+    // One byte every 150 ms: every recv() returns within its 200 ms, but
+    // the 1.4 KB request would take minutes
+    TrickleClient slow = { browserRequest("POST", std::string("Bearer ") + TOKEN, "{\"delay\":750}"), 1, 150 };
+    std::string response = receive(slow, target, 200, 1500);
+    TEST_ASSERT_TRUE(hasStatus(response, 408));
+    TEST_ASSERT_LESS_OR_EQUAL(1500 + 150, slow.now);
+    TEST_ASSERT_LESS_THAN(slow.raw.size(), slow.sent);
+    TEST_ASSERT_EQUAL_INT(500, target.value);
+}
+
+void test_request_within_the_deadline_is_served() {
+    FakeTarget target;
+    // A LAN client: a full segment at once
+    TrickleClient fast = { browserRequest("POST", std::string("Bearer ") + TOKEN, "{\"delay\":750}"), 1460, 2 };
+    TEST_ASSERT_TRUE(hasStatus(receive(fast, target, 200, 1500), 200));
+    TEST_ASSERT_EQUAL_INT(750, target.value);
+
+    // A pause longer than one recv timeout ends the request early
+    TrickleClient stalled = { "GET /delay HTTP/1.1\r\n", 8, 300 };
+    TEST_ASSERT_TRUE(hasStatus(receive(stalled, target, 200, 1500), 400));
+    TEST_ASSERT_EQUAL_INT(1, stalled.calls);
+
+    // The last recv only waits for what is left of the deadline
+    TrickleClient late = { "GET /delay HTTP/1.1\r\n", 1, 180 };
+    receive(late, target, 200, 1000);
+    TEST_ASSERT_LESS_OR_EQUAL(1000, late.now);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_browser_post_sets_delay);
+    RUN_TEST(test_get_returns_delay);
+    RUN_TEST(test_token_is_required);
+    RUN_TEST(test_empty_token_refuses_everything);
+    RUN_TEST(test_preflight_allows_authorization);
+    RUN_TEST(test_error_responses);
+    RUN_TEST(test_oversized_requests);
+    RUN_TEST(test_slow_client_hits_the_deadline);
+    RUN_TEST(test_request_within_the_deadline_is_served);
+    return UNITY_END();
+}
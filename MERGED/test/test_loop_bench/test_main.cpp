@@ -0,0 +1,179 @@
+// Micro-benchmark of the loop() body and the stages it runs, on the host
+// (pio test -e native -f test_loop_bench -v). Wall time per iteration,
+// best of BENCH_ROUNDS; the fake clock only drives the firmware logic.
+// Fails when a full loop() pass with a sensor reading exceeds
+// LOOP_BENCH_BUDGET_NS, or a 300-pixel LED frame exceeds
+// LED_FRAME_BUDGET_NS, so a regression shows up before flashing.
+#include <unity.h>
+
+#include <chrono>
+
+#include "../host_loop.h"
+#include "dht22_decoder.h"
+#include "led_effects.h"
+
+#ifndef LOOP_BENCH_BUDGET_NS
+#define LOOP_BENCH_BUDGET_NS 20000
+#endif
+
+#ifndef LED_FRAME_BUDGET_NS
+#define LED_FRAME_BUDGET_NS 20000
+#endif
+
+const int BENCH_ROUNDS = 5;
+
+// Keeps results alive so the optimizer can't drop the work
+volatile uint32_t benchSink = 0;
+
+// Nanoseconds per call of fn, best of BENCH_ROUNDS runs of iterations calls
+template <typename Fn>
+double nsPerIteration(int iterations, Fn fn) {
+    double best = 0;
+    for (int round = 0; round < BENCH_ROUNDS; round++) {
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < iterations; i++) fn(i);
+        double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+        if (round == 0 || ns < best) best = ns;
+    }
+    return best / iterations;
+}
+
+void report(const char* name, double ns) {
+    char line[96];
+    snprintf(line, sizeof(line), "%-28s %10.1f ns", name, ns);
+    TEST_MESSAGE(line);
+}
+
+// A DHT22 capture of bytes as the RMT receiver records it
+size_t dhtCapture(const uint8_t (&bytes)[5], DhtLevel* levels) {
+    size_t n = 0;
+    levels[n++] = { 0, 80 };
+    levels[n++] = { 1, 80 };
+    for (size_t bit = 0; bit < DHT_FRAME_BITS; bit++) {
+        bool one = bytes[bit / 8] & (0x80 >> (bit % 8));
+        levels[n++] = { 0, 50 };
+        levels[n++] = { 1, (uint16_t)(one ? 70 : 27) };
+    }
+    return n;
+}
+
+void setUp() {
+    FakeClock::reset();
+    DHT::script(21.0f, 45.0f);
+    HTTPClient::script(200);
+    Serial.quiet(true);
+}
+
+void tearDown() {}
+
+void test_bench_stages() {
+    // 65.2 %RH, 23.1 °C
+    const uint8_t bytes[5] = { 0x02, 0x8c, 0x00, 0xe7, 0x75 };
+    DhtLevel capture[2 + 2 * DHT_FRAME_BITS];
+    size_t levels = dhtCapture(bytes, capture);
+    report("decodeDht22", nsPerIteration(100000, [&](int) {
+        benchSink += (uint32_t)decodeDht22(capture, levels).humidity;
+    }));
+
+    SampleFilter<5> filter(0.5f);
+    report("SampleFilter<5>::add", nsPerIteration(100000, [&](int i) {
+        benchSink += (uint32_t)filter.add(21.0f + (i & 7) * 0.1f);
+    }));
+
+    const float bounds[2] = { 0.1f, 0.1f };
+    SwingingDoor<2> door(bounds, 300000);
+    report("SwingingDoor<2>::offer", nsPerIteration(100000, [&](int i) {
+        SwingingDoor<2>::Sample sample = { (uint32_t)i * 2000, { 21.0f + (i % 50) * 0.01f, 45.0f } };
+        SwingingDoor<2>::Sample out;
+        benchSink += door.offer(sample, out);
+    }));
+
+    AdaptiveSampler<2> sampler(bounds, RateLimits());
+    report("AdaptiveSampler<2>::onSample", nsPerIteration(100000, [&](int i) {
+        const float raw[2] = { 21.0f + (i & 3) * 0.1f, 45.0f };
+        benchSink += sampler.onSample((uint32_t)i * 2000, raw);
+    }));
+
+    Reading batch[HostLoop::BATCH_SIZE];
+    for (size_t i = 0; i < HostLoop::BATCH_SIZE; i++) {
+        batch[i] = { 21.0f + i * 0.1f, 45.0f - i * 0.1f, (uint32_t)i * 2000, 1790000000000LL + (int64_t)i * 2000 };
+    }
+    uint8_t out[HostLoop::UPLOAD_BUFFER_SIZE];
+    report("WireEncoder, 10 readings", nsPerIteration(20000, [&](int i) {
+        WireEncoder encoder(out, sizeof(out), 1, (uint32_t)i);
+        for (const Reading& r : batch) encoder.add(r.temperature, r.humidity, r.epochMs);
+        benchSink += encoder.length();
+    }));
+    report("encodeJsonBatch, 10 readings", nsPerIteration(20000, [&](int) {
+        benchSink += encodeJsonBatch<HostLoop::BATCH_SIZE>(batch, HostLoop::BATCH_SIZE, (char*)out, sizeof(out));
+    }));
+
+    LedRenderer renderer(LedEffect::Breathe, { 0, 150, 255 }, 150);
+    uint8_t frame[3];
+    report("LedRenderer, 1 pixel", nsPerIteration(100000, [&](int i) {
+        LedFrameInput input = { (uint32_t)i * 20, 500, true, 21.0f };
+        renderer.render(input, frame, 1);
+        benchSink += frame[0];
+    }));
+
+    Scheduler<6> scheduler;
+    for (int i = 0; i < 6; i++) scheduler.every(1000 + i, [](uint32_t) {}, 1000000);
+    report("Scheduler<6>, nothing due", nsPerIteration(100000, [&](int i) {
+        benchSink += scheduler.runDue((uint32_t)i & 0xFFFF);
+        benchSink += scheduler.idleTime((uint32_t)i & 0xFFFF, 1000);
+    }));
+}
+
+void test_bench_led_frame_300_pixels() {
+    const size_t pixels = 300;
+    static uint8_t frame[pixels * 3];
+    const struct { const char* name; LedEffect effect; } effects[] = {
+        { "LedRenderer Blink, 300 px", LedEffect::Blink },
+        { "LedRenderer Breathe, 300 px", LedEffect::Breathe },
+        { "LedRenderer Wave, 300 px", LedEffect::Wave },
+        { "LedRenderer Bands, 300 px", LedEffect::TemperatureBands },
+    };
+    double worst = 0;
+    for (const auto& e : effects) {
+        LedRenderer renderer(e.effect, { 0, 150, 255 }, 150);
+        double ns = nsPerIteration(20000, [&](int i) {
+            LedFrameInput input = { (uint32_t)i * 20, 500, (i & 1) != 0, 21.0f + (i & 15) };
+            renderer.render(input, frame, pixels);
+            benchSink += frame[i % (pixels * 3)];
+        });
+        report(e.name, ns);
+        if (ns > worst) worst = ns;
+    }
+    TEST_ASSERT_LESS_THAN(LED_FRAME_BUDGET_NS, worst);
+}
+
+void test_bench_loop_body() {
+    HostLoop loop(true);
+    // Alternating readings: every pass reads, filters, compresses, queues
+    // and every tenth one encodes and posts a batch
+    DHT::script(21.0f, 45.0f);
+    loop.run(10000);
+    uint32_t uploads = loop.uploads();
+
+    double ns = nsPerIteration(20000, [&](int i) {
+        DHT::script(i & 1 ? 21.0f : 23.0f, i & 1 ? 45.0f : 50.0f);
+        FakeClock::advanceMs(loop.sampleIntervalMs());
+        benchSink += loop.loopBody();
+    });
+    report("loop() with a reading", ns);
+    TEST_ASSERT_GREATER_THAN(uploads, loop.uploads());
+
+    report("loop() with nothing due", nsPerIteration(100000, [&](int) {
+        benchSink += loop.loopBody();
+    }));
+
+    TEST_ASSERT_LESS_THAN(LOOP_BENCH_BUDGET_NS, ns);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_bench_stages);
+    RUN_TEST(test_bench_led_frame_300_pixels);
+    RUN_TEST(test_bench_loop_body);
+    return UNITY_END();
+}
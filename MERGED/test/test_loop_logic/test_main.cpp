@@ -0,0 +1,249 @@
+// Host tests of the loop() logic: delay clamping, the JSON formats and
+// the sensor -> upload path on the shims (pio test -e native)
+#include <unity.h>
+
+#include "../host_loop.h"
+#include "sensor_logic.h"
+
+void setUp() {
+    FakeClock::reset();
+    DHT::script(21.0f, 45.0f);
+    HTTPClient::script(200);
+    HTTPClient::resetStats();
+    Serial.quiet(true);
+}
+
+void tearDown() {}
+
+void test_clamp_delay() {
+    TEST_ASSERT_EQUAL_INT(50, clampDelay(0, 50, 2000));
+    TEST_ASSERT_EQUAL_INT(50, clampDelay(-7, 50, 2000));
+    TEST_ASSERT_EQUAL_INT(500, clampDelay(500, 50, 2000));
+    TEST_ASSERT_EQUAL_INT(2000, clampDelay(2000, 50, 2000));
+    TEST_ASSERT_EQUAL_INT(2000, clampDelay(99999, 50, 2000));
+}
+
+void test_parse_delay_json() {
+    int delay = -1;
+    TEST_ASSERT_FALSE(parseDelayJson("{\"delay\":750,\"version\":3}", delay));
+    TEST_ASSERT_EQUAL_INT(750, delay);
+
+    delay = 123;
+    TEST_ASSERT_TRUE(parseDelayJson("{\"version\":3}", delay));
+    TEST_ASSERT_TRUE(parseDelayJson("{\"delay\":\"fast\"}", delay));
+    TEST_ASSERT_TRUE(parseDelayJson("not json", delay));
+    TEST_ASSERT_EQUAL_INT(123, delay);
+}
+
+void test_parse_rate_limits_json() {
+    RateLimits limits;
+    TEST_ASSERT_FALSE(parseRateLimitsJson("{\"inserted\":10}", limits));
+    TEST_ASSERT_EQUAL_UINT32(0, limits.version);
+
+    TEST_ASSERT_FALSE(parseRateLimitsJson(
+        "{\"inserted\":10,\"limits\":{\"version\":4,\"max_sample_ms\":60000}}", limits));
+    TEST_ASSERT_EQUAL_UINT32(4, limits.version);
+    TEST_ASSERT_EQUAL_UINT32(2000, limits.minSampleMs);
+    TEST_ASSERT_EQUAL_UINT32(60000, limits.maxSampleMs);
+}
+
+void test_json_batch_round_trip() {
+    Reading batch[3] = {
+        { 21.234f, 45.0f, 1000, 1790000001000LL },
+        { -4.5f, 99.9f, 3000, 1790000003000LL },
+        { 22.0f, 40.0f, 5000, 0 },
+    };
+    char out[256];
+    size_t length = encodeJsonBatch<10>(batch, 3, out, sizeof(out));
+    TEST_ASSERT_GREATER_THAN(0, length);
+    TEST_ASSERT_EQUAL_size_t(strlen(out), length);
+
+    StaticJsonDocument<512> doc;
+    TEST_ASSERT_FALSE(deserializeJson(doc, out));
+    TEST_ASSERT_EQUAL_INT64(1790000001000LL, doc["base"].as<int64_t>());
+    JsonArray readings = doc["readings"];
+    TEST_ASSERT_EQUAL_size_t(3, readings.size());
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 21.23f, readings[0]["temperature"].as<float>());
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, -4.5f, readings[1]["temperature"].as<float>());
+    TEST_ASSERT_EQUAL_INT64(0, readings[0]["dt"].as<int64_t>());
+    TEST_ASSERT_EQUAL_INT64(2000, readings[1]["dt"].as<int64_t>());
+    TEST_ASSERT_TRUE(readings[2]["dt"].isNull());
+}
+
+void test_json_batch_does_not_fit() {
+    Reading batch[1] = { { 21.0f, 45.0f, 0, 0 } };
+    char out[16];
+    TEST_ASSERT_EQUAL_size_t(0, encodeJsonBatch<10>(batch, 1, out, sizeof(out)));
+}
+
+void test_json_uploads_fit_a_full_batch() {
+    // Widest values the sensor path produces, far apart in time, then
+    // values no sensor gives, with the largest gaps an int64 holds
+    Reading wide[HostLoop::BATCH_SIZE];
+    Reading extreme[HostLoop::BATCH_SIZE];
+    for (size_t i = 0; i < HostLoop::BATCH_SIZE; i++) {
+        wide[i] = { -39.99f, 99.99f, (uint32_t)i * 2000, 1790000000000LL + (int64_t)i * 86400000LL * 30 };
+        extreme[i] = { i & 1 ? -3.3333333e35f : -9999999.99f, 1234567.89f, 0,
+                       i & 1 ? INT64_MIN / 2 + 1 : INT64_MAX / 2 - 1 };
+    }
+
+    char out[HostLoop::UPLOAD_BUFFER_SIZE];
+    size_t length = encodeJsonBatch<HostLoop::BATCH_SIZE>(wide, HostLoop::BATCH_SIZE, out, sizeof(out));
+    TEST_ASSERT_GREATER_THAN(512, length);
+    TEST_ASSERT_EQUAL_size_t(strlen(out), length);
+    TEST_ASSERT_GREATER_THAN(0, encodeJsonBatch<HostLoop::BATCH_SIZE>(extreme, HostLoop::BATCH_SIZE, out, sizeof(out)));
+
+    // Short keys fit the smaller bound of the same formula
+    char shortOut[jsonBatchMaxSize<ShortReadingKeys>(HostLoop::BATCH_SIZE)];
+    TEST_ASSERT_GREATER_THAN(0, (encodeJsonBatch<HostLoop::BATCH_SIZE, ShortReadingKeys>(
+        extreme, HostLoop::BATCH_SIZE, shortOut, sizeof(shortOut))));
+
+    // The JSON loop never fails to encode a batch
+    HostLoop loop(false);
+    DHT::script(-39.99f, 99.99f);
+    loop.run(5 * 60000);
+    TEST_ASSERT_EQUAL_UINT32(0, loop.failedUploads());
+    TEST_ASSERT_GREATER_THAN(0, loop.uploads());
+}
+
+void test_upload_buffer_fits_either_format() {
+    TEST_ASSERT_TRUE(HostLoop::UPLOAD_BUFFER_SIZE >= wireEncodedSize(HostLoop::BATCH_SIZE));
+    TEST_ASSERT_TRUE(jsonBatchMaxSize(HostLoop::BATCH_SIZE) > jsonBatchMaxSize<ShortReadingKeys>(HostLoop::BATCH_SIZE));
+}
+
+void test_steady_room_uploads_heartbeats_only() {
+    HostLoop loop(true);
+    loop.run(30 * 60000);
+
+    // Steady readings back off to the slowest rate and only the
+    // first reading and the 5-minute heartbeats are kept
+    TEST_ASSERT_EQUAL_UINT32(30000, loop.sampleIntervalMs());
+    TEST_ASSERT_LESS_THAN(100, loop.samples());
+    TEST_ASSERT_EQUAL_UINT32(6, loop.queued());
+    // Below BATCH_SIZE, so the age limit flushed them as they came
+    TEST_ASSERT_EQUAL_UINT32(loop.queued(), loop.uploads());
+    TEST_ASSERT_EQUAL_size_t(0, loop.waiting());
+}
+
+void test_step_change_is_uploaded() {
+    HostLoop loop(true);
+    loop.run(5 * 60000);
+    uint32_t samples = loop.samples();
+    uint32_t queued = loop.queued();
+    uint32_t uploads = loop.uploads();
+
+    DHT::script(24.0f, 39.0f);
+    loop.run(40000);
+
+    // Sampling speeds up at once and the new level reaches the server
+    TEST_ASSERT_GREATER_THAN(samples + 8, loop.samples());
+    TEST_ASSERT_GREATER_THAN(queued + 1, loop.queued());
+    TEST_ASSERT_GREATER_THAN(uploads, loop.uploads());
+    const uint8_t* body = HTTPClient::lastBody();
+    TEST_ASSERT_EQUAL_UINT8('C', body[0]);
+    TEST_ASSERT_EQUAL_UINT8('C', body[1]);
+    TEST_ASSERT_EQUAL_UINT8(WIRE_VERSION, body[2]);
+}
+
+void test_retry_after_pauses_uploads() {
+    HostLoop loop(true);
+    loop.run(5 * 60000);
+    uint32_t uploads = loop.uploads();
+
+    // The next flush is answered 503 with Retry-After: 30
+    HTTPClient::script(503, "", "30");
+    DHT::script(30.0f, 80.0f);
+    uint32_t requests = HTTPClient::requests();
+    while (HTTPClient::requests() == requests) loop.run(1000);
+    TEST_ASSERT_FALSE(loop.throttle().allowed(millis()));
+    uint32_t resumeAt = loop.throttle().resumeAtMs();
+    TEST_ASSERT_GREATER_OR_EQUAL_UINT32(millis() + 29000, resumeAt);
+
+    // Readings keep coming but nothing is posted until then
+    requests = HTTPClient::requests();
+    loop.run(resumeAt - millis() - 1);
+    TEST_ASSERT_EQUAL_UINT32(requests, HTTPClient::requests());
+    TEST_ASSERT_GREATER_THAN(0, loop.waiting());
+
+    HTTPClient::script(200);
+    loop.run(30000);
+    TEST_ASSERT_GREATER_THAN(uploads, loop.uploads());
+    TEST_ASSERT_EQUAL_size_t(0, loop.waiting());
+}
+
+void test_upload_outcomes() {
+    TEST_ASSERT_TRUE(uploadOutcome(200) == UploadOutcome::Delivered);
+    TEST_ASSERT_TRUE(uploadOutcome(201) == UploadOutcome::Delivered);
+    const int rejected[] = { 400, 401, 403, 404, 413, 415, 422 };
+    for (int code : rejected) TEST_ASSERT_TRUE(uploadOutcome(code) == UploadOutcome::Rejected);
+    const int retried[] = { -1, -11, 0, 301, 408, 429, 500, 502, 503, 504 };
+    for (int code : retried) TEST_ASSERT_TRUE(uploadOutcome(code) == UploadOutcome::Retry);
+}
+
+void test_refused_batch_is_dropped() {
+    HostLoop loop(true);
+    loop.run(5 * 60000);
+    uint32_t uploads = loop.uploads();
+
+    // The server refuses the next batch outright
+    HTTPClient::script(422);
+    DHT::script(30.0f, 80.0f);
+    uint32_t requests = HTTPClient::requests();
+    while (HTTPClient::requests() == requests) loop.run(1000);
+    TEST_ASSERT_GREATER_THAN(0, loop.rejectedReadings());
+    // No backoff: a refusal is not the server being busy
+    TEST_ASSERT_TRUE(loop.throttle().allowed(millis()));
+    TEST_ASSERT_EQUAL_UINT32(0, loop.throttle().backoffs());
+
+    // It is not sent again, and the readings after it go through
+    uint32_t rejected = loop.rejectedReadings();
+    HTTPClient::script(200);
+    DHT::script(24.0f, 60.0f);
+    loop.run(60000);
+    TEST_ASSERT_EQUAL_UINT32(rejected, loop.rejectedReadings());
+    TEST_ASSERT_GREATER_THAN(uploads, loop.uploads());
+    TEST_ASSERT_LESS_THAN(HostLoop::BATCH_SIZE, loop.waiting());
+}
+
+void test_server_errors_back_off() {
+    const int codes[] = { 500, 429, 408, -1 };
+    for (int code : codes) {
+        FakeClock::reset();
+        HostLoop loop(true);
+        loop.run(5 * 60000);
+
+        // Failing for a minute: each retry waits longer, nothing is dropped
+        HTTPClient::script(code);
+        DHT::script(30.0f, 80.0f);
+        uint32_t requests = HTTPClient::requests();
+        loop.run(60000);
+        uint32_t attempts = HTTPClient::requests() - requests;
+        TEST_ASSERT_GREATER_THAN(0, attempts);
+        TEST_ASSERT_LESS_THAN(6, attempts);
+        TEST_ASSERT_EQUAL_UINT32(attempts, loop.throttle().backoffs());
+        TEST_ASSERT_EQUAL_UINT32(0, loop.rejectedReadings());
+        TEST_ASSERT_GREATER_THAN(0, loop.waiting());
+
+        HTTPClient::script(200);
+        loop.run(15 * 60000);
+        TEST_ASSERT_EQUAL_size_t(0, loop.waiting());
+    }
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_clamp_delay);
+    RUN_TEST(test_parse_delay_json);
+    RUN_TEST(test_parse_rate_limits_json);
+    RUN_TEST(test_json_batch_round_trip);
+    RUN_TEST(test_json_batch_does_not_fit);
+    RUN_TEST(test_json_uploads_fit_a_full_batch);
+    RUN_TEST(test_upload_buffer_fits_either_format);
+    RUN_TEST(test_steady_room_uploads_heartbeats_only);
+    RUN_TEST(test_step_change_is_uploaded);
+    RUN_TEST(test_retry_after_pauses_uploads);
+    RUN_TEST(test_upload_outcomes);
+    RUN_TEST(test_refused_batch_is_dropped);
+    RUN_TEST(test_server_errors_back_off);
+    return UNITY_END();
+}
@@ -0,0 +1,79 @@
+// Host tests of ReadingBuffer: when a batch is flushed and what is
+// kept when the queue overflows
+#include <unity.h>
+
+#include "reading_buffer.h"
+
+Reading at(uint32_t ms, float temperature = 21.0f) {
+    return Reading{ temperature, 45.0f, ms, 0 };
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_empty_never_flushes() {
+    ReadingBuffer<60> buffer(10, 20000);
+    TEST_ASSERT_FALSE(buffer.shouldFlush(0));
+    TEST_ASSERT_FALSE(buffer.shouldFlush(1000000));
+}
+
+void test_flushes_at_batch_size() {
+    ReadingBuffer<60> buffer(10, 20000);
+    for (uint32_t i = 0; i < 9; i++) {
+        buffer.push(at(i * 2000));
+        TEST_ASSERT_FALSE(buffer.shouldFlush(i * 2000));
+    }
+    buffer.push(at(18000));
+    TEST_ASSERT_TRUE(buffer.shouldFlush(18000));
+}
+
+void test_flushes_when_oldest_is_too_old() {
+    ReadingBuffer<60> buffer(10, 20000);
+    buffer.push(at(5000));
+    buffer.push(at(15000));
+    TEST_ASSERT_FALSE(buffer.shouldFlush(24999));
+    TEST_ASSERT_TRUE(buffer.shouldFlush(25000));
+}
+
+void test_age_survives_millis_wrap() {
+    ReadingBuffer<60> buffer(10, 20000);
+    buffer.push(at(0xFFFFF000u));
+    TEST_ASSERT_FALSE(buffer.shouldFlush(0xFFFFFFFFu));
+    TEST_ASSERT_TRUE(buffer.shouldFlush(0xFFFFF000u + 20000));
+}
+
+void test_drop_after_delivery_keeps_order() {
+    ReadingBuffer<60> buffer(10, 20000);
+    for (uint32_t i = 0; i < 15; i++) buffer.push(at(i, (float)i));
+    buffer.drop(10);
+    TEST_ASSERT_EQUAL_size_t(5, buffer.size());
+    TEST_ASSERT_EQUAL_FLOAT(10.0f, buffer.at(0).temperature);
+    TEST_ASSERT_EQUAL_FLOAT(14.0f, buffer.at(4).temperature);
+    // Five left: below the batch size, flushed by age only
+    TEST_ASSERT_FALSE(buffer.shouldFlush(14));
+
+    buffer.drop(100);
+    TEST_ASSERT_TRUE(buffer.empty());
+}
+
+void test_overflow_drops_oldest() {
+    ReadingBuffer<4> buffer(10, 20000);
+    for (uint32_t i = 0; i < 4; i++) TEST_ASSERT_TRUE(buffer.push(at(i, (float)i)));
+    TEST_ASSERT_FALSE(buffer.push(at(4, 4.0f)));
+    TEST_ASSERT_EQUAL_size_t(4, buffer.size());
+    TEST_ASSERT_EQUAL_FLOAT(1.0f, buffer.at(0).temperature);
+    TEST_ASSERT_EQUAL_FLOAT(4.0f, buffer.at(3).temperature);
+    // flushCount is capped at the capacity, so a full buffer flushes
+    TEST_ASSERT_TRUE(buffer.shouldFlush(4));
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_empty_never_flushes);
+    RUN_TEST(test_flushes_at_batch_size);
+    RUN_TEST(test_flushes_when_oldest_is_too_old);
+    RUN_TEST(test_age_survives_millis_wrap);
+    RUN_TEST(test_drop_after_delivery_keeps_order);
+    RUN_TEST(test_overflow_drops_oldest);
+    return UNITY_END();
+}
@@ -0,0 +1,283 @@
+// Host tests of the store-and-forward log on a RAM-backed storage shim,
+// including a power cut at every byte of a fill/drain workload
+// (pio test -e native -f test_reading_log)
+#include <unity.h>
+
+#include <set>
+#include <vector>
+
+#include <ram_storage.h>
+
+#include "reading_log.h"
+
+typedef ReadingLog<RamStorage> Log;
+
+const uint32_t SLOTS = 64;
+const size_t STORAGE_SIZE = Log::RECORDS_OFFSET + SLOTS * Log::RECORD_SIZE;
+const size_t DRAIN_BATCH = 10;
+const int64_t EPOCH_BASE = 1790000000000LL;
+
+// Reading n carries n in its epoch so deliveries can be told apart
+Reading reading(uint32_t n) {
+    return { 20.0f + (n % 100) * 0.01f, 40.0f + (n % 50) * 0.1f, n * 2000, EPOCH_BASE + n };
+}
+
+uint32_t idOf(const Reading& r) { return (uint32_t)(r.epochMs - EPOCH_BASE); }
+
+// Peeks, delivers and consumes until the log is empty or a write fails
+bool drainAll(Log& log, std::vector<uint32_t>& delivered) {
+    Reading batch[DRAIN_BATCH];
+    while (!log.empty()) {
+        size_t n = log.peek(batch, DRAIN_BATCH);
+        for (size_t i = 0; i < n; i++) delivered.push_back(idOf(batch[i]));
+        if (!log.consume()) return false;
+    }
+    return true;
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_blank_storage_mounts_empty() {
+    RamStorage storage(STORAGE_SIZE);
+    Log log(storage);
+    TEST_ASSERT_TRUE(log.mount());
+    TEST_ASSERT_TRUE(log.empty());
+    TEST_ASSERT_EQUAL_UINT32(SLOTS, log.capacity());
+
+    RamStorage tiny(Log::RECORDS_OFFSET + Log::RECORD_SIZE - 1);
+    Log unusable(tiny);
+    TEST_ASSERT_FALSE(unusable.mount());
+    TEST_ASSERT_FALSE(unusable.append(reading(0)));
+}
+
+void test_round_trip_survives_remount() {
+    RamStorage storage(STORAGE_SIZE);
+    {
+        Log log(storage);
+        log.mount();
+        const Reading cold = { -12.34f, 98.76f, 4000, EPOCH_BASE + 9 };
+        TEST_ASSERT_TRUE(log.append(reading(1)));
+        TEST_ASSERT_TRUE(log.append(cold));
+    }
+    Log log(storage);
+    TEST_ASSERT_TRUE(log.mount());
+    TEST_ASSERT_EQUAL_size_t(2, log.size());
+
+    Reading out[4];
+    TEST_ASSERT_EQUAL_size_t(2, log.peek(out, 4));
+    TEST_ASSERT_EQUAL_UINT32(1, idOf(out[0]));
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, -12.34f, out[1].temperature);
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 98.76f, out[1].humidity);
+    TEST_ASSERT_EQUAL_UINT32(4000, out[1].capturedMs);
+    TEST_ASSERT_EQUAL_INT64(EPOCH_BASE + 9, out[1].epochMs);
+}
+
+void test_drains_in_order_across_reboots() {
+    RamStorage storage(STORAGE_SIZE);
+    std::vector<uint32_t> delivered;
+    uint32_t next = 0;
+    for (int boot = 0; boot < 4; boot++) {
+        Log log(storage);
+        TEST_ASSERT_TRUE(log.mount());
+        for (int i = 0; i < 20; i++) TEST_ASSERT_TRUE(log.append(reading(next++)));
+        // Drain only part of it before the next reboot
+        Reading batch[DRAIN_BATCH];
+        size_t n = log.peek(batch, DRAIN_BATCH);
+        for (size_t i = 0; i < n; i++) delivered.push_back(idOf(batch[i]));
+        TEST_ASSERT_TRUE(log.consume());
+    }
+    Log log(storage);
+    log.mount();
+    TEST_ASSERT_TRUE(drainAll(log, delivered));
+
+    TEST_ASSERT_EQUAL_size_t(next, delivered.size());
+    for (uint32_t i = 0; i < next; i++) TEST_ASSERT_EQUAL_UINT32(i, delivered[i]);
+    TEST_ASSERT_EQUAL_UINT32(0, log.lost());
+}
+
+void test_unconsumed_batch_is_resent() {
+    RamStorage storage(STORAGE_SIZE);
+    {
+        Log log(storage);
+        log.mount();
+        for (uint32_t i = 0; i < 15; i++) log.append(reading(i));
+        Reading batch[DRAIN_BATCH];
+        log.peek(batch, DRAIN_BATCH);       // upload failed, no consume()
+    }
+    Log log(storage);
+    log.mount();
+    Reading batch[DRAIN_BATCH];
+    TEST_ASSERT_EQUAL_size_t(DRAIN_BATCH, log.peek(batch, DRAIN_BATCH));
+    TEST_ASSERT_EQUAL_UINT32(0, idOf(batch[0]));
+}
+
+void test_wrap_overwrites_oldest() {
+    RamStorage storage(STORAGE_SIZE);
+    Log log(storage);
+    log.mount();
+    for (uint32_t i = 0; i < SLOTS + 5; i++) TEST_ASSERT_TRUE(log.append(reading(i)));
+    TEST_ASSERT_EQUAL_size_t(SLOTS, log.size());
+    TEST_ASSERT_EQUAL_UINT32(5, log.lost());
+
+    Log remounted(storage);
+    remounted.mount();
+    std::vector<uint32_t> delivered;
+    TEST_ASSERT_TRUE(drainAll(remounted, delivered));
+    TEST_ASSERT_EQUAL_size_t(SLOTS, delivered.size());
+    for (uint32_t i = 0; i < SLOTS; i++) TEST_ASSERT_EQUAL_UINT32(i + 5, delivered[i]);
+}
+
+void test_corrupt_record_is_skipped_and_counted() {
+    RamStorage storage(STORAGE_SIZE);
+    {
+        Log log(storage);
+        log.mount();
+        for (uint32_t i = 0; i < 5; i++) log.append(reading(i));
+    }
+    storage.data()[Log::RECORDS_OFFSET + 2 * Log::RECORD_SIZE + 17] ^= 0x40;
+
+    Log log(storage);
+    log.mount();
+    std::vector<uint32_t> delivered;
+    TEST_ASSERT_TRUE(drainAll(log, delivered));
+    TEST_ASSERT_EQUAL_size_t(4, delivered.size());
+    TEST_ASSERT_EQUAL_UINT32(3, delivered[2]);
+    TEST_ASSERT_EQUAL_UINT32(1, log.lost());
+}
+
+// Appends 7, drains a batch of up to 10, six times over; stops at the
+// first failed write like the firmware losing power would
+void workload(Log& log, std::vector<uint32_t>& acked, std::vector<uint32_t>& delivered) {
+    uint32_t next = 0;
+    for (int round = 0; round < 6; round++) {
+        for (int i = 0; i < 7; i++) {
+            if (!log.append(reading(next))) return;
+            acked.push_back(next++);
+        }
+        Reading batch[DRAIN_BATCH];
+        size_t n = log.peek(batch, DRAIN_BATCH);
+        for (size_t i = 0; i < n; i++) delivered.push_back(idOf(batch[i]));
+        if (!log.consume()) return;
+    }
+}
+
+// What user-012 firmware left behind: an "RLG1" cursor and 16-byte records
+void writeOldLayout(RamStorage& storage) {
+    const uint8_t cursor[16] = { 'R', 'L', 'G', '1', 3, 0, 0, 0, 40, 0, 0, 0, 0x12, 0x34, 0x56, 0x78 };
+    storage.write(Log::CURSOR_SIZE, cursor, sizeof(cursor));
+    for (uint32_t i = 0; i < 50; i++) {
+        uint8_t record[16];
+        for (uint32_t b = 0; b < sizeof(record); b++) record[b] = (uint8_t)(i * 7 + b);
+        storage.write(Log::RECORDS_OFFSET + i * sizeof(record), record, sizeof(record));
+    }
+}
+
+void test_old_layout_is_erased() {
+    RamStorage storage(STORAGE_SIZE);
+    writeOldLayout(storage);
+    {
+        Log log(storage);
+        TEST_ASSERT_TRUE(log.mount());
+        TEST_ASSERT_TRUE(log.erasedOldLayout());
+        TEST_ASSERT_TRUE(log.empty());
+        for (size_t i = 0; i < STORAGE_SIZE; i++) TEST_ASSERT_EQUAL_UINT8(0xFF, storage.data()[i]);
+
+        TEST_ASSERT_TRUE(log.append(reading(1)));
+        Reading out[1];
+        TEST_ASSERT_EQUAL_size_t(1, log.peek(out, 1));
+        TEST_ASSERT_TRUE(log.consume());
+        TEST_ASSERT_TRUE(log.append(reading(2)));
+    }
+
+    // Its own cursor is left alone on the next boot
+    Log log(storage);
+    TEST_ASSERT_TRUE(log.mount());
+    TEST_ASSERT_FALSE(log.erasedOldLayout());
+    TEST_ASSERT_EQUAL_size_t(1, log.size());
+}
+
+void test_power_cut_while_erasing_old_layout() {
+    for (long cut = 0; cut < (long)STORAGE_SIZE; cut += 37) {
+        RamStorage storage(STORAGE_SIZE);
+        writeOldLayout(storage);
+        {
+            Log log(storage);
+            storage.cutPowerAfter(cut);
+            TEST_ASSERT_FALSE(log.mount());
+        }
+
+        // The cursors go last: either the next boot erases again or
+        // what is left of the old records fails its CRC
+        storage.powerOn();
+        Log log(storage);
+        TEST_ASSERT_TRUE(log.mount());
+        TEST_ASSERT_TRUE(log.empty());
+        TEST_ASSERT_TRUE(log.append(reading(1)));
+        Log again(storage);
+        TEST_ASSERT_TRUE(again.mount());
+        TEST_ASSERT_FALSE(again.erasedOldLayout());
+        TEST_ASSERT_EQUAL_size_t(1, again.size());
+    }
+}
+
+void test_power_cut_at_every_byte() {
+    size_t total;
+    {
+        RamStorage storage(STORAGE_SIZE);
+        Log log(storage);
+        log.mount();
+        std::vector<uint32_t> acked, delivered;
+        workload(log, acked, delivered);
+        total = storage.written();
+    }
+
+    for (size_t cut = 0; cut < total; cut++) {
+        RamStorage storage(STORAGE_SIZE);
+        std::vector<uint32_t> acked, delivered;
+        {
+            Log log(storage);
+            log.mount();
+            storage.cutPowerAfter((long)cut);
+            workload(log, acked, delivered);
+            TEST_ASSERT_FALSE(storage.powered());
+        }
+
+        storage.powerOn();
+        Log log(storage);
+        TEST_ASSERT_TRUE(log.mount());
+        TEST_ASSERT_TRUE(drainAll(log, delivered));
+
+        // Nothing acknowledged is lost, nothing unacknowledged appears,
+        // order holds and only the batch in flight may come twice
+        std::set<uint32_t> seen;
+        uint32_t newest = 0;
+        size_t repeats = 0;
+        for (uint32_t id : delivered) {
+            TEST_ASSERT_TRUE(id < acked.size());
+            if (seen.insert(id).second) {
+                if (seen.size() > 1) TEST_ASSERT_TRUE(id > newest);
+                newest = id;
+            } else {
+                repeats++;
+            }
+        }
+        TEST_ASSERT_EQUAL_size_t(acked.size(), seen.size());
+        TEST_ASSERT_LESS_OR_EQUAL(DRAIN_BATCH, repeats);
+        TEST_ASSERT_EQUAL_UINT32(0, log.lost());
+    }
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_blank_storage_mounts_empty);
+    RUN_TEST(test_round_trip_survives_remount);
+    RUN_TEST(test_drains_in_order_across_reboots);
+    RUN_TEST(test_unconsumed_batch_is_resent);
+    RUN_TEST(test_wrap_overwrites_oldest);
+    RUN_TEST(test_corrupt_record_is_skipped_and_counted);
+    RUN_TEST(test_old_layout_is_erased);
+    RUN_TEST(test_power_cut_while_erasing_old_layout);
+    RUN_TEST(test_power_cut_at_every_byte);
+    return UNITY_END();
+}
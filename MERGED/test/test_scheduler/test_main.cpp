@@ -0,0 +1,183 @@
+// Host tests of the deadline scheduler on a fake clock: phase keeping,
+// lateness and skipped periods, earliest-deadline order, idle times and
+// the 32-bit millis() wrap (pio test -e native -f test_scheduler)
+#include <unity.h>
+
+#include <vector>
+
+#include "scheduler.h"
+
+// Start times of each job, by job slot
+std::vector<uint32_t> runs[4];
+
+void job0(uint32_t nowMs) { runs[0].push_back(nowMs); }
+void job1(uint32_t nowMs) { runs[1].push_back(nowMs); }
+void job2(uint32_t nowMs) { runs[2].push_back(nowMs); }
+
+// loop() through nowMs + forMs inclusive: run what is due, then sleep
+// exactly idleTime() (at least 1 ms)
+template <size_t N>
+void drive(Scheduler<N>& scheduler, uint32_t nowMs, uint32_t forMs, uint32_t maxIdleMs = 1000) {
+    uint32_t end = nowMs + forMs;
+    while ((int32_t)(end - nowMs) >= 0) {
+        scheduler.runDue(nowMs);
+        uint32_t idle = scheduler.idleTime(nowMs, maxIdleMs);
+        nowMs += idle == 0 ? 1 : idle;
+    }
+}
+
+void setUp() {
+    for (auto& r : runs) r.clear();
+}
+
+void tearDown() {}
+
+void test_jobs_run_on_their_deadlines() {
+    Scheduler<4> scheduler;
+    scheduler.every(1000, job0, 1000);
+    scheduler.every(7000, job1, 7000);
+    scheduler.every(2500, job2, 500);
+    drive(scheduler, 0, 3600000);
+
+    TEST_ASSERT_EQUAL_size_t(3600, runs[0].size());
+    TEST_ASSERT_EQUAL_size_t(514, runs[1].size());
+    TEST_ASSERT_EQUAL_size_t(1440, runs[2].size());
+    for (size_t i = 0; i < runs[0].size(); i++) TEST_ASSERT_EQUAL_UINT32((i + 1) * 1000, runs[0][i]);
+    for (size_t i = 0; i < runs[2].size(); i++) TEST_ASSERT_EQUAL_UINT32(500 + i * 2500, runs[2][i]);
+    TEST_ASSERT_EQUAL_UINT32(0, scheduler.maxLatenessMs());
+    TEST_ASSERT_EQUAL_UINT32(0, scheduler.skippedPeriods());
+}
+
+void test_late_run_keeps_phase() {
+    Scheduler<4> scheduler;
+    int id = scheduler.every(1000, job0, 1000);
+
+    // loop() got back 300 ms late
+    scheduler.runDue(1300);
+    TEST_ASSERT_EQUAL_UINT32(2000, scheduler.dueAt(id));
+    TEST_ASSERT_EQUAL_UINT32(300, scheduler.maxLatenessMs());
+    TEST_ASSERT_EQUAL_UINT32(700, scheduler.idleTime(1300, 5000));
+
+    scheduler.runDue(2000);
+    TEST_ASSERT_EQUAL_UINT32(3000, scheduler.dueAt(id));
+    TEST_ASSERT_EQUAL_UINT32(0, scheduler.skippedPeriods());
+}
+
+void test_stall_skips_whole_periods_once() {
+    Scheduler<4> scheduler;
+    int id = scheduler.every(1000, job0, 1000);
+
+    // A 3.5 s stall (TLS handshake): one catch-up run, not four
+    TEST_ASSERT_EQUAL_size_t(1, scheduler.runDue(4500));
+    TEST_ASSERT_EQUAL_size_t(0, scheduler.runDue(4500));
+    TEST_ASSERT_EQUAL_size_t(1, runs[0].size());
+    TEST_ASSERT_EQUAL_UINT32(3, scheduler.skippedPeriods());
+    TEST_ASSERT_EQUAL_UINT32(3500, scheduler.maxLatenessMs());
+    TEST_ASSERT_EQUAL_UINT32(5000, scheduler.dueAt(id));
+
+    scheduler.resetStats();
+    TEST_ASSERT_EQUAL_UINT32(0, scheduler.skippedPeriods());
+    TEST_ASSERT_EQUAL_UINT32(0, scheduler.maxLatenessMs());
+}
+
+void test_earliest_deadline_runs_first() {
+    Scheduler<4> scheduler;
+    scheduler.every(1000, job0, 900);
+    scheduler.every(1000, job1, 300);
+    scheduler.every(1000, job2, 600);
+    TEST_ASSERT_EQUAL_size_t(3, scheduler.runDue(1000));
+
+    // All ran in the same pass, at the same now, in deadline order
+    TEST_ASSERT_EQUAL_size_t(1, runs[0].size());
+    TEST_ASSERT_EQUAL_size_t(1, runs[1].size());
+    TEST_ASSERT_EQUAL_size_t(1, runs[2].size());
+    TEST_ASSERT_EQUAL_UINT32(700, scheduler.maxLatenessMs());
+}
+
+Scheduler<2>* selfArming = nullptr;
+int selfArmingId = Scheduler<2>::NO_JOB;
+void rearmNow(uint32_t nowMs) {
+    runs[0].push_back(nowMs);
+    selfArming->at(selfArmingId, nowMs);
+}
+
+void test_one_shot_and_self_rearm() {
+    Scheduler<2> scheduler;
+    selfArming = &scheduler;
+    selfArmingId = scheduler.once(rearmNow);
+    TEST_ASSERT_FALSE(scheduler.armed(selfArmingId));
+    TEST_ASSERT_EQUAL_size_t(0, scheduler.runDue(100));
+
+    scheduler.at(selfArmingId, 200);
+    // Re-arming for now runs again on the next pass, not in this one
+    TEST_ASSERT_EQUAL_size_t(1, scheduler.runDue(250));
+    TEST_ASSERT_TRUE(scheduler.armed(selfArmingId));
+    TEST_ASSERT_EQUAL_size_t(1, scheduler.runDue(250));
+    TEST_ASSERT_EQUAL_size_t(2, runs[0].size());
+
+    scheduler.cancel(selfArmingId);
+    TEST_ASSERT_EQUAL_size_t(0, scheduler.runDue(300));
+    TEST_ASSERT_EQUAL_UINT32(1000, scheduler.idleTime(300, 1000));
+}
+
+void test_idle_time() {
+    Scheduler<4> scheduler;
+    TEST_ASSERT_EQUAL_UINT32(1000, scheduler.idleTime(0, 1000));
+    scheduler.every(5000, job0, 5000);
+    int oneShot = scheduler.once(job1);
+    scheduler.at(oneShot, 1200);
+
+    TEST_ASSERT_EQUAL_UINT32(1000, scheduler.idleTime(0, 1000));
+    TEST_ASSERT_EQUAL_UINT32(200, scheduler.idleTime(1000, 1000));
+    TEST_ASSERT_EQUAL_UINT32(0, scheduler.idleTime(1200, 1000));
+    TEST_ASSERT_EQUAL_UINT32(0, scheduler.idleTime(1500, 1000));
+    scheduler.runDue(1500);
+    TEST_ASSERT_EQUAL_UINT32(3500, scheduler.idleTime(1500, 10000));
+}
+
+void test_deadlines_across_millis_wrap() {
+    Scheduler<4> scheduler;
+    const uint32_t start = 0xFFFFFFFFu - 4500;     // 4.5 s before the wrap
+    int id = scheduler.every(1000, job0, start + 1000);
+    scheduler.every(3000, job1, start + 3000);
+
+    drive(scheduler, start, 10000);
+    TEST_ASSERT_EQUAL_size_t(10, runs[0].size());
+    TEST_ASSERT_EQUAL_size_t(3, runs[1].size());
+    for (size_t i = 0; i < runs[0].size(); i++) TEST_ASSERT_EQUAL_UINT32((uint32_t)(start + (i + 1) * 1000), runs[0][i]);
+    TEST_ASSERT_EQUAL_UINT32(0, scheduler.maxLatenessMs());
+
+    // Deadline just past the wrap, clock just before it
+    scheduler.at(id, 5);
+    TEST_ASSERT_EQUAL_UINT32(15, scheduler.idleTime(0xFFFFFFF6u, 1000));
+    TEST_ASSERT_EQUAL_size_t(0, scheduler.runDue(0xFFFFFFF6u));
+    TEST_ASSERT_EQUAL_size_t(1, scheduler.runDue(5));
+    TEST_ASSERT_EQUAL_UINT32(1005, scheduler.dueAt(id));
+}
+
+void test_full_scheduler_rejects_jobs() {
+    Scheduler<2> scheduler;
+    TEST_ASSERT_NOT_EQUAL(Scheduler<2>::NO_JOB, scheduler.every(1000, job0, 0));
+    TEST_ASSERT_EQUAL_INT(Scheduler<2>::NO_JOB, scheduler.once(nullptr));
+    TEST_ASSERT_NOT_EQUAL(Scheduler<2>::NO_JOB, scheduler.once(job1));
+    TEST_ASSERT_EQUAL_INT(Scheduler<2>::NO_JOB, scheduler.once(job2));
+
+    // Unknown ids are ignored
+    scheduler.at(7, 0);
+    scheduler.cancel(-1);
+    TEST_ASSERT_FALSE(scheduler.armed(7));
+    TEST_ASSERT_EQUAL_UINT32(0, scheduler.dueAt(7));
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_jobs_run_on_their_deadlines);
+    RUN_TEST(test_late_run_keeps_phase);
+    RUN_TEST(test_stall_skips_whole_periods_once);
+    RUN_TEST(test_earliest_deadline_runs_first);
+    RUN_TEST(test_one_shot_and_self_rearm);
+    RUN_TEST(test_idle_time);
+    RUN_TEST(test_deadlines_across_millis_wrap);
+    RUN_TEST(test_full_scheduler_rejects_jobs);
+    return UNITY_END();
+}
@@ -0,0 +1,148 @@
+// Host tests of swinging-door compression: every offered sample must be
+// reconstructed within its channel's error bound by interpolating between
+// the kept ones, heartbeats included
+#include <unity.h>
+
+#include <math.h>
+#include <vector>
+
+#include "swinging_door.h"
+
+typedef SwingingDoor<2> Door;
+typedef Door::Sample Sample;
+
+const float BOUNDS[2] = { 0.1f, 0.1f };
+const uint32_t MAX_SILENCE = 300000;
+// Float slack on top of the bound
+const float SLACK = 1e-3f;
+
+struct Compressed {
+    std::vector<Sample> offered;
+    std::vector<Sample> kept;
+};
+
+Compressed compress(Door& door, uint32_t count, uint32_t stepMs, void (*signal)(uint32_t ms, float* out)) {
+    Compressed c;
+    for (uint32_t i = 0; i < count; i++) {
+        Sample sample = { i * stepMs, { 0, 0 } };
+        signal(sample.timeMs, sample.values);
+        Sample out;
+        if (door.offer(sample, out)) c.kept.push_back(out);
+        c.offered.push_back(sample);
+    }
+    // The tail is reconstructed up to the sample still pending
+    Sample last;
+    if (door.pending(last)) c.kept.push_back(last);
+    return c;
+}
+
+// Largest |reconstructed - offered| over channel c
+float worstError(const Compressed& c, size_t channel) {
+    float worst = 0;
+    size_t k = 0;
+    for (const Sample& s : c.offered) {
+        while (k + 1 < c.kept.size() && c.kept[k + 1].timeMs < s.timeMs) k++;
+        const Sample& a = c.kept[k];
+        const Sample& b = k + 1 < c.kept.size() ? c.kept[k + 1] : a;
+        float v = a.values[channel];
+        if (b.timeMs != a.timeMs) {
+            v += (b.values[channel] - a.values[channel]) * (float)(s.timeMs - a.timeMs) / (float)(b.timeMs - a.timeMs);
+        }
+        float error = fabsf(v - s.values[channel]);
+        if (error > worst) worst = error;
+    }
+    return worst;
+}
+
+uint32_t longestGap(const Compressed& c) {
+    uint32_t gap = 0;
+    for (size_t i = 1; i < c.kept.size(); i++) {
+        if (c.kept[i].timeMs - c.kept[i - 1].timeMs > gap) gap = c.kept[i].timeMs - c.kept[i - 1].timeMs;
+    }
+    return gap;
+}
+
+void steady(uint32_t, float* out) { out[0] = 21.0f; out[1] = 45.0f; }
+void ramp(uint32_t ms, float* out) { out[0] = 20.0f + ms / 600000.0f; out[1] = 45.0f - ms / 300000.0f; }
+// Flat, then +3 °C / -6 %RH exactly when the first heartbeat falls due
+void stepAtHeartbeat(uint32_t ms, float* out) {
+    out[0] = ms < MAX_SILENCE ? 21.0f : 24.0f;
+    out[1] = ms < MAX_SILENCE ? 45.0f : 39.0f;
+}
+// Same, one sample before the heartbeat
+void stepBeforeHeartbeat(uint32_t ms, float* out) {
+    out[0] = ms < MAX_SILENCE - 2000 ? 21.0f : 24.0f;
+    out[1] = 45.0f;
+}
+void noisySwing(uint32_t ms, float* out) {
+    uint32_t i = ms / 2000;
+    float noise = (float)((i * 2654435761u) >> 16 & 0xFF) / 255.0f - 0.5f;
+    out[0] = 21.0f + 2.0f * sinf(ms / 900000.0f) + noise * 0.3f;
+    out[1] = 45.0f + 5.0f * cosf(ms / 1300000.0f) - noise * 0.2f;
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_first_sample_is_kept() {
+    Door door(BOUNDS, MAX_SILENCE);
+    Sample sample = { 1000, { 21.0f, 45.0f } }, out;
+    TEST_ASSERT_TRUE(door.offer(sample, out));
+    TEST_ASSERT_EQUAL_UINT32(1000, out.timeMs);
+}
+
+void test_steady_signal_keeps_only_heartbeats() {
+    Door door(BOUNDS, MAX_SILENCE);
+    Compressed c = compress(door, 1800, 2000, steady);     // one hour
+    // First sample, 11 heartbeats and the pending tail
+    TEST_ASSERT_EQUAL_size_t(13, c.kept.size());
+    TEST_ASSERT_EQUAL_UINT32(MAX_SILENCE, longestGap(c));
+}
+
+void test_ramp_keeps_heartbeats_only() {
+    Door door(BOUNDS, MAX_SILENCE);
+    Compressed c = compress(door, 1800, 2000, ramp);
+    TEST_ASSERT_LESS_OR_EQUAL(0.1f + SLACK, worstError(c, 0));
+    TEST_ASSERT_LESS_OR_EQUAL(0.1f + SLACK, worstError(c, 1));
+    TEST_ASSERT_EQUAL_size_t(13, c.kept.size());
+}
+
+void test_step_at_heartbeat_stays_within_bounds() {
+    Door door(BOUNDS, MAX_SILENCE);
+    Compressed c = compress(door, 300, 2000, stepAtHeartbeat);
+    TEST_ASSERT_LESS_OR_EQUAL(0.1f + SLACK, worstError(c, 0));
+    TEST_ASSERT_LESS_OR_EQUAL(0.1f + SLACK, worstError(c, 1));
+
+    // The last flat sample goes out as the corner of the step
+    bool corner = false;
+    for (const Sample& s : c.kept) corner |= s.timeMs == MAX_SILENCE - 2000 && s.values[0] == 21.0f;
+    TEST_ASSERT_TRUE(corner);
+}
+
+void test_step_before_heartbeat_stays_within_bounds() {
+    Door door(BOUNDS, MAX_SILENCE);
+    Compressed c = compress(door, 300, 2000, stepBeforeHeartbeat);
+    TEST_ASSERT_LESS_OR_EQUAL(0.1f + SLACK, worstError(c, 0));
+    TEST_ASSERT_LESS_OR_EQUAL(0.1f + SLACK, worstError(c, 1));
+}
+
+void test_noisy_signal_stays_within_bounds() {
+    Door door(BOUNDS, MAX_SILENCE);
+    Compressed c = compress(door, 5400, 2000, noisySwing);    // three hours
+    TEST_ASSERT_LESS_OR_EQUAL(0.1f + SLACK, worstError(c, 0));
+    TEST_ASSERT_LESS_OR_EQUAL(0.1f + SLACK, worstError(c, 1));
+    // A heartbeat can wait for the sample after maxSilence
+    TEST_ASSERT_LESS_OR_EQUAL(MAX_SILENCE + 2000, longestGap(c));
+    TEST_ASSERT_LESS_THAN(c.offered.size(), c.kept.size());
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_first_sample_is_kept);
+    RUN_TEST(test_steady_signal_keeps_only_heartbeats);
+    RUN_TEST(test_ramp_keeps_heartbeats_only);
+    RUN_TEST(test_step_at_heartbeat_stays_within_bounds);
+    RUN_TEST(test_step_before_heartbeat_stays_within_bounds);
+    RUN_TEST(test_noisy_signal_stays_within_bounds);
+    return UNITY_END();
+}
@@ -0,0 +1,188 @@
+// Host tests of the Wi-Fi reconnect state machine with a fake driver
+// and the shim's fake clock: timeouts, backoff growth and cap, jitter
+// across a fleet, and recovery when the access point returns
+#include <unity.h>
+
+#include <Arduino.h>
+
+#include "wifi_reconnect.h"
+
+// Associates connectMs after begin() while the access point is up
+struct FakeWiFiDriver {
+    bool apUp = true;
+    uint32_t connectMs = 800;
+    uint32_t begins = 0;
+    uint32_t disconnects = 0;
+    bool associating = false;
+    uint32_t startedMs = 0;
+
+    void begin() {
+        begins++;
+        associating = true;
+        startedMs = millis();
+    }
+    void disconnect() {
+        disconnects++;
+        associating = false;
+    }
+};
+
+typedef WiFiReconnect<FakeWiFiDriver> Link;
+typedef Link::State State;
+
+// Delivers the driver's link event like the Wi-Fi event task would
+void deliverEvents(FakeWiFiDriver& driver, Link& link) {
+    if (driver.associating && driver.apUp && millis() - driver.startedMs >= driver.connectMs) {
+        driver.associating = false;
+        link.onConnected();
+    }
+}
+
+// loop() for ms of fake time, polling every 100 ms
+void run(FakeWiFiDriver& driver, Link& link, uint32_t ms) {
+    for (uint32_t t = 0; t < ms; t += 100) {
+        deliverEvents(driver, link);
+        link.poll(millis());
+        FakeClock::advanceMs(100);
+    }
+}
+
+void setUp() { FakeClock::reset(); }
+void tearDown() {}
+
+void test_connects_on_first_attempt() {
+    FakeWiFiDriver driver;
+    Link link(driver, WiFiReconnectConfig());
+    link.poll(millis());
+    TEST_ASSERT_EQUAL(State::Connecting, link.state());
+    TEST_ASSERT_EQUAL_UINT32(1, driver.begins);
+
+    run(driver, link, 1000);
+    TEST_ASSERT_TRUE(link.connected());
+    TEST_ASSERT_EQUAL_UINT32(1, driver.begins);
+    TEST_ASSERT_EQUAL_UINT32(0, link.failures());
+}
+
+void test_attempt_times_out_into_backoff() {
+    FakeWiFiDriver driver;
+    driver.apUp = false;
+    Link link(driver, WiFiReconnectConfig());
+    link.poll(millis());
+
+    FakeClock::advanceMs(14999);
+    link.poll(millis());
+    TEST_ASSERT_EQUAL(State::Connecting, link.state());
+
+    FakeClock::advanceMs(1);
+    link.poll(millis());
+    TEST_ASSERT_EQUAL(State::Backoff, link.state());
+    TEST_ASSERT_EQUAL_UINT32(1, driver.disconnects);
+    TEST_ASSERT_EQUAL_UINT32(1, link.failures());
+    // First backoff: initialBackoffMs with the upper half randomised
+    uint32_t wait = link.retryAtMs() - millis();
+    TEST_ASSERT_TRUE(wait >= 250 && wait <= 500);
+}
+
+void test_backoff_doubles_up_to_the_cap() {
+    FakeWiFiDriver driver;
+    WiFiReconnectConfig config;
+    Link link(driver, config, 7);
+
+    uint32_t base = config.initialBackoffMs;
+    for (int failure = 1; failure <= 12; failure++) {
+        link.poll(millis());                            // starts an attempt
+        FakeClock::advanceMs(config.connectTimeoutMs);
+        link.poll(millis());                            // times out
+        TEST_ASSERT_EQUAL(State::Backoff, link.state());
+
+        uint32_t wait = link.retryAtMs() - millis();
+        TEST_ASSERT_TRUE_MESSAGE(wait >= base / 2 && wait <= base, "backoff outside [base/2, base]");
+        FakeClock::advanceMs(wait);
+        base = base * 2 > config.maxBackoffMs ? config.maxBackoffMs : base * 2;
+    }
+    TEST_ASSERT_EQUAL_UINT32(12, link.failures());
+}
+
+void test_dropped_link_retries_at_once() {
+    FakeWiFiDriver driver;
+    Link link(driver, WiFiReconnectConfig());
+    run(driver, link, 1000);
+    TEST_ASSERT_TRUE(link.connected());
+
+    link.onDisconnected();
+    link.poll(millis());
+    TEST_ASSERT_EQUAL(State::Connecting, link.state());
+    TEST_ASSERT_EQUAL_UINT32(2, driver.begins);
+    TEST_ASSERT_EQUAL_UINT32(1, link.drops());
+
+    run(driver, link, 1000);
+    TEST_ASSERT_TRUE(link.connected());
+}
+
+void test_disconnect_event_cuts_an_attempt_short() {
+    FakeWiFiDriver driver;
+    driver.apUp = false;
+    Link link(driver, WiFiReconnectConfig());
+    link.poll(millis());
+    FakeClock::advanceMs(2000);
+    link.onDisconnected();      // wrong password, AP not found...
+    link.poll(millis());
+    TEST_ASSERT_EQUAL(State::Backoff, link.state());
+}
+
+void test_recovers_soon_after_a_long_outage() {
+    FakeWiFiDriver driver;
+    WiFiReconnectConfig config;
+    driver.apUp = false;
+    Link link(driver, config);
+    run(driver, link, 30 * 60000);
+    TEST_ASSERT_FALSE(link.connected());
+    // Capped backoff plus the attempt timeout: one attempt per 45-75 s
+    TEST_ASSERT_LESS_THAN(50, driver.begins);
+
+    driver.apUp = true;
+    uint32_t upAt = millis();
+    while (!link.connected() && millis() - upAt < 120000) run(driver, link, 100);
+    TEST_ASSERT_TRUE(link.connected());
+    TEST_ASSERT_LESS_OR_EQUAL_UINT32(config.maxBackoffMs + config.connectTimeoutMs, millis() - upAt);
+    TEST_ASSERT_EQUAL_UINT32(0, link.failures());
+}
+
+void test_fleet_retries_are_spread() {
+    // 100 boards lose the AP at the same instant
+    const int FLEET = 100;
+    uint32_t retryAt[FLEET];
+    for (int i = 0; i < FLEET; i++) {
+        FakeClock::reset();
+        FakeWiFiDriver driver;
+        driver.apUp = false;
+        Link link(driver, WiFiReconnectConfig(), 1000 + i);
+        for (int failure = 0; failure < 6; failure++) {
+            link.poll(millis());
+            FakeClock::advanceMs(15000);
+            link.poll(millis());
+            FakeClock::advanceMs(link.retryAtMs() - millis());
+        }
+        retryAt[i] = millis();
+    }
+
+    // Six randomised backoffs in, the boards should be seconds apart
+    uint32_t lo = retryAt[0], hi = retryAt[0];
+    for (int i = 1; i < FLEET; i++) {
+        if (retryAt[i] < lo) lo = retryAt[i];
+        if (retryAt[i] > hi) hi = retryAt[i];
+    }
+    TEST_ASSERT_GREATER_THAN(10000, hi - lo);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_connects_on_first_attempt);
+    RUN_TEST(test_attempt_times_out_into_backoff);
+    RUN_TEST(test_backoff_doubles_up_to_the_cap);
+    RUN_TEST(test_dropped_link_retries_at_once);
+    RUN_TEST(test_disconnect_event_cuts_an_attempt_short);
+    RUN_TEST(test_recovers_soon_after_a_long_outage);
+    RUN_TEST(test_fleet_retries_are_spread);
+    return UNITY_END();
+}
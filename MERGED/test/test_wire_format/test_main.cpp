@@ -0,0 +1,127 @@
+// Host tests of the binary upload format. GOLDEN is also decoded by
+// test/api/wire.test.js, so a change on either side breaks one of them.
+#include <unity.h>
+
+#include "json_codec.h"
+#include "wire_format.h"
+
+// Device 0x01020304, batch 7: two readings 2 s apart, one unstamped,
+// one stamped 500 ms before the previous stamped one
+const uint8_t GOLDEN[] = {
+    0x43, 0x43, 0x02, 0x04, 0x04, 0x03, 0x02, 0x01, 0x07, 0x00, 0x00, 0x00, 0x00, 0x6c, 0x50, 0xc4,
+    0xa0, 0x01, 0x00, 0x00, 0x66, 0x08, 0xad, 0x11, 0x01, 0xcd, 0xfe, 0x0f, 0x27, 0xa1, 0x1f, 0x98,
+    0x08, 0xa0, 0x0f, 0x00, 0xa2, 0x08, 0xaa, 0x0f, 0xe8, 0x07,
+};
+
+const Reading BATCH[] = {
+    { 21.5f, 45.25f, 0, 1790000000000LL },
+    { -3.07f, 99.99f, 2000, 1790000002000LL },
+    { 22.0f, 40.0f, 4000, 0 },
+    { 22.1f, 40.1f, 6000, 1790000001500LL },
+};
+
+size_t encode(const Reading* batch, size_t count, uint8_t* out, size_t size) {
+    WireEncoder encoder(out, size, 0x01020304, 7);
+    for (size_t i = 0; i < count; i++) {
+        if (!encoder.add(batch[i].temperature, batch[i].humidity, batch[i].epochMs)) break;
+    }
+    return encoder.length();
+}
+
+// A 2 s cadence like the firmware's, all stamped
+void tenReadings(Reading (&batch)[10]) {
+    for (size_t i = 0; i < 10; i++) {
+        batch[i] = { 21.0f + i * 0.13f, 45.0f - i * 0.27f, (uint32_t)i * 2000, 1790000000000LL + (int64_t)i * 2000 };
+    }
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_matches_golden_bytes() {
+    uint8_t out[64];
+    size_t length = encode(BATCH, 4, out, sizeof(out));
+    TEST_ASSERT_EQUAL_size_t(sizeof(GOLDEN), length);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(GOLDEN, out, length);
+}
+
+void test_header_fields() {
+    uint8_t out[64];
+    WireEncoder encoder(out, sizeof(out), 0xdeadbeef, 0x01000000);
+    TEST_ASSERT_EQUAL_size_t(WIRE_HEADER_SIZE, encoder.length());
+    TEST_ASSERT_EQUAL_size_t(0, encoder.count());
+    TEST_ASSERT_EQUAL_HEX8(0xef, out[4]);
+    TEST_ASSERT_EQUAL_HEX8(0xde, out[7]);
+    TEST_ASSERT_EQUAL_HEX8(0x01, out[11]);
+    // No stamped reading yet: base 0
+    for (size_t i = 12; i < 20; i++) TEST_ASSERT_EQUAL_HEX8(0, out[i]);
+}
+
+void test_two_second_cadence_costs_two_bytes_of_time() {
+    Reading batch[10];
+    tenReadings(batch);
+    uint8_t out[256];
+    size_t length = encode(batch, 10, out, sizeof(out));
+    // First reading: delta 0 (one byte), the rest 2000 ms (two bytes)
+    TEST_ASSERT_EQUAL_size_t(WIRE_HEADER_SIZE + 10 * WIRE_READING_SIZE + 1 + 9 * 2, length);
+    TEST_ASSERT_LESS_OR_EQUAL(wireEncodedSize(10), length);
+}
+
+void test_values_are_clamped() {
+    uint8_t out[64];
+    WireEncoder encoder(out, sizeof(out), 1, 1);
+    TEST_ASSERT_TRUE(encoder.add(400.0f, -5.0f));
+    TEST_ASSERT_TRUE(encoder.add(-400.0f, 900.0f));
+    TEST_ASSERT_EQUAL_HEX8(0xff, out[20]);      // 32767
+    TEST_ASSERT_EQUAL_HEX8(0x7f, out[21]);
+    TEST_ASSERT_EQUAL_HEX8(0x00, out[22]);      // 0
+    TEST_ASSERT_EQUAL_HEX8(0x00, out[23]);
+    TEST_ASSERT_EQUAL_HEX8(0x00, out[24]);      // unstamped
+    TEST_ASSERT_EQUAL_HEX8(0x00, out[25]);      // -32768
+    TEST_ASSERT_EQUAL_HEX8(0x80, out[26]);
+    TEST_ASSERT_EQUAL_HEX8(0xff, out[27]);      // 65535
+    TEST_ASSERT_EQUAL_HEX8(0xff, out[28]);
+}
+
+void test_full_buffer_rejects_and_keeps_what_fits() {
+    uint8_t out[WIRE_HEADER_SIZE + 2 * (WIRE_READING_SIZE + 2)];
+    WireEncoder encoder(out, sizeof(out), 1, 1);
+    TEST_ASSERT_TRUE(encoder.add(1.0f, 1.0f, 1790000000000LL));
+    TEST_ASSERT_TRUE(encoder.add(2.0f, 2.0f, 1790000002000LL));
+    size_t length = encoder.length();
+    TEST_ASSERT_FALSE(encoder.add(3.0f, 3.0f, 1790000004000LL));
+    TEST_ASSERT_EQUAL_size_t(length, encoder.length());
+    TEST_ASSERT_EQUAL_size_t(2, encoder.count());
+
+    uint8_t tiny[WIRE_HEADER_SIZE - 1];
+    WireEncoder none(tiny, sizeof(tiny), 1, 1);
+    TEST_ASSERT_FALSE(none.add(1.0f, 1.0f));
+    TEST_ASSERT_EQUAL_size_t(0, none.length());
+}
+
+void test_size_against_json() {
+    Reading batch[10];
+    tenReadings(batch);
+    uint8_t wire[256];
+    char json[1024];
+    size_t wireLength = encode(batch, 10, wire, sizeof(wire));
+    size_t jsonLength = encodeJsonBatch<10>(batch, 10, json, sizeof(json));
+
+    char line[80];
+    snprintf(line, sizeof(line), "10 readings: binary %u bytes, JSON %u bytes",
+             (unsigned)wireLength, (unsigned)jsonLength);
+    TEST_MESSAGE(line);
+    TEST_ASSERT_GREATER_THAN(0, jsonLength);
+    TEST_ASSERT_LESS_THAN(jsonLength / 5, wireLength);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_matches_golden_bytes);
+    RUN_TEST(test_header_fields);
+    RUN_TEST(test_two_second_cadence_costs_two_bytes_of_time);
+    RUN_TEST(test_values_are_clamped);
+    RUN_TEST(test_full_buffer_rejects_and_keeps_what_fits);
+    RUN_TEST(test_size_against_json);
+    return UNITY_END();
+}
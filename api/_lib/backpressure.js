@@ -0,0 +1,55 @@
+// /api/_lib/backpressure.js
+// Load-shedding hints for devices. The firmware (rate_controller.h) waits
+// out Retry-After on 429/503 and backs off exponentially on other 5xx, so
+// answering 503 + Retry-After during an incident spreads the fleet's
+// retries instead of having every board hammer us at its normal rate.
+//
+//   INGEST_RETRY_AFTER_S=120   incident switch: /api/sensor answers 503 with
+//                              this Retry-After without touching the database
+//   RATE_LIMITS={"version":2,"min_sample_ms":5000,"max_sample_ms":120000,
+//                "min_upload_ms":30000}
+//                              pushed to devices with every upload response;
+//                              they store it and apply it once per version
+
+// Retry-After for transient database failures
+const DB_RETRY_AFTER_S = 30;
+
+function sendUnavailable(res, retryAfterS, error) {
+  res.setHeader('Retry-After', String(retryAfterS));
+  return res.status(503).json({ error });
+}
+
+// Seconds devices are asked to stay away, or 0 when ingest is open
+function ingestPause() {
+  const seconds = Number(process.env.INGEST_RETRY_AFTER_S);
+  return Number.isInteger(seconds) && seconds > 0 ? seconds : 0;
+}
+
+const LIMIT_FIELDS = ['min_sample_ms', 'max_sample_ms', 'min_upload_ms'];
+let parsedFrom;
+let parsedLimits = null;
+
+// The RATE_LIMITS object, or null when unset or invalid (logged once)
+function rateLimits() {
+  const raw = process.env.RATE_LIMITS;
+  if (raw === parsedFrom) return parsedLimits;
+  parsedFrom = raw;
+  parsedLimits = null;
+  if (!raw) return null;
+
+  try {
+    const value = JSON.parse(raw);
+    const valid = Number.isInteger(value.version) && value.version > 0
+      && LIMIT_FIELDS.every(k => value[k] === undefined || (Number.isInteger(value[k]) && value[k] >= 0));
+    if (!valid) throw new Error('needs a positive integer version and integer ms fields');
+    parsedLimits = { version: value.version };
+    for (const k of LIMIT_FIELDS) {
+      if (value[k] !== undefined) parsedLimits[k] = value[k];
+    }
+  } catch (e) {
+    console.error('Ignoring RATE_LIMITS:', e.message);
+  }
+  return parsedLimits;
+}
+
+module.exports = { DB_RETRY_AFTER_S, sendUnavailable, ingestPause, rateLimits };
@@ -0,0 +1,54 @@
+// /api/_lib/delay_store.js
+// Versioned storage for the LED delay used by /api/delay.
+// Both stores expose the same interface:
+//   get()      -> { delay, version }
+//   set(delay) -> { delay, version }   (version strictly increases)
+// The Supabase store is shared by all instances
+// (supabase/migrations/*_control_state.sql); the memory store is a local
+// stand-in for development and tests when SUPABASE_KEY is not set.
+
+const { getSupabase } = require('./supabase');
+
+const DEFAULT_DELAY = 500;
+
+function createMemoryStore(initialDelay = DEFAULT_DELAY) {
+  let state = { delay: initialDelay, version: 1 };
+  return {
+    async get() {
+      return state;
+    },
+    async set(delay) {
+      state = { delay, version: state.version + 1 };
+      return state;
+    },
+  };
+}
+
+function createSupabaseStore(supabase) {
+  return {
+    async get() {
+      const { data, error } = await supabase
+        .from('control_state')
+        .select('delay, version')
+        .eq('key', 'delay')
+        .maybeSingle();
+      if (error) throw new Error(error.message);
+      return data
+        ? { delay: data.delay, version: Number(data.version) }
+        : { delay: DEFAULT_DELAY, version: 0 };
+    },
+    async set(delay) {
+      const { data, error } = await supabase.rpc('set_delay', { p_delay: delay });
+      if (error) throw new Error(error.message);
+      const row = Array.isArray(data) ? data[0] : data;
+      return { delay: row.delay, version: Number(row.version) };
+    },
+  };
+}
+
+function createDelayStore() {
+  const supabase = getSupabase();
+  return supabase ? createSupabaseStore(supabase) : createMemoryStore();
+}
+
+module.exports = { createDelayStore, createMemoryStore, createSupabaseStore };
@@ -0,0 +1,35 @@
+// /api/_lib/http_cache.js
+// ETag / Cache-Control helpers shared by the read endpoints.
+const crypto = require('crypto');
+
+// Accepts `"7"`, `W/"7"` and comma-separated lists
+function matchesEtag(header, etag) {
+  if (!header) return false;
+  if (header.trim() === '*') return true;
+  return header.split(',').some(tag => tag.trim().replace(/^W\//, '') === etag);
+}
+
+function etagOf(body) {
+  return `"${crypto.createHash('sha1').update(body).digest('base64url').slice(0, 16)}"`;
+}
+
+// Sends `value` as JSON with an ETag and a Cache-Control policy the CDN can
+// serve from: fresh for sMaxAge seconds, then served stale for up to
+// staleSeconds while it revalidates in the background. Browsers always
+// revalidate (max-age=0) and get a bodyless 304 when nothing changed.
+function sendCached(req, res, value, { sMaxAge, staleSeconds }) {
+  const body = JSON.stringify(value);
+  const etag = etagOf(body);
+
+  res.setHeader('ETag', etag);
+  res.setHeader('Cache-Control',
+    `public, max-age=0, s-maxage=${sMaxAge}, stale-while-revalidate=${staleSeconds}`);
+
+  if (matchesEtag(req.headers['if-none-match'], etag)) {
+    return res.status(304).end();
+  }
+  res.setHeader('Content-Type', 'application/json; charset=utf-8');
+  res.status(200).send(body);
+}
+
+module.exports = { matchesEtag, etagOf, sendCached };
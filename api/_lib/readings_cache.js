@@ -0,0 +1,149 @@
+// /api/_lib/readings_cache.js
+// In-process cache of the newest reading and the recent history, shared by
+// /api/latest and /api/history within one function instance.
+//
+// Stale-while-revalidate: a value younger than freshMs is served as is; up
+// to staleMs past that it is still served, while one background query
+// refreshes it; older (or missing) values wait for the query. Concurrent
+// misses share a single query. Devices upload every couple of seconds, so
+// a 2 s freshness window costs at most one upload of lag.
+//
+// Backends expose:
+//   latest()      -> { temperature, humidity, recorded_at, device_recorded_at } | null
+//   recent(limit) -> rows, newest first
+// "Newest" is by observed_at, the time the reading was taken, like the
+// history pages: rows a board drains from its offline log hours late
+// are not the latest reading (supabase/migrations/*_readings_observed_at.sql)
+const { getSupabase } = require('./supabase');
+
+const FRESH_MS = 2000;
+const STALE_MS = 30000;
+const RECENT_LIMIT = 50;
+
+function createSwr(load, { freshMs, staleMs }) {
+  let entry = null;       // { value, at }
+  let inflight = null;
+
+  function refresh() {
+    if (!inflight) {
+      const pending = load()
+        .then((value) => {
+          // Dropped by invalidate() meanwhile: the result may predate it
+          if (inflight === pending) entry = { value, at: Date.now() };
+          return value;
+        })
+        .finally(() => {
+          if (inflight === pending) inflight = null;
+        });
+      inflight = pending;
+    }
+    return inflight;
+  }
+
+  return {
+    async get() {
+      const age = entry ? Date.now() - entry.at : Infinity;
+      if (age < freshMs) return entry.value;
+      if (age < freshMs + staleMs) {
+        refresh().catch(e => console.error('Read cache refresh failed:', e.message));
+        return entry.value;
+      }
+      return refresh();
+    },
+    invalidate() {
+      entry = null;
+      inflight = null;
+    },
+  };
+}
+
+function createReadingsCache(backend, { freshMs = FRESH_MS, staleMs = STALE_MS } = {}) {
+  const latest = createSwr(() => backend.latest(), { freshMs, staleMs });
+  const recent = createSwr(() => backend.recent(RECENT_LIMIT), { freshMs, staleMs });
+
+  return {
+    latest: () => latest.get(),
+    recent: () => recent.get(),
+    // A reading was stored through this instance
+    invalidate() {
+      latest.invalidate();
+      recent.invalidate();
+    },
+  };
+}
+
+function createSupabaseBackend(supabase) {
+  return {
+    async latest() {
+      const { data, error } = await supabase
+        .from('readings')
+        .select('temperature, humidity, recorded_at, device_recorded_at')
+        .order('observed_at', { ascending: false })
+        .order('id', { ascending: false })
+        .limit(1);
+      if (error) throw new Error(error.message);
+      return data?.[0] || null;
+    },
+    async recent(limit) {
+      const { data, error } = await supabase
+        .from('readings')
+        .select('id, recorded_at, device_recorded_at, temperature, humidity')
+        .order('observed_at', { ascending: false })
+        .order('id', { ascending: false })
+        .limit(limit);
+      if (error) throw new Error(error.message);
+      return data || [];
+    },
+  };
+}
+
+// Local stand-in for the readings table; latencyMs simulates the
+// database round trip and `queries` counts what reached it
+function createMemoryBackend({ latencyMs = 0 } = {}) {
+  const rows = [];
+  const delay = () => new Promise(resolve => setTimeout(resolve, latencyMs));
+
+  return {
+    queries: 0,
+    insert(temperature, humidity) {
+      rows.unshift({ recorded_at: new Date().toISOString(), temperature, humidity });
+    },
+    async latest() {
+      this.queries++;
+      await delay();
+      return rows[0] || null;
+    },
+    async recent(limit) {
+      this.queries++;
+      await delay();
+      return rows.slice(0, limit);
+    },
+  };
+}
+
+let shared = null;
+
+// Cache for this instance, or null when SUPABASE_KEY is not set
+function readingsCache() {
+  if (!shared) {
+    const supabase = getSupabase();
+    if (!supabase) return null;
+    shared = createReadingsCache(createSupabaseBackend(supabase));
+  }
+  return shared;
+}
+
+// Replaces the shared cache's backend (local stand-ins, benchmarks)
+function useReadingsBackend(backend, options) {
+  shared = createReadingsCache(backend, options);
+  return shared;
+}
+
+module.exports = {
+  RECENT_LIMIT,
+  createReadingsCache,
+  createSupabaseBackend,
+  createMemoryBackend,
+  readingsCache,
+  useReadingsBackend,
+};
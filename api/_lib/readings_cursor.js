@@ -0,0 +1,40 @@
+// /api/_lib/readings_cursor.js
+// Position in the readings by (observed_at, id), shared by /api/history
+// pages and the /api/stream catch-up (Last-Event-ID).
+//
+// "<observed_at>|<id>", the timestamp as the database returned it
+// (microseconds kept). A bare timestamp is what older clients send.
+// observed_at is the device's capture time (device_recorded_at), or the
+// server's insert time (recorded_at) for readings without one
+// (supabase/migrations/*_readings_observed_at.sql).
+const CURSOR_RE = /^(\d{4}-\d{2}-\d{2}T\d{2}:\d{2}:\d{2}(?:\.\d{1,6})?(?:Z|[+-]\d{2}(?::?\d{2})?))(?:\|(\d{1,18}))?$/;
+
+// { at, id } from a cursor, undefined when absent, null when malformed.
+// The timestamp is passed on as sent: a Date would cut it to milliseconds
+function parseCursor(value) {
+  if (value === undefined) return undefined;
+  const m = CURSOR_RE.exec(value);
+  if (!m || Number.isNaN(new Date(m[1]).getTime())) return null;
+  return { at: m[1], id: m[2] === undefined ? null : m[2] };
+}
+
+// observed_at of a row; realtime payloads leave out the generated column
+function observedAt(row) {
+  return row.observed_at ?? row.device_recorded_at ?? row.recorded_at;
+}
+
+function formatCursor(row) {
+  return `${observedAt(row)}|${row.id}`;
+}
+
+// Whether row comes after cursor in (observed_at, id) order. Instants
+// compare at millisecond precision here, so a row in the cursor's
+// millisecond counts as after it unless its id is not above the cursor's
+function isAfter(row, cursor) {
+  const rowMs = Date.parse(observedAt(row));
+  const cursorMs = Date.parse(cursor.at);
+  if (rowMs !== cursorMs) return rowMs > cursorMs;
+  return cursor.id === null || Number(row.id) > Number(cursor.id);
+}
+
+module.exports = { parseCursor, observedAt, formatCursor, isAfter };
@@ -0,0 +1,25 @@
+// /api/_lib/supabase.js
+// One Supabase client per function instance. Warm invocations reuse it
+// (and its HTTP agent) instead of building a new client per request.
+const SUPABASE_URL = process.env.SUPABASE_URL || 'https://uappuwebcylzwndfaqxo.supabase.co';
+
+let client = null;
+
+// Returns the shared client, or null when SUPABASE_KEY is not set
+function getSupabase() {
+  if (!process.env.SUPABASE_KEY) return null;
+  if (!client) {
+    const { createClient } = require('@supabase/supabase-js');
+    client = createClient(SUPABASE_URL, process.env.SUPABASE_KEY, {
+      auth: { persistSession: false },
+    });
+  }
+  return client;
+}
+
+// Replaces the shared client (local stand-in databases, load tests)
+function useSupabaseClient(stub) {
+  client = stub;
+}
+
+module.exports = { SUPABASE_URL, getSupabase, useSupabaseClient };
@@ -0,0 +1,123 @@
+// /api/_lib/wire.js
+// Codec for the compact binary upload format produced by the firmware
+// (see lib/ClimateCore/src/wire_format.h for the layout).
+
+const CONTENT_TYPE = 'application/x-climate-readings';
+const VERSION = 2;
+const HEADER_SIZE = { 1: 12, 2: 20 };
+const READING_SIZE = 4;     // without the v2 time varint
+
+function readVarint(buf, at) {
+  let value = 0n;
+  let shift = 0n;
+  for (let i = at; i < buf.length && shift < 70n; i++) {
+    value |= BigInt(buf[i] & 0x7f) << shift;
+    if ((buf[i] & 0x80) === 0) return { value, next: i + 1 };
+    shift += 7n;
+  }
+  throw new Error('Truncated varint');
+}
+
+function writeVarint(bytes, value) {
+  while (value >= 0x80n) {
+    bytes.push(Number(value & 0x7fn) | 0x80);
+    value >>= 7n;
+  }
+  bytes.push(Number(value));
+}
+
+const unzigzag = v => (v >> 1n) ^ -(v & 1n);
+const zigzag = v => (v << 1n) ^ (v >> 63n);
+
+// Returns { deviceId, sequence, readings } or throws on a malformed payload.
+// v2 readings carry deviceTime (epoch ms at capture), or null if unstamped.
+function decodeReadings(buf) {
+  if (buf.length < HEADER_SIZE[1] || buf[0] !== 0x43 || buf[1] !== 0x43) {
+    throw new Error('Bad magic');
+  }
+  const version = buf[2];
+  if (!HEADER_SIZE[version]) {
+    throw new Error(`Unsupported version ${version}`);
+  }
+  if (buf.length < HEADER_SIZE[version]) {
+    throw new Error('Truncated header');
+  }
+
+  const count = buf[3];
+  if (version === 1 && buf.length !== HEADER_SIZE[1] + count * READING_SIZE) {
+    throw new Error('Length does not match reading count');
+  }
+
+  let previous = version === 2 ? buf.readBigInt64LE(12) : 0n;
+  let at = HEADER_SIZE[version];
+  const readings = [];
+  for (let i = 0; i < count; i++) {
+    if (at + READING_SIZE > buf.length) throw new Error('Length does not match reading count');
+    const reading = {
+      temperature: buf.readInt16LE(at) / 100,
+      humidity: buf.readUInt16LE(at + 2) / 100,
+    };
+    at += READING_SIZE;
+
+    if (version === 2) {
+      const { value, next } = readVarint(buf, at);
+      at = next;
+      if (value === 0n) {
+        reading.deviceTime = null;
+      } else {
+        previous += unzigzag(value - 1n);
+        reading.deviceTime = Number(previous);
+      }
+    }
+    readings.push(reading);
+  }
+  if (at !== buf.length) {
+    throw new Error('Length does not match reading count');
+  }
+
+  return {
+    deviceId: buf.readUInt32LE(4),
+    sequence: buf.readUInt32LE(8),
+    readings,
+  };
+}
+
+// Inverse of decodeReadings, always v2 (used by tools/fleet_load.js to act
+// as a device). Readings without deviceTime go out unstamped.
+function encodeReadings({ deviceId, sequence, readings }) {
+  const header = Buffer.alloc(HEADER_SIZE[2]);
+  header[0] = 0x43;
+  header[1] = 0x43;
+  header[2] = VERSION;
+  header[3] = readings.length;
+  header.writeUInt32LE(deviceId >>> 0, 4);
+  header.writeUInt32LE(sequence >>> 0, 8);
+
+  const bytes = [];
+  let previous = null;
+  for (const r of readings) {
+    const values = Buffer.alloc(READING_SIZE);
+    values.writeInt16LE(Math.max(-32768, Math.min(32767, Math.round(r.temperature * 100))), 0);
+    values.writeUInt16LE(Math.max(0, Math.min(65535, Math.round(r.humidity * 100))), 2);
+    bytes.push(...values);
+
+    if (r.deviceTime == null) {
+      writeVarint(bytes, 0n);
+      continue;
+    }
+    const time = BigInt(Math.round(r.deviceTime));
+    if (previous === null) {
+      header.writeBigInt64LE(time, 12);
+      previous = time;
+    }
+    writeVarint(bytes, zigzag(time - previous) + 1n);
+    previous = time;
+  }
+  return Buffer.concat([header, Buffer.from(bytes)]);
+}
+
+function isWireContentType(header) {
+  return typeof header === 'string' && header.split(';')[0].trim() === CONTENT_TYPE;
+}
+
+module.exports = { CONTENT_TYPE, decodeReadings, encodeReadings, isWireContentType };
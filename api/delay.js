@@ -1,35 +1,144 @@
+// /api/delay.js
+const { createDelayStore } = require('./_lib/delay_store');
+const { matchesEtag } = require('./_lib/http_cache');
+const { DB_RETRY_AFTER_S, sendUnavailable } = require('./_lib/backpressure');
 
-// Store delay in memory (resets on Vercel cold start, but works for demo)
-let currentDelay = 500;
+// Delay lives in a shared, versioned store (see _lib/delay_store.js) so
+// every instance agrees on it and it survives cold starts. The version is
+// the ETag: a GET with a matching If-None-Match gets a bodyless 304.
+const store = createDelayStore();
+
+// Long-poll: GET /api/delay?wait=<ms> holds the request until the stored
+// version differs from If-None-Match (or the delay differs from ?since=)
+// or `wait` elapses (capped below the function's maxDuration)
+const MAX_WAIT_MS = 8000;
+// POSTs to other instances are only seen by re-reading the store. One
+// shared poll per instance does that every RECHECK_MS while anyone is
+// waiting, and concurrent reads share one round trip, so the database
+// load stays at about one read per second per instance however many
+// devices are parked here.
+const RECHECK_MS = 1000;
+// { offer(state), fail(error) } per parked long-poll
+const waiters = new Set();
+let pendingRead = null;
+let pollTimer = null;
+
+function readState() {
+  if (!pendingRead) pendingRead = store.get().finally(() => { pendingRead = null; });
+  return pendingRead;
+}
+
+function offerState(state) {
+  for (const waiter of waiters) waiter.offer(state);
+}
+
+function schedulePoll() {
+  if (pollTimer || waiters.size === 0) return;
+  pollTimer = setTimeout(async () => {
+    try {
+      offerState(await readState());
+    } catch (e) {
+      for (const waiter of waiters) waiter.fail(e);
+    }
+    pollTimer = null;
+    schedulePoll();
+  }, RECHECK_MS);
+}
+
+function etagFor(state) {
+  return `"${state.version}"`;
+}
+
+// Resolves with the first state that is not current, or the newest one
+// seen when waitMs elapses or the client goes away
+async function waitForChange(isCurrent, waitMs, req) {
+  const state = await readState();
+  if (!isCurrent(state) || req.destroyed) return state;
+
+  return new Promise((resolve, reject) => {
+    let latest = state;
+    const done = (error) => {
+      clearTimeout(timer);
+      waiters.delete(waiter);
+      req.off('close', onClose);
+      if (error) reject(error); else resolve(latest);
+    };
+    const waiter = {
+      offer(next) {
+        latest = next;
+        if (!isCurrent(next)) done();
+      },
+      fail: done,
+    };
+    const onClose = () => done();
+    const timer = setTimeout(onClose, waitMs);
+    waiters.add(waiter);
+    req.on('close', onClose);
+    schedulePoll();
+  });
+}
+
+function readBody(req) {
+  return new Promise((resolve, reject) => {
+    let body = '';
+    req.on('data', chunk => body += chunk);
+    req.on('end', () => resolve(body));
+    req.on('error', reject);
+  });
+}
 
 module.exports = async (req, res) => {
   if (req.method === 'GET') {
-    // Return the last saved delay
-    res.json({ delay: currentDelay });
+    const ifNoneMatch = req.headers['if-none-match'];
+    const since = req.query?.since !== undefined ? Number(req.query.since) : NaN;
+    const waitMs = Math.min(Number(req.query?.wait) || 0, MAX_WAIT_MS);
+
+    // The client already has `state` when its ETag (or ?since= delay) matches
+    const isCurrent = (state) =>
+      ifNoneMatch ? matchesEtag(ifNoneMatch, etagFor(state)) : state.delay === since;
+
+    let state;
+    try {
+      state = (waitMs > 0 && (ifNoneMatch || Number.isFinite(since)))
+        ? await waitForChange(isCurrent, waitMs, req)
+        : await readState();
+    } catch (e) {
+      console.error('Delay store error:', e.message);
+      // Long-polling devices wait this out before re-arming
+      return sendUnavailable(res, DB_RETRY_AFTER_S, 'Database error');
+    }
+
+    res.setHeader('ETag', etagFor(state));
+    res.setHeader('Cache-Control', 'no-cache');
+
+    if (matchesEtag(ifNoneMatch, etagFor(state))) {
+      return res.status(304).end();
+    }
+    res.json({ delay: state.delay, version: state.version });
   } else if (req.method === 'POST') {
+    // Parse body manually (Vercel doesn't auto-parse)
+    let data;
+    try {
+      data = JSON.parse(await readBody(req));
+    } catch (e) {
+      return res.status(400).json({ error: 'Invalid JSON' });
+    }
+
+    const { delay } = data || {};
+    if (typeof delay !== 'number' || delay < 50 || delay > 2000) {
+      return res.status(400).json({ error: 'Delay must be 50-2000' });
+    }
+
     try {
-      // Parse body manually (Vercel doesn't auto-parse)
-      let body = '';
-      req.on('data', chunk => body += chunk);
-      req.on('end', () => {
-        try {
-          const data = JSON.parse(body);
-          const { delay } = data;
-          
-          if (typeof delay === 'number' && delay >= 50 && delay <= 2000) {
-            currentDelay = delay; // ✅ Save it!
-            res.json({ delay: currentDelay });
-          } else {
-            res.status(400).json({ error: 'Delay must be 50-2000' });
-          }
-        } catch (e) {
-          res.status(400).json({ error: 'Invalid JSON' });
-        }
-      });
+      const state = await store.set(delay);
+      offerState(state);
+      res.setHeader('ETag', etagFor(state));
+      res.json({ delay: state.delay, version: state.version });
     } catch (e) {
-      res.status(400).json({ error: 'Body read failed' });
+      console.error('Delay store error:', e.message);
+      sendUnavailable(res, DB_RETRY_AFTER_S, 'Database error');
     }
   } else {
     res.status(405).end();
   }
-};
\ No newline at end of file
+};
@@ -1,31 +1,118 @@
 // /api/history.js
-const { createClient } = require('@supabase/supabase-js');
+const { getSupabase } = require('./_lib/supabase');
+const { readingsCache, RECENT_LIMIT } = require('./_lib/readings_cache');
+const { sendCached } = require('./_lib/http_cache');
+const { parseCursor, formatCursor } = require('./_lib/readings_cursor');
+
+// Legacy response (no query parameters): newest DEFAULT_LIMIT rows, served
+// from the shared read cache
+const DEFAULT_LIMIT = RECENT_LIMIT;
+// Raw pages: ?limit=..&cursor=<next_cursor of the previous page>, the
+// "<observed_at>|<id>" of its last row (api/_lib/readings_cursor.js).
+// Pages and buckets are keyed on observed_at, so readings drained late
+// from a board's offline log land where they were taken.
+const MAX_LIMIT = 1000;
+// Bucketed series: ?from=..&to=..&resolution=<seconds|auto>
+const MAX_BUCKETS = 2000;
+const AUTO_BUCKETS = 500;
+
+function parseTime(value, fallback) {
+  if (value === undefined) return fallback;
+  const t = new Date(value);
+  return Number.isNaN(t.getTime()) ? null : t;
+}
+
+async function bucketed(supabase, res, from, to, resolution) {
+  const spanSeconds = (to - from) / 1000;
+  const bucketSeconds = resolution === 'auto'
+    ? Math.max(1, Math.ceil(spanSeconds / AUTO_BUCKETS))
+    : Number(resolution);
+
+  if (!Number.isInteger(bucketSeconds) || bucketSeconds < 1) {
+    return res.status(400).json({ error: 'resolution must be a positive number of seconds or "auto"' });
+  }
+  if (spanSeconds / bucketSeconds > MAX_BUCKETS) {
+    return res.status(400).json({ error: `Range needs more than ${MAX_BUCKETS} buckets` });
+  }
+
+  const { data, error } = await supabase.rpc('readings_buckets', {
+    p_from: from.toISOString(),
+    p_to: to.toISOString(),
+    p_bucket_seconds: bucketSeconds,
+  });
+
+  if (error) {
+    console.error('History bucket error:', error.message);
+    return res.status(500).json({ error: 'Failed to fetch history' });
+  }
+
+  res.status(200).json({ resolution: bucketSeconds, buckets: data || [] });
+}
+
+async function raw(supabase, res, from, to, limit, cursor) {
+  // Keyset pagination, newest first, on (observed_at, id): readings from
+  // different boards or unstamped ones in one batch can share a
+  // timestamp, so it alone can't split a page between them
+  const { data, error } = await supabase.rpc('readings_page', {
+    p_from: from ? from.toISOString() : null,
+    p_to: to ? to.toISOString() : null,
+    p_before_at: cursor ? cursor.at : null,
+    p_before_id: cursor ? cursor.id : null,
+    p_limit: limit,
+  });
+
+  if (error) {
+    console.error('History fetch error:', error.message);
+    return res.status(500).json({ error: 'Failed to fetch history' });
+  }
+
+  const rows = data || [];
+  const last = rows[rows.length - 1];
+  const nextCursor = rows.length === limit ? formatCursor(last) : null;
+  res.status(200).json({ rows, next_cursor: nextCursor });
+}
 
 module.exports = async (req, res) => {
-  const supabase = createClient(
-    'https://uappuwebcylzwndfaqxo.supabase.co',
-    process.env.SUPABASE_KEY
-  );
+  const supabase = getSupabase();
 
-  if (!process.env.SUPABASE_KEY) {
+  if (!supabase) {
     return res.status(500).json({ error: 'Missing API key' });
   }
 
+  const q = req.query || {};
+
   try {
-    const { data, error } = await supabase
-      .from('readings')
-      .select('recorded_at, temperature, humidity')
-      .order('recorded_at', { ascending: false })
-      .limit(50);
-
-    if (error) {
-      console.error('History fetch error:', error.message);
+    if (q.resolution !== undefined) {
+      const to = parseTime(q.to, new Date());
+      const from = parseTime(q.from, to && new Date(to.getTime() - 24 * 3600 * 1000));
+      if (!from || !to || from >= to) {
+        return res.status(400).json({ error: 'Invalid from/to' });
+      }
+      return await bucketed(supabase, res, from, to, q.resolution);
+    }
+
+    if (q.from !== undefined || q.to !== undefined || q.cursor !== undefined || q.limit !== undefined) {
+      const from = parseTime(q.from, undefined);
+      const to = parseTime(q.to, undefined);
+      const cursor = parseCursor(q.cursor);
+      const limit = Math.min(Math.max(parseInt(q.limit, 10) || DEFAULT_LIMIT, 1), MAX_LIMIT);
+      if (from === null || to === null || cursor === null) {
+        return res.status(400).json({ error: 'Invalid from/to/cursor' });
+      }
+      return await raw(supabase, res, from, to, limit, cursor);
+    }
+
+    let rows;
+    try {
+      rows = await readingsCache().recent();
+    } catch (e) {
+      console.error('History fetch error:', e.message);
       return res.status(500).json({ error: 'Failed to fetch history' });
     }
 
-    res.status(200).json(data || []);
+    sendCached(req, res, rows, { sMaxAge: 2, staleSeconds: 30 });
   } catch (err) {
     console.error('Unexpected error:', err.message);
     res.status(500).json({ error: 'Server error' });
   }
-};
\ No newline at end of file
+};
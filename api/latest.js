@@ -1,20 +1,22 @@
-const { createClient } = require('@supabase/supabase-js');
+// /api/latest.js
+const { readingsCache } = require('./_lib/readings_cache');
+const { sendCached } = require('./_lib/http_cache');
 
-module.exports = async (req, res) => {
-  const supabase = createClient(
-    'https://uappuwebcylzwndfaqxo.supabase.co',
-    process.env.SUPABASE_KEY
-  );
+const EMPTY = { temperature: null, humidity: null, recorded_at: null, device_recorded_at: null };
 
-  const { data, error } = await supabase
-    .from('readings')
-    .select('temperature, humidity, recorded_at')  // ✅ recorded_at
-    .order('recorded_at', { ascending: false })   // ✅ recorded_at
-    .limit(1);
+module.exports = async (req, res) => {
+  const readings = readingsCache();
+  if (!readings) {
+    return res.status(500).json({ error: 'Missing API key' });
+  }
 
-  if (error) {
-    return res.status(500).json({ error: error.message });
+  let latest;
+  try {
+    latest = await readings.latest();
+  } catch (e) {
+    return res.status(500).json({ error: e.message });
   }
 
-  res.json(data?.[0] || { temperature: null, humidity: null, recorded_at: null });
-};
\ No newline at end of file
+  // Matches the in-process freshness window; the CDN absorbs repeat reads
+  sendCached(req, res, latest || EMPTY, { sMaxAge: 2, staleSeconds: 30 });
+};
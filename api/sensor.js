@@ -1,25 +1,78 @@
 // /api/sensor.js
-const { createClient } = require('@supabase/supabase-js');
+const { getSupabase } = require('./_lib/supabase');
+const { DB_RETRY_AFTER_S, sendUnavailable, ingestPause, rateLimits } = require('./_lib/backpressure');
+const { readingsCache } = require('./_lib/readings_cache');
+const { decodeReadings, isWireContentType } = require('./_lib/wire');
 
-// Helper to read raw body from stream
+// Helper to read raw body from stream (kept as bytes for the binary format)
 function getRawBody(req) {
-  return new Promise((resolve) => {
-    let body = '';
-    req.setEncoding('utf8');
+  return new Promise((resolve, reject) => {
+    const chunks = [];
     req.on('data', (chunk) => {
-      body += chunk;
+      chunks.push(chunk);
     });
     req.on('end', () => {
-      resolve(body);
+      resolve(Buffer.concat(chunks));
     });
+    req.on('error', reject);
   });
 }
 
+// Upper bound on readings accepted in one batched upload
+const MAX_BATCH = 100;
+
+// Device timestamps outside this window are ignored (clock never synced,
+// or badly off); those readings get the server's time only
+const MIN_DEVICE_TIME = Date.UTC(2024, 0, 1);
+const MAX_DEVICE_CLOCK_AHEAD_MS = 5 * 60 * 1000;
+
+// Older boards send { temp, humid } instead of { temperature, humidity }
+function canonicalReading(r) {
+  if (r && r.temperature === undefined && r.temp !== undefined) {
+    return { temperature: r.temp, humidity: r.humid, deviceTime: r.deviceTime };
+  }
+  return r;
+}
+
+// { base, readings: [{ .., dt }] }: device time is delta-encoded, each dt
+// counting from the previous stamped reading (the first from base)
+function resolveDeviceTimes(base, readings) {
+  if (typeof base !== 'number') return readings;
+  let previous = base;
+  return readings.map((r) => {
+    if (!r || typeof r.dt !== 'number') return r;
+    previous += r.dt;
+    return { ...r, deviceTime: previous };
+  });
+}
+
+// Accepts a single reading, a bare array, or { readings: [...] }
+function normalizeReadings(data) {
+  if (Array.isArray(data)) return data.map(canonicalReading);
+  if (data && Array.isArray(data.readings)) {
+    return resolveDeviceTimes(data.base, data.readings).map(canonicalReading);
+  }
+  return [canonicalReading(data)];
+}
+
+// ISO capture time, or null when the device did not stamp the reading
+function deviceRecordedAt(deviceTime, now) {
+  if (!Number.isFinite(deviceTime)) return null;
+  if (deviceTime < MIN_DEVICE_TIME || deviceTime > now + MAX_DEVICE_CLOCK_AHEAD_MS) return null;
+  return new Date(deviceTime).toISOString();
+}
+
 module.exports = async (req, res) => {
   if (req.method !== 'POST') {
     return res.status(405).json({ error: 'Only POST allowed' });
   }
 
+  // Incident switch: shed ingest before doing any work
+  const pause = ingestPause();
+  if (pause) {
+    return sendUnavailable(res, pause, 'Ingest paused');
+  }
+
   // Read raw body manually
   let rawBody;
   try {
@@ -28,59 +81,86 @@ module.exports = async (req, res) => {
     return res.status(400).json({ error: 'Failed to read request body' });
   }
 
-  // Clean and parse
-  const cleanBody = rawBody.trim().replace(/\0/g, '');
-  if (!cleanBody) {
-    return res.status(400).json({ error: 'Empty body' });
+  let readings;
+  if (isWireContentType(req.headers['content-type'])) {
+    // Compact binary batch
+    try {
+      readings = decodeReadings(rawBody).readings;
+    } catch (e) {
+      console.error('Invalid binary payload:', e.message);
+      return res.status(400).json({ error: 'Invalid binary payload' });
+    }
+  } else {
+    // Clean and parse
+    const cleanBody = rawBody.toString('utf8').trim().replace(/\0/g, '');
+    if (!cleanBody) {
+      return res.status(400).json({ error: 'Empty body' });
+    }
+
+    let data;
+    try {
+      data = JSON.parse(cleanBody);
+    } catch (e) {
+      console.error('Invalid JSON received:', cleanBody);
+      return res.status(400).json({ error: 'Invalid JSON' });
+    }
+
+    readings = normalizeReadings(data);
   }
 
-  let data;
-  try {
-    data = JSON.parse(cleanBody);
-  } catch (e) {
-    console.error('Invalid JSON received:', cleanBody);
-    return res.status(400).json({ error: 'Invalid JSON' });
+  if (readings.length === 0 || readings.length > MAX_BATCH) {
+    return res.status(400).json({ error: `Expected 1-${MAX_BATCH} readings` });
   }
 
-  const { temperature, humidity } = data;
-  if (typeof temperature !== 'number' || typeof humidity !== 'number') {
+  const valid = readings.every(r =>
+    r && typeof r.temperature === 'number' && typeof r.humidity === 'number'
+  );
+  if (!valid) {
     return res.status(400).json({ error: 'temperature and humidity must be numbers' });
   }
 
   // Supabase
-  const supabase = createClient(
-    'https://uappuwebcylzwndfaqxo.supabase.co',
-    process.env.SUPABASE_KEY
-  );
+  const supabase = getSupabase();
 
-  if (!process.env.SUPABASE_KEY) {
+  if (!supabase) {
     return res.status(500).json({ error: 'Missing SUPABASE_KEY' });
   }
 
+  // Devices that compress on their own (swinging door) send ?dedupe=off;
+  // server-side dedupe would drop their heartbeats and trend corners
+  const threshold = req.query?.dedupe === 'off' ? -1 : 0.1;
+
   try {
-    const {  lastReadings } = await supabase
-      .from('readings')
-      .select('temperature, humidity')
-      .order('recorded_at', { ascending: false })
-      .limit(1);
-
-    const last = lastReadings?.[0];
-    const changed = !last ||
-      Math.abs(parseFloat(last.temperature) - temperature) > 0.1 ||
-      Math.abs(parseFloat(last.humidity) - humidity) > 0.1;
-
-    if (changed) {
-      const { error } = await supabase
-        .from('readings')
-        .insert([{ temperature, humidity }]);
-
-      if (error) {
-        console.error('Supabase insert error:', error.message);
-        return res.status(500).json({ error: 'Database error' });
-      }
+    // One round trip: the database compares each reading with the last
+    // stored row and inserts only the changed ones
+    // (supabase/migrations/*_insert_readings_if_changed.sql)
+    // recorded_at stays the server's insert time; device_recorded_at is
+    // the capture time on the device
+    // (supabase/migrations/*_device_recorded_at.sql)
+    const now = Date.now();
+    const { data: stored, error } = await supabase.rpc('insert_readings_if_changed', {
+      p_readings: readings.map(({ temperature, humidity, deviceTime }) => ({
+        temperature,
+        humidity,
+        device_recorded_at: deviceRecordedAt(deviceTime, now),
+      })),
+      p_threshold: threshold,
+    });
+
+    if (error) {
+      console.error('Supabase insert error:', error.message);
+      return sendUnavailable(res, DB_RETRY_AFTER_S, 'Database error');
     }
 
-    res.status(200).json({ success: true });
+    // Readers on this instance see the new row right away; others catch
+    // up within the cache's freshness window
+    if (stored) readingsCache().invalidate();
+
+    // Devices adopt pushed limits when the version changes
+    const limits = rateLimits();
+    res.status(200).json(limits
+      ? { success: true, stored: stored ?? 0, limits }
+      : { success: true, stored: stored ?? 0 });
   } catch (err) {
     console.error('Server error:', err.message);
     res.status(500).json({ error: 'Internal error' });
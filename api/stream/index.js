@@ -0,0 +1,88 @@
+// /api/stream
+// Server-sent events feed for the dashboard. New rows in `readings` are
+// pushed as they are inserted (Supabase realtime), so open tabs no longer
+// poll /api/latest. The response ends after STREAM_DURATION_MS and the
+// browser's EventSource reconnects, catching up from Last-Event-ID.
+//
+// Event ids are (observed_at, id) cursors like the history pages', the
+// newest sent so far: a reading a board drains late from its offline log
+// is still pushed, but does not move the browser's Last-Event-ID back.
+const { randomUUID } = require('crypto');
+const { getSupabase } = require('../_lib/supabase');
+const { parseCursor, observedAt, isAfter } = require('../_lib/readings_cursor');
+
+const STREAM_DURATION_MS = 55000;   // below maxDuration for api/stream/*.js
+const HEARTBEAT_MS = 15000;
+const CATCH_UP_LIMIT = 100;
+
+function send(res, id, event, row) {
+  res.write(`id: ${id}\nevent: ${event}\ndata: ${JSON.stringify(row)}\n\n`);
+}
+
+module.exports = async (req, res) => {
+  const supabase = getSupabase();
+  if (!supabase) {
+    return res.status(500).json({ error: 'Missing API key' });
+  }
+
+  res.writeHead(200, {
+    'Content-Type': 'text/event-stream',
+    'Cache-Control': 'no-cache, no-transform',
+    'Connection': 'keep-alive',
+  });
+  res.write('retry: 1000\n\n');
+
+  // A malformed Last-Event-ID is treated like none
+  const since = parseCursor(req.headers['last-event-id']) || null;
+  let cursor = since;
+  const sendReading = (row) => {
+    if (!cursor || isAfter(row, cursor)) cursor = { at: observedAt(row), id: String(row.id) };
+    send(res, `${cursor.at}|${cursor.id}`, 'reading', row);
+  };
+
+  // Subscribe first so nothing inserted during the catch-up query is missed.
+  // The client is shared per instance and realtime-js hands back the same
+  // channel for the same topic, so every stream needs a topic of its own.
+  const channel = supabase
+    .channel(`readings-stream-${randomUUID()}`)
+    .on('postgres_changes', { event: 'INSERT', schema: 'public', table: 'readings' }, (payload) => {
+      const { id, recorded_at, device_recorded_at, temperature, humidity } = payload.new;
+      sendReading({ id, recorded_at, device_recorded_at, temperature, humidity });
+    })
+    .subscribe();
+
+  // Catch up: rows after the last event this client saw, or just the
+  // latest. The range starts at the cursor's instant; rows in it already
+  // sent are dropped here
+  let query = supabase
+    .from('readings')
+    .select('id, recorded_at, device_recorded_at, temperature, humidity')
+    .order('observed_at', { ascending: false })
+    .order('id', { ascending: false })
+    .limit(since ? CATCH_UP_LIMIT : 1);
+  if (since) query = query.gte('observed_at', since.at);
+
+  const { data, error } = await query;
+  if (error) {
+    console.error('Stream catch-up error:', error.message);
+  } else {
+    (data || [])
+      .filter(row => !since || isAfter(row, since))
+      .reverse()
+      .forEach(sendReading);
+  }
+
+  await new Promise((resolve) => {
+    const heartbeat = setInterval(() => res.write(': keep-alive\n\n'), HEARTBEAT_MS);
+    const done = () => {
+      clearInterval(heartbeat);
+      clearTimeout(timer);
+      resolve();
+    };
+    const timer = setTimeout(done, STREAM_DURATION_MS);
+    req.on('close', done);
+  });
+
+  await supabase.removeChannel(channel);
+  res.end();
+};
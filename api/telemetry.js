@@ -0,0 +1,92 @@
+// /api/telemetry.js
+// POST: stage timing report from a device (see MERGED reportTelemetry())
+// GET:  latest report per device, for the dashboard
+const { getSupabase } = require('./_lib/supabase');
+
+const MAX_BODY_BYTES = 4096;
+// Rows scanned for GET; devices report once a minute
+const RECENT_REPORTS = 50;
+// Firmware sends its chip id as hex ("%08lx") and stage names like
+// "tls_connect" (stage_stats.h); anything else is refused, since both are
+// shown on the dashboard
+const DEVICE_ID_RE = /^[A-Za-z0-9_-]{1,32}$/;
+const STAGE_NAME_RE = /^[a-z][a-z0-9_]{0,31}$/;
+const MAX_STAGES = 16;
+
+function readBody(req) {
+  return new Promise((resolve, reject) => {
+    let body = '';
+    req.on('data', chunk => {
+      body += chunk;
+      if (body.length > MAX_BODY_BYTES) reject(new Error('Body too large'));
+    });
+    req.on('end', () => resolve(body));
+    req.on('error', reject);
+  });
+}
+
+function validStages(stages) {
+  if (!stages || typeof stages !== 'object' || Array.isArray(stages)) return false;
+  const entries = Object.entries(stages);
+  return entries.length <= MAX_STAGES && entries.every(([name, s]) =>
+    STAGE_NAME_RE.test(name)
+    && s && ['n', 'p50', 'p95', 'max', 'mean'].every(k => Number.isFinite(s[k]))
+  );
+}
+
+module.exports = async (req, res) => {
+  const supabase = getSupabase();
+  if (!supabase) {
+    return res.status(500).json({ error: 'Missing SUPABASE_KEY' });
+  }
+
+  if (req.method === 'GET') {
+    const { data, error } = await supabase
+      .from('device_telemetry')
+      .select('device_id, received_at, uptime_ms, probe_ns, stages')
+      .order('received_at', { ascending: false })
+      .limit(RECENT_REPORTS);
+
+    if (error) {
+      console.error('Telemetry fetch error:', error.message);
+      return res.status(500).json({ error: 'Database error' });
+    }
+
+    // Newest report per device
+    const latest = new Map();
+    for (const row of data || []) {
+      if (!latest.has(row.device_id)) latest.set(row.device_id, row);
+    }
+    return res.status(200).json([...latest.values()]);
+  }
+
+  if (req.method !== 'POST') {
+    return res.status(405).json({ error: 'Only GET and POST allowed' });
+  }
+
+  let report;
+  try {
+    report = JSON.parse(await readBody(req));
+  } catch (e) {
+    return res.status(400).json({ error: 'Invalid JSON' });
+  }
+
+  if (!report || typeof report.device !== 'string' || !DEVICE_ID_RE.test(report.device)
+      || !validStages(report.stages)) {
+    return res.status(400).json({ error: 'Expected { device, stages: { name: { n, p50, p95, max, mean } } }' });
+  }
+
+  const { error } = await supabase.from('device_telemetry').insert({
+    device_id: report.device,
+    uptime_ms: Number.isFinite(report.uptime_ms) ? report.uptime_ms : null,
+    probe_ns: Number.isFinite(report.probe_ns) ? report.probe_ns : null,
+    stages: report.stages,
+  });
+
+  if (error) {
+    console.error('Telemetry insert error:', error.message);
+    return res.status(500).json({ error: 'Database error' });
+  }
+
+  res.status(200).json({ success: true });
+};
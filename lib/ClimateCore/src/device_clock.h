@@ -0,0 +1,47 @@
+// ============================================
+// DEVICE CLOCK
+// Wall-clock time for readings, from a monotonic millisecond
+// counter anchored to the last SNTP sync. Samples are stamped
+// with the epoch at capture, so upload delays, retries and the
+// offline log no longer shift them; a resync only moves the
+// anchor, never a reading already stamped.
+//
+// epochAt() works for counter values within ±24 days of the
+// anchor (32-bit wrap-safe difference); SNTP resyncs hourly.
+// Plain C++ (no Arduino dependency).
+// ============================================
+
+#pragma once
+
+#include <stdint.h>
+
+// Readings taken before the first sync carry this epoch
+const int64_t EPOCH_UNKNOWN = 0;
+
+class DeviceClock {
+public:
+    // epochMs was current when the counter read monotonicMs
+    void sync(int64_t epochMs, uint32_t monotonicMs) {
+        _anchorEpochMs = epochMs;
+        _anchorMs = monotonicMs;
+        _synced = true;
+        _syncs++;
+    }
+
+    bool synced() const { return _synced; }
+    uint32_t syncs() const { return _syncs; }
+
+    // Epoch ms at a counter value, or EPOCH_UNKNOWN before the first sync
+    int64_t epochAt(uint32_t monotonicMs) const {
+        if (!_synced) return EPOCH_UNKNOWN;
+        return _anchorEpochMs + (int32_t)(monotonicMs - _anchorMs);
+    }
+
+    uint32_t sinceSyncMs(uint32_t nowMs) const { return _synced ? nowMs - _anchorMs : 0; }
+
+private:
+    int64_t _anchorEpochMs = 0;
+    uint32_t _anchorMs = 0;
+    uint32_t _syncs = 0;
+    bool _synced = false;
+};
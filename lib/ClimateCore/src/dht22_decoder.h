@@ -0,0 +1,74 @@
+// ============================================
+// DHT22 DECODER
+// Decodes one DHT22 frame from captured line levels and
+// durations (as recorded by the RMT receiver):
+//
+//   80 us low, 80 us high        sensor response
+//   40 x (50 us low, 26-28 us high = 0 / 70 us high = 1)
+//
+// Bytes: humidity hi/lo, temperature hi/lo (bit 15 = sign),
+// checksum = low byte of the sum of the first four.
+// Plain C++ (no Arduino dependency).
+// ============================================
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+struct DhtLevel {
+    uint8_t level;          // 0 = low, 1 = high
+    uint16_t durationUs;
+};
+
+enum class DhtStatus : uint8_t { Ok, TooShort, Checksum };
+
+struct DhtFrame {
+    DhtStatus status;
+    float temperature;      // °C
+    float humidity;         // %RH
+};
+
+const uint16_t DHT_BIT_THRESHOLD_US = 48;   // between 28 us (0) and 70 us (1)
+const size_t DHT_FRAME_BITS = 40;
+
+inline DhtFrame decodeDht22(const DhtLevel* levels, size_t count) {
+    DhtFrame frame = { DhtStatus::TooShort, 0, 0 };
+
+    // Data bits are the last 40 high pulses; anything before them is the
+    // start/response handshake, which the capture may or may not include.
+    // Zero durations are the RMT end marker (idle level), not pulses
+    size_t highs = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (levels[i].level && levels[i].durationUs) highs++;
+    }
+    if (highs < DHT_FRAME_BITS) return frame;
+
+    uint8_t bytes[5] = {0, 0, 0, 0, 0};
+    size_t skip = highs - DHT_FRAME_BITS;
+    size_t bit = 0;
+    for (size_t i = 0; i < count && bit < DHT_FRAME_BITS; i++) {
+        if (!levels[i].level || !levels[i].durationUs) continue;
+        if (skip > 0) {
+            skip--;
+            continue;
+        }
+        bytes[bit / 8] <<= 1;
+        if (levels[i].durationUs > DHT_BIT_THRESHOLD_US) bytes[bit / 8] |= 1;
+        bit++;
+    }
+
+    uint8_t sum = (uint8_t)(bytes[0] + bytes[1] + bytes[2] + bytes[3]);
+    if (sum != bytes[4]) {
+        frame.status = DhtStatus::Checksum;
+        return frame;
+    }
+
+    uint16_t rawHumidity = (uint16_t)((bytes[0] << 8) | bytes[1]);
+    uint16_t rawTemperature = (uint16_t)(((bytes[2] & 0x7F) << 8) | bytes[3]);
+    frame.humidity = rawHumidity / 10.0f;
+    frame.temperature = rawTemperature / 10.0f;
+    if (bytes[2] & 0x80) frame.temperature = -frame.temperature;
+    frame.status = DhtStatus::Ok;
+    return frame;
+}
@@ -0,0 +1,78 @@
+// ============================================
+// HISTOGRAM
+// Fixed-size linear histogram for timing samples.
+// Values past the last bucket land in an overflow bucket.
+// Plain C++ (no Arduino dependency).
+// ============================================
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+template <size_t Buckets>
+class Histogram {
+public:
+    explicit Histogram(uint32_t bucketWidth) : _bucketWidth(bucketWidth) {}
+
+    void record(uint32_t value) {
+        size_t index = value / _bucketWidth;
+        if (index >= Buckets) {
+            _overflow++;
+        } else {
+            _counts[index]++;
+        }
+        if (_total == 0 || value < _min) _min = value;
+        if (value > _max) _max = value;
+        _sum += value;
+        _total++;
+    }
+
+    void reset() {
+        for (size_t i = 0; i < Buckets; i++) _counts[i] = 0;
+        _overflow = 0;
+        _total = 0;
+        _sum = 0;
+        _min = 0;
+        _max = 0;
+    }
+
+    // Upper bound of the bucket holding the given percentile (0-100);
+    // returns max() when it falls into the overflow bucket
+    uint32_t percentile(uint8_t pct) const {
+        if (_total == 0) return 0;
+        uint64_t target = ((uint64_t)_total * pct + 99) / 100;
+        uint64_t seen = 0;
+        for (size_t i = 0; i < Buckets; i++) {
+            seen += _counts[i];
+            if (seen >= target) return (uint32_t)(i + 1) * _bucketWidth;
+        }
+        return _max;
+    }
+
+    // Number of samples strictly below the given value (bucket granularity)
+    uint32_t countBelow(uint32_t value) const {
+        size_t limit = value / _bucketWidth;
+        uint32_t n = 0;
+        for (size_t i = 0; i < Buckets && i < limit; i++) n += _counts[i];
+        return n;
+    }
+
+    uint32_t bucket(size_t index) const { return _counts[index]; }
+    uint32_t overflow() const { return _overflow; }
+    uint32_t total() const { return _total; }
+    uint32_t min() const { return _min; }
+    uint32_t max() const { return _max; }
+    uint32_t mean() const { return _total ? (uint32_t)(_sum / _total) : 0; }
+    uint32_t bucketWidth() const { return _bucketWidth; }
+    static constexpr size_t buckets() { return Buckets; }
+
+private:
+    uint32_t _bucketWidth;
+    uint32_t _counts[Buckets] = {};
+    uint32_t _overflow = 0;
+    uint32_t _total = 0;
+    uint64_t _sum = 0;
+    uint32_t _min = 0;
+    uint32_t _max = 0;
+};
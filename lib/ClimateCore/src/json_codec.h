@@ -0,0 +1,143 @@
+// ============================================
+// JSON CODEC
+// Encodes reading batches and decodes the delay response
+// without heap allocation. ArduinoJson builds on the host too,
+// so the input type is a template parameter (Arduino Stream,
+// std::istream, const char*...).
+// ============================================
+
+#pragma once
+
+#include <math.h>
+#include <ArduinoJson.h>
+
+#include "rate_controller.h"
+#include "reading_buffer.h"
+#include "stage_stats.h"
+
+// Payload field names, chosen per device at compile time
+struct ReadingKeys {
+    static constexpr const char* temperature() { return "temperature"; }
+    static constexpr const char* humidity() { return "humidity"; }
+};
+
+// Older temphumid boards send {"temp":..,"humid":..}
+struct ShortReadingKeys {
+    static constexpr const char* temperature() { return "temp"; }
+    static constexpr const char* humidity() { return "humid"; }
+};
+
+// Longest number ArduinoJson writes: a double is at most sign,
+// 7 integral digits, '.', 9 decimals and "e-308"; an int64 is 20 chars
+const size_t JSON_DOUBLE_MAX_CHARS = 23;
+const size_t JSON_INT64_MAX_CHARS = 20;
+
+constexpr size_t jsonKeyLength(const char* key) {
+    return *key ? 1 + jsonKeyLength(key + 1) : 0;
+}
+
+// Buffer size (with the terminating NUL) that fits any batch of count
+// readings from encodeJsonBatch, whatever the values and gaps
+template <typename Keys = ReadingKeys>
+constexpr size_t jsonBatchMaxSize(size_t count) {
+    // {"readings":[ ... ],"base":I} and per item {"T":N,"H":N,"dt":I},
+    return 13 + 1 + 8 + JSON_INT64_MAX_CHARS + 1 + 1
+           + count * (jsonKeyLength(Keys::temperature()) + jsonKeyLength(Keys::humidity()) + 17
+                      + 2 * JSON_DOUBLE_MAX_CHARS + JSON_INT64_MAX_CHARS);
+}
+
+// {"readings":[{"temperature":..,"humidity":..},...]} into out;
+// returns the number of bytes written (0 if it did not fit).
+// Stamped readings (epochMs != 0) are delta-encoded: "base" is the
+// epoch ms of the first one and each gets "dt", ms since the
+// previous stamped reading. Unstamped ones get the server's time.
+template <size_t MaxCount, typename Keys = ReadingKeys>
+size_t encodeJsonBatch(const Reading* batch, size_t count, char* out, size_t size) {
+    if (count > MaxCount) count = MaxCount;
+
+    StaticJsonDocument<JSON_OBJECT_SIZE(2) + JSON_ARRAY_SIZE(MaxCount) + MaxCount * JSON_OBJECT_SIZE(3)> jsonDoc;
+    JsonArray readings = jsonDoc.createNestedArray("readings");
+    int64_t previous = 0;
+    bool stamped = false;
+    for (size_t i = 0; i < count; i++) {
+        const Reading& r = batch[i];
+        JsonObject item = readings.createNestedObject();
+        item[Keys::temperature()] = round(r.temperature * 100) / 100.0;
+        item[Keys::humidity()] = round(r.humidity * 100) / 100.0;
+
+        if (r.epochMs == 0) continue;
+        if (!stamped) {
+            jsonDoc["base"] = r.epochMs;
+            previous = r.epochMs;
+            stamped = true;
+        }
+        item["dt"] = r.epochMs - previous;
+        previous = r.epochMs;
+    }
+
+    if (measureJson(jsonDoc) >= size) return 0;
+    return serializeJson(jsonDoc, out, size);
+}
+
+// {"device":"..","uptime_ms":..,"probe_ns":..,"stages":{"dns":{"n":..,
+// "p50":..,"p95":..,"max":..,"mean":..},...}} into out, skipping stages
+// without samples; returns the number of bytes written (0 if it did not fit)
+template <size_t Buckets>
+size_t encodeTelemetryJson(const StageStats<Buckets>& stats, const char* device, uint32_t uptimeMs,
+                           uint32_t probeOverheadNs, char* out, size_t size) {
+    StaticJsonDocument<JSON_OBJECT_SIZE(4) + JSON_OBJECT_SIZE(STAGE_COUNT) + STAGE_COUNT * JSON_OBJECT_SIZE(5)> jsonDoc;
+    jsonDoc["device"] = device;
+    jsonDoc["uptime_ms"] = uptimeMs;
+    jsonDoc["probe_ns"] = probeOverheadNs;
+    JsonObject stages = jsonDoc.createNestedObject("stages");
+
+    for (size_t i = 0; i < STAGE_COUNT; i++) {
+        const Histogram<Buckets>& h = stats[(Stage)i];
+        if (h.total() == 0) continue;
+        JsonObject item = stages.createNestedObject(stageName((Stage)i));
+        item["n"] = h.total();
+        item["p50"] = h.percentile(50);
+        item["p95"] = h.percentile(95);
+        item["max"] = h.max();
+        item["mean"] = h.mean();
+    }
+
+    if (measureJson(jsonDoc) >= size) return 0;
+    return serializeJson(jsonDoc, out, size);
+}
+
+// Reads {"delay": n} keeping only the "delay" field
+template <typename Input>
+DeserializationError parseDelayJson(Input&& input, int& delay) {
+    StaticJsonDocument<16> filter;
+    filter["delay"] = true;
+    StaticJsonDocument<32> doc;
+    DeserializationError error = deserializeJson(doc, input, DeserializationOption::Filter(filter));
+    if (!error) {
+        if (!doc["delay"].is<int>()) return DeserializationError::InvalidInput;
+        delay = doc["delay"].as<int>();
+    }
+    return error;
+}
+
+// Reads {"limits":{"version":..,"min_sample_ms":..,"max_sample_ms":..,
+// "min_upload_ms":..}} from an upload response into limits. Without a
+// "limits" object (the usual case) limits is left as it was.
+template <typename Input>
+DeserializationError parseRateLimitsJson(Input&& input, RateLimits& limits) {
+    StaticJsonDocument<64> filter;
+    filter["limits"] = true;
+    StaticJsonDocument<192> doc;
+    DeserializationError error = deserializeJson(doc, input, DeserializationOption::Filter(filter));
+    if (error) return error;
+
+    JsonObject pushed = doc["limits"];
+    if (pushed.isNull()) return error;
+    if (!pushed["version"].is<uint32_t>()) return DeserializationError::InvalidInput;
+
+    limits.version = pushed["version"];
+    limits.minSampleMs = pushed["min_sample_ms"] | limits.minSampleMs;
+    limits.maxSampleMs = pushed["max_sample_ms"] | limits.maxSampleMs;
+    limits.minUploadGapMs = pushed["min_upload_ms"] | limits.minUploadGapMs;
+    return error;
+}
@@ -0,0 +1,183 @@
+// ============================================
+// LED EFFECTS
+// Renders one frame of an LED strip effect into a GRB byte
+// buffer (the WS2812 wire order). Brightness curves come from
+// gamma and waveform lookup tables built once at startup, so a
+// frame costs a few table reads and multiplies per pixel.
+// Time and temperature are inputs; frames are reproducible on
+// the host.
+// Plain C++ (no Arduino dependency).
+// ============================================
+
+#pragma once
+
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+
+struct Rgb {
+    uint8_t r;
+    uint8_t g;
+    uint8_t b;
+};
+
+enum class LedEffect : uint8_t {
+    Blink,              // whole strip on/off, toggled by the caller
+    Breathe,            // whole strip fades in and out over one period
+    Wave,               // brightness wave travelling along the strip
+    TemperatureBands    // breathing in a colour picked by temperature
+};
+
+// Lookup tables shared by every renderer
+struct LedTables {
+    uint8_t gamma[256];     // perceived -> PWM level (gamma 2.2)
+    uint8_t wave[256];      // one period of (1 - cos) / 2, 0..255
+
+    LedTables() {
+        for (int i = 0; i < 256; i++) {
+            gamma[i] = (uint8_t)(powf(i / 255.0f, 2.2f) * 255.0f + 0.5f);
+            wave[i] = (uint8_t)((1.0f - cosf(i * 6.2831853f / 256.0f)) * 0.5f * 255.0f + 0.5f);
+        }
+    }
+
+    static const LedTables& instance() {
+        static const LedTables tables;
+        return tables;
+    }
+};
+
+// Temperature bands for LedEffect::TemperatureBands (°C, upper bounds)
+struct TemperatureBand {
+    float below;
+    Rgb color;
+};
+
+const TemperatureBand TEMPERATURE_BANDS[] = {
+    { 18.0f, { 0, 80, 255 } },      // cold: blue
+    { 24.0f, { 0, 255, 60 } },      // comfortable: green
+    { 28.0f, { 255, 140, 0 } },     // warm: orange
+    { 1e9f, { 255, 0, 0 } },        // hot: red
+};
+
+inline Rgb temperatureColor(float celsius) {
+    for (const TemperatureBand& band : TEMPERATURE_BANDS) {
+        if (celsius < band.below) return band.color;
+    }
+    return TEMPERATURE_BANDS[0].color;   // NaN: no reading yet
+}
+
+struct LedFrameInput {
+    uint32_t nowMs;
+    uint32_t periodMs;      // effect period (the blink delay)
+    bool blinkOn;           // LedEffect::Blink only
+    float temperature;      // LedEffect::TemperatureBands only
+};
+
+class LedRenderer {
+public:
+    // brightness scales every effect (0..255, before gamma)
+    LedRenderer(LedEffect effect, Rgb color, uint8_t brightness)
+        : _tables(LedTables::instance()), _effect(effect), _color(color), _brightness(brightness) {}
+
+    void setEffect(LedEffect effect) { _effect = effect; }
+    LedEffect effect() const { return _effect; }
+
+    // Blink only changes when toggled; the others animate every frame
+    bool animated() const { return _effect != LedEffect::Blink; }
+
+    // Writes pixels * 3 bytes of GRB into frame
+    void render(const LedFrameInput& in, uint8_t* frame, size_t pixels) const {
+        uint8_t phase = phaseOf(in.nowMs, in.periodMs * 2);
+
+        switch (_effect) {
+            case LedEffect::Blink:
+                fill(frame, pixels, _color, in.blinkOn ? 255 : 0);
+                break;
+
+            case LedEffect::Breathe:
+                fill(frame, pixels, _color, _tables.wave[phase]);
+                break;
+
+            case LedEffect::Wave: {
+                // One full wave spans the strip; the phase step is 8.8 fixed point
+                uint32_t step = pixels > 0 ? (256u << 8) / pixels : 0;
+                uint32_t offset = (uint32_t)phase << 8;
+                for (size_t i = 0; i < pixels; i++) {
+                    uint8_t level = _tables.wave[(uint8_t)((offset + i * step) >> 8)];
+                    put(frame + i * 3, _color, level);
+                }
+                break;
+            }
+
+            case LedEffect::TemperatureBands:
+                fill(frame, pixels, temperatureColor(in.temperature), _tables.wave[phase]);
+                break;
+        }
+    }
+
+private:
+    // Position within a period as 0..255
+    static uint8_t phaseOf(uint32_t nowMs, uint32_t periodMs) {
+        if (periodMs == 0) return 0;
+        return (uint8_t)(((uint64_t)(nowMs % periodMs) << 8) / periodMs);
+    }
+
+    // Channel value at a perceived level, brightness and gamma applied
+    uint8_t scale(uint8_t channel, uint8_t level) const {
+        uint32_t perceived = (uint32_t)channel * level * _brightness / (255u * 255u);
+        return _tables.gamma[perceived];
+    }
+
+    void put(uint8_t* px, Rgb color, uint8_t level) const {
+        px[0] = scale(color.g, level);
+        px[1] = scale(color.r, level);
+        px[2] = scale(color.b, level);
+    }
+
+    void fill(uint8_t* frame, size_t pixels, Rgb color, uint8_t level) const {
+        uint8_t px[3];
+        put(px, color, level);
+        for (size_t i = 0; i < pixels; i++) {
+            frame[i * 3] = px[0];
+            frame[i * 3 + 1] = px[1];
+            frame[i * 3 + 2] = px[2];
+        }
+    }
+
+    const LedTables& _tables;
+    LedEffect _effect;
+    Rgb _color;
+    uint8_t _brightness;
+};
+
+// When the LED task sends frames. The transmitter refuses a frame while
+// the previous one is still on the wire. A skipped animation frame is
+// replaced 20 ms later, but a Blink edge is the only frame of its
+// period: dropped, the LED stays wrong until the next edge. A refused
+// frame is kept pending and the task wakes every retryMs to send it
+// again until it lands.
+class LedFramePacer {
+public:
+    LedFramePacer(int64_t frameIntervalMs, int64_t retryMs)
+        : _frameIntervalMs(frameIntervalMs), _retryMs(retryMs) {}
+
+    // Result of handing a frame to the transmitter
+    void sent(bool accepted) { _pending = !accepted; }
+    bool pending() const { return _pending; }
+
+    // How long to sleep with remainingMs to the next toggle
+    int64_t waitMs(int64_t remainingMs, bool animated) const {
+        int64_t cap = remainingMs;
+        if (animated && cap > _frameIntervalMs) cap = _frameIntervalMs;
+        if (_pending && cap > _retryMs) cap = _retryMs;
+        return cap;
+    }
+
+    // Whether a wake before the toggle sends a frame
+    bool frameDue(bool animated) const { return animated || _pending; }
+
+private:
+    int64_t _frameIntervalMs;
+    int64_t _retryMs;
+    bool _pending = false;
+};
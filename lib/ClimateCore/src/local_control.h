@@ -0,0 +1,323 @@
+// ============================================
+// LOCAL CONTROL PROTOCOL
+// Minimal HTTP/1.1 handler for the LAN control endpoint:
+//   GET  /delay            -> 200 {"delay":n}
+//   POST /delay {"delay":n} -> 200 {"delay":n} (400 if out of range)
+//   OPTIONS *              -> 204 (CORS preflight)
+// /delay needs "Authorization: Bearer <token>" (401 otherwise): the
+// port is reachable by any page the browser has open, and the CORS
+// headers let every origin read the answer.
+//
+// ControlRequest is fed the bytes recv() returns and keeps only the
+// request line, Content-Length, Authorization and a short body, so a
+// browser's kilobytes of cookies and client hints pass through a
+// fixed buffer. receiveControlRequest() bounds the whole request in
+// time, since one slow client would otherwise hold the endpoint. The
+// response is written in one piece with Connection: close.
+//
+// Target must provide:
+//   int delay() const;
+//   bool setDelay(int delay);   // false when rejected
+// Plain C++ (no Arduino dependency).
+// ============================================
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+const size_t CONTROL_LINE_MAX = 128;      // longer header lines are cut (only names are matched)
+const size_t CONTROL_TOKEN_MAX = 64;
+const size_t CONTROL_BODY_MAX = 64;
+const size_t CONTROL_HEADERS_MAX = 8192;  // whole header block, before 431
+
+inline bool controlStartsWith(const char* buf, size_t len, const char* prefix) {
+    size_t n = strlen(prefix);
+    return len >= n && memcmp(buf, prefix, n) == 0;
+}
+
+// Case-insensitive header name match at the start of line ("name:")
+inline bool controlHeaderIs(const char* line, size_t len, const char* name) {
+    size_t n = strlen(name);
+    if (len <= n || line[n] != ':') return false;
+    for (size_t i = 0; i < n; i++) {
+        char c = line[i];
+        if (c >= 'A' && c <= 'Z') c = (char)(c - 'A' + 'a');
+        if (c != name[i]) return false;
+    }
+    return true;
+}
+
+class ControlRequest {
+public:
+    enum class Status : uint8_t { Reading, Complete, BadRequest, HeadersTooLarge, BodyTooLarge, TimedOut };
+
+    ControlRequest() { reset(); }
+
+    void reset() {
+        _status = Status::Reading;
+        _inBody = false;
+        _firstLine = true;
+        _lineLen = 0;
+        _headerBytes = 0;
+        _contentLength = 0;
+        _bodyLen = 0;
+        _method[0] = '\0';
+        _path[0] = '\0';
+        _token[0] = '\0';
+    }
+
+    // Consumes received bytes; true once nothing more is needed
+    // (complete, or an error that has its own response)
+    bool feed(const char* data, size_t len) {
+        for (size_t i = 0; i < len && _status == Status::Reading; i++) {
+            if (_inBody) {
+                _body[_bodyLen++] = data[i];
+                if (_bodyLen == _contentLength) _status = Status::Complete;
+                continue;
+            }
+            if (++_headerBytes > CONTROL_HEADERS_MAX) {
+                _status = Status::HeadersTooLarge;
+                break;
+            }
+            char c = data[i];
+            if (c == '\n') {
+                if (_lineLen > 0 && _line[_lineLen - 1] == '\r') _lineLen--;
+                endLine();
+                _lineLen = 0;
+            } else if (_lineLen < CONTROL_LINE_MAX) {
+                _line[_lineLen++] = c;
+            }
+        }
+        return done();
+    }
+
+    // The request did not arrive in time; answered with 408
+    void timeOut() {
+        if (_status == Status::Reading) _status = Status::TimedOut;
+    }
+
+    bool done() const { return _status != Status::Reading; }
+    Status status() const { return _status; }
+    const char* method() const { return _method; }
+    const char* path() const { return _path; }
+    const char* token() const { return _token; }
+    const char* body() const { return _body; }
+    size_t bodyLength() const { return _bodyLen; }
+
+private:
+    void endLine() {
+        if (_firstLine) {
+            _firstLine = false;
+            requestLine();
+            return;
+        }
+        if (_lineLen == 0) {
+            // End of headers
+            if (_contentLength > CONTROL_BODY_MAX) {
+                _status = Status::BodyTooLarge;
+            } else if (_contentLength == 0) {
+                _status = Status::Complete;
+            } else {
+                _inBody = true;
+            }
+            return;
+        }
+
+        const char* line = _line;
+        if (controlHeaderIs(line, _lineLen, "content-length")) {
+            char digits[12];
+            size_t n = copyValue(line + 15, _lineLen - 15, digits, sizeof(digits));
+            if (n == 0 || strspn(digits, "0123456789") != n) {
+                _status = Status::BadRequest;
+                return;
+            }
+            _contentLength = (size_t)strtoul(digits, nullptr, 10);
+        } else if (controlHeaderIs(line, _lineLen, "authorization")) {
+            char value[CONTROL_TOKEN_MAX + 8];
+            size_t n = copyValue(line + 14, _lineLen - 14, value, sizeof(value));
+            if (n > 7 && controlStartsWith(value, n, "Bearer ")) {
+                memcpy(_token, value + 7, n - 7 + 1);
+            }
+        }
+    }
+
+    // METHOD SP PATH SP VERSION
+    void requestLine() {
+        const char* space = (const char*)memchr(_line, ' ', _lineLen);
+        size_t methodLen = space ? (size_t)(space - _line) : 0;
+        if (methodLen == 0 || methodLen >= sizeof(_method)) {
+            _status = Status::BadRequest;
+            return;
+        }
+        memcpy(_method, _line, methodLen);
+        _method[methodLen] = '\0';
+
+        const char* path = space + 1;
+        size_t rest = _lineLen - methodLen - 1;
+        const char* end = (const char*)memchr(path, ' ', rest);
+        size_t pathLen = end ? (size_t)(end - path) : rest;
+        if (pathLen >= sizeof(_path)) pathLen = sizeof(_path) - 1;
+        memcpy(_path, path, pathLen);
+        _path[pathLen] = '\0';
+    }
+
+    // Header value without surrounding spaces, cut to fit; returns its length
+    static size_t copyValue(const char* value, size_t len, char* out, size_t size) {
+        while (len > 0 && (*value == ' ' || *value == '\t')) {
+            value++;
+            len--;
+        }
+        while (len > 0 && (value[len - 1] == ' ' || value[len - 1] == '\t')) len--;
+        if (len >= size) len = size - 1;
+        memcpy(out, value, len);
+        out[len] = '\0';
+        return len;
+    }
+
+    Status _status;
+    bool _inBody;
+    bool _firstLine;
+    char _line[CONTROL_LINE_MAX];
+    size_t _lineLen;
+    size_t _headerBytes;
+    size_t _contentLength;
+    char _body[CONTROL_BODY_MAX];
+    size_t _bodyLen;
+    char _method[8];
+    char _path[32];
+    char _token[CONTROL_TOKEN_MAX + 1];
+};
+
+// Receives one request into request, chunk by chunk through buffer.
+// recv(buffer, size, timeoutMs) is recv() with that receive timeout:
+// bytes read, 0 when the peer closed, negative on error or timeout.
+// nowMs() is a millisecond clock. Each recv waits at most recvTimeoutMs,
+// and the whole request must be in within deadlineMs, else it is marked
+// TimedOut: requests are served one at a time, so a client sending a
+// byte every so often must not hold the endpoint for longer than that.
+template <typename Recv, typename Clock>
+void receiveControlRequest(ControlRequest& request, char* buffer, size_t size,
+                           uint32_t recvTimeoutMs, uint32_t deadlineMs, Recv&& recv, Clock&& nowMs) {
+    request.reset();
+    uint32_t start = nowMs();
+    while (!request.done()) {
+        uint32_t elapsed = nowMs() - start;
+        if (elapsed >= deadlineMs) {
+            request.timeOut();
+            return;
+        }
+        uint32_t waitMs = deadlineMs - elapsed;
+        if (waitMs > recvTimeoutMs) waitMs = recvTimeoutMs;
+        int n = recv(buffer, size, waitMs);
+        if (n <= 0) return;
+        request.feed(buffer, (size_t)n);
+    }
+}
+
+// Constant-time compare, so the answer time says nothing about how much
+// of a guessed token was right. An empty expected token matches nothing.
+inline bool controlTokenMatches(const char* expected, const char* given) {
+    size_t n = strlen(expected);
+    if (n == 0 || strlen(given) != n) return false;
+    uint8_t diff = 0;
+    for (size_t i = 0; i < n; i++) diff |= (uint8_t)(expected[i] ^ given[i]);
+    return diff == 0;
+}
+
+// Pulls n out of {"delay": n}; false when missing or not a number
+inline bool parseControlDelay(const char* body, size_t len, int& delay) {
+    static const char KEY[] = "\"delay\"";
+    const size_t keyLen = sizeof(KEY) - 1;
+    for (size_t i = 0; i + keyLen <= len; i++) {
+        if (memcmp(body + i, KEY, keyLen) != 0) continue;
+        size_t p = i + keyLen;
+        while (p < len && (body[p] == ' ' || body[p] == ':')) p++;
+        if (p >= len || !((body[p] >= '0' && body[p] <= '9') || body[p] == '-')) return false;
+
+        char number[12];
+        size_t n = 0;
+        while (p < len && n < sizeof(number) - 1 && ((body[p] >= '0' && body[p] <= '9') || (n == 0 && body[p] == '-'))) {
+            number[n++] = body[p++];
+        }
+        number[n] = '\0';
+        delay = atoi(number);
+        return true;
+    }
+    return false;
+}
+
+inline size_t writeControlResponse(char* out, size_t size, int status, const char* reason, const char* body) {
+    size_t bodyLen = body ? strlen(body) : 0;
+    int n = snprintf(out, size,
+                     "HTTP/1.1 %d %s\r\n"
+                     "Access-Control-Allow-Origin: *\r\n"
+                     "Access-Control-Allow-Methods: GET, POST, OPTIONS\r\n"
+                     "Access-Control-Allow-Headers: Authorization, Content-Type\r\n"
+                     "Access-Control-Allow-Private-Network: true\r\n"
+                     "Cache-Control: no-store\r\n"
+                     "Content-Type: application/json\r\n"
+                     "Content-Length: %u\r\n"
+                     "Connection: close\r\n"
+                     "\r\n"
+                     "%s",
+                     status, reason, (unsigned)bodyLen, body ? body : "");
+    return (n < 0 || (size_t)n >= size) ? 0 : (size_t)n;
+}
+
+// Answers a finished ControlRequest (or one cut short, which gets a
+// 400) into out; returns the response length (0 if out is too small).
+// token is what Authorization: Bearer must carry.
+template <typename Target>
+size_t handleControlRequest(const ControlRequest& request, Target& target, const char* token, char* out, size_t size) {
+    switch (request.status()) {
+        case ControlRequest::Status::Reading:
+            return writeControlResponse(out, size, 400, "Bad Request", "{\"error\":\"Incomplete request\"}");
+        case ControlRequest::Status::BadRequest:
+            return writeControlResponse(out, size, 400, "Bad Request", "{\"error\":\"Bad request\"}");
+        case ControlRequest::Status::HeadersTooLarge:
+            return writeControlResponse(out, size, 431, "Request Header Fields Too Large", "{\"error\":\"Headers too large\"}");
+        case ControlRequest::Status::BodyTooLarge:
+            return writeControlResponse(out, size, 413, "Payload Too Large", "{\"error\":\"Body too large\"}");
+        case ControlRequest::Status::TimedOut:
+            return writeControlResponse(out, size, 408, "Request Timeout", "{\"error\":\"Request too slow\"}");
+        case ControlRequest::Status::Complete:
+            break;
+    }
+
+    const char* method = request.method();
+    if (strcmp(method, "OPTIONS") == 0) {
+        return writeControlResponse(out, size, 204, "No Content", nullptr);
+    }
+
+    const char* path = request.path();
+    bool delayPath = strcmp(path, "/delay") == 0 || controlStartsWith(path, strlen(path), "/delay?");
+    if (!delayPath) return writeControlResponse(out, size, 404, "Not Found", "{\"error\":\"Not found\"}");
+
+    if (!controlTokenMatches(token, request.token())) {
+        return writeControlResponse(out, size, 401, "Unauthorized", "{\"error\":\"Missing or wrong token\"}");
+    }
+
+    char body[32];
+    if (strcmp(method, "GET") == 0) {
+        snprintf(body, sizeof(body), "{\"delay\":%d}", target.delay());
+        return writeControlResponse(out, size, 200, "OK", body);
+    }
+
+    if (strcmp(method, "POST") == 0) {
+        int delay = 0;
+        if (!parseControlDelay(request.body(), request.bodyLength(), delay)) {
+            return writeControlResponse(out, size, 400, "Bad Request", "{\"error\":\"Expected {\\\"delay\\\": n}\"}");
+        }
+        if (!target.setDelay(delay)) {
+            return writeControlResponse(out, size, 400, "Bad Request", "{\"error\":\"Delay out of range\"}");
+        }
+        snprintf(body, sizeof(body), "{\"delay\":%d}", target.delay());
+        return writeControlResponse(out, size, 200, "OK", body);
+    }
+
+    return writeControlResponse(out, size, 405, "Method Not Allowed", "{\"error\":\"Method not allowed\"}");
+}
@@ -0,0 +1,219 @@
+// ============================================
+// RATE CONTROLLER
+// Sampling and upload pacing that follow the signal and the
+// server instead of fixed intervals.
+//
+// AdaptiveSampler picks the delay to the next sample from how
+// fast the readings move, in units of their error bounds: a
+// fast change drops to minSampleMs at once, a steady signal
+// backs off gradually (x1.5 per sample) to maxSampleMs. Feed it
+// raw readings; the median filter lags by several samples at
+// long intervals. Moves up to 1.5 bounds (one sensor LSB of
+// jitter) count as noise.
+//
+// UploadThrottle gates uploads on the server's answers: 2xx
+// clears it, 429/503 wait out Retry-After, other 5xx, 408 and
+// transport errors back off exponentially with jitter, and
+// minUploadGapMs spaces uploads. A batch refused with another
+// 4xx will be refused again: uploadOutcome() tells the caller to
+// drop it rather than retry it.
+//
+// RateLimits can be pushed by the server (see api/sensor.js)
+// and are kept across reboots by the caller.
+// Plain C++ (no Arduino dependency).
+// ============================================
+
+#pragma once
+
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+struct RateLimits {
+    uint32_t minSampleMs = 2000;        // DHT22 minimum
+    uint32_t maxSampleMs = 30000;
+    uint32_t minUploadGapMs = 0;
+    uint32_t version = 0;               // 0: built-in defaults
+};
+
+// Keeps pushed limits inside what the hardware and firmware allow
+inline RateLimits clampRateLimits(RateLimits limits, uint32_t floorSampleMs, uint32_t ceilingMs) {
+    if (limits.minSampleMs < floorSampleMs) limits.minSampleMs = floorSampleMs;
+    if (limits.minSampleMs > ceilingMs) limits.minSampleMs = ceilingMs;
+    if (limits.maxSampleMs < limits.minSampleMs) limits.maxSampleMs = limits.minSampleMs;
+    if (limits.maxSampleMs > ceilingMs) limits.maxSampleMs = ceilingMs;
+    if (limits.minUploadGapMs > ceilingMs) limits.minUploadGapMs = ceilingMs;
+    return limits;
+}
+
+// Retry-After as delta-seconds ("120"); 0 when absent or an HTTP-date
+inline uint32_t parseRetryAfterMs(const char* value) {
+    if (!value) return 0;
+    while (*value == ' ') value++;
+    if (*value < '0' || *value > '9') return 0;
+    unsigned long seconds = strtoul(value, nullptr, 10);
+    if (seconds > 86400) seconds = 86400;
+    return (uint32_t)seconds * 1000;
+}
+
+template <size_t N>
+class AdaptiveSampler {
+public:
+    AdaptiveSampler(const float (&errorBounds)[N], const RateLimits& limits) {
+        for (size_t i = 0; i < N; i++) _bounds[i] = errorBounds[i];
+        setLimits(limits);
+        _intervalMs = _limits.minSampleMs;
+    }
+
+    void setLimits(const RateLimits& limits) {
+        _limits = limits;
+        _intervalMs = clamp(_intervalMs);
+    }
+
+    // Feed every raw sample (before the median filter); returns the
+    // delay until the next one
+    uint32_t onSample(uint32_t nowMs, const float (&values)[N]) {
+        if (_primed) {
+            uint32_t dt = nowMs - _lastMs;
+            if (dt == 0) dt = 1;
+
+            // Bounds per ms on the fastest channel
+            float rate = 0;
+            for (size_t i = 0; i < N; i++) {
+                float moved = fabsf(values[i] - _last[i]) / _bounds[i];
+                if (moved < NOISE_BOUNDS) moved = 0;
+                float r = moved / dt;
+                if (r > rate) rate = r;
+            }
+            // Peak hold, slow decay: one quick move keeps the rate up a while
+            _rate = rate > _rate ? rate : _rate * (1 - DECAY) + rate * DECAY;
+
+            // Aim for about one error bound of change per sample
+            float targetMs = _rate > 0 ? TARGET_BOUNDS / _rate : (float)_limits.maxSampleMs;
+            uint32_t target = targetMs >= (float)_limits.maxSampleMs ? _limits.maxSampleMs : (uint32_t)targetMs;
+            uint32_t grown = (uint32_t)(_intervalMs * GROWTH);
+            _intervalMs = clamp(target < _intervalMs ? target : (target < grown ? target : grown));
+        }
+
+        for (size_t i = 0; i < N; i++) _last[i] = values[i];
+        _lastMs = nowMs;
+        _primed = true;
+        return _intervalMs;
+    }
+
+    uint32_t intervalMs() const { return _intervalMs; }
+    const RateLimits& limits() const { return _limits; }
+
+private:
+    static constexpr float NOISE_BOUNDS = 1.5f;
+    static constexpr float TARGET_BOUNDS = 1.0f;
+    static constexpr float DECAY = 0.2f;
+    static constexpr float GROWTH = 1.5f;
+
+    uint32_t clamp(uint32_t ms) const {
+        if (ms < _limits.minSampleMs) return _limits.minSampleMs;
+        if (ms > _limits.maxSampleMs) return _limits.maxSampleMs;
+        return ms;
+    }
+
+    float _bounds[N];
+    float _last[N] = {};
+    uint32_t _lastMs = 0;
+    bool _primed = false;
+    float _rate = 0;
+    uint32_t _intervalMs = 0;
+    RateLimits _limits;
+};
+
+enum class UploadOutcome : uint8_t {
+    Delivered,      // 2xx
+    Retry,          // transport error, 3xx, 408, 429, 5xx: keep the batch
+    Rejected        // any other 4xx: sending it again can't help, drop it
+};
+
+// httpCode <= 0 is a transport error
+inline UploadOutcome uploadOutcome(int httpCode) {
+    if (httpCode >= 200 && httpCode < 300) return UploadOutcome::Delivered;
+    if (httpCode >= 400 && httpCode < 500 && httpCode != 408 && httpCode != 429) return UploadOutcome::Rejected;
+    return UploadOutcome::Retry;
+}
+
+struct UploadThrottleConfig {
+    uint32_t initialBackoffMs = 5000;
+    uint32_t maxBackoffMs = 600000;     // also caps Retry-After
+};
+
+class UploadThrottle {
+public:
+    explicit UploadThrottle(const UploadThrottleConfig& config = UploadThrottleConfig(), uint32_t seed = 1)
+        : _config(config), _rng(seed ? seed : 1) {}
+
+    void setMinGapMs(uint32_t gapMs) { _minGapMs = gapMs; }
+
+    bool allowed(uint32_t nowMs) const {
+        return !_waiting || (int32_t)(nowMs - _resumeAtMs) >= 0;
+    }
+
+    // httpCode <= 0 is a transport error; retryAfterMs 0 when absent
+    void onResult(uint32_t nowMs, int httpCode, uint32_t retryAfterMs) {
+        UploadOutcome outcome = uploadOutcome(httpCode);
+        if (outcome == UploadOutcome::Delivered) {
+            _failures = 0;
+            waitUntil(nowMs, _minGapMs);
+            return;
+        }
+        if (outcome == UploadOutcome::Rejected) {
+            // The request was wrong, not the server busy: no reason to wait
+            waitUntil(nowMs, _minGapMs);
+            return;
+        }
+
+        _failures++;
+        _backoffs++;
+        if ((httpCode == 429 || httpCode == 503) && retryAfterMs > 0) {
+            uint32_t ms = retryAfterMs < _config.maxBackoffMs ? retryAfterMs : _config.maxBackoffMs;
+            // Up to 10% extra so a fleet told the same time doesn't return at once
+            waitUntil(nowMs, ms + nextRandom() % (ms / 10 + 1));
+        } else {
+            waitUntil(nowMs, backoffMs());
+        }
+    }
+
+    uint32_t resumeAtMs() const { return _resumeAtMs; }
+    uint32_t failures() const { return _failures; }
+    uint32_t backoffs() const { return _backoffs; }
+
+private:
+    // Same shape as WiFiReconnect: exponential, capped, upper half random
+    uint32_t backoffMs() {
+        uint32_t base = _config.initialBackoffMs;
+        for (uint32_t i = 1; i < _failures && base < _config.maxBackoffMs; i++) {
+            base *= 2;
+        }
+        if (base > _config.maxBackoffMs) base = _config.maxBackoffMs;
+        uint32_t half = base / 2;
+        return half + (half ? nextRandom() % (half + 1) : 0);
+    }
+
+    void waitUntil(uint32_t nowMs, uint32_t delayMs) {
+        _waiting = delayMs > 0;
+        _resumeAtMs = nowMs + delayMs;
+    }
+
+    // xorshift32
+    uint32_t nextRandom() {
+        _rng ^= _rng << 13;
+        _rng ^= _rng >> 17;
+        _rng ^= _rng << 5;
+        return _rng;
+    }
+
+    UploadThrottleConfig _config;
+    uint32_t _minGapMs = 0;
+    uint32_t _resumeAtMs = 0;
+    uint32_t _failures = 0;
+    uint32_t _backoffs = 0;
+    uint32_t _rng;
+    bool _waiting = false;
+};
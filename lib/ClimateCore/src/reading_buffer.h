@@ -0,0 +1,70 @@
+// ============================================
+// READING BUFFER
+// Fixed-capacity ring buffer that batches sensor readings
+// until either a count or an age threshold is reached.
+// Plain C++ (no Arduino dependency).
+// ============================================
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+struct Reading {
+    float temperature;
+    float humidity;
+    uint32_t capturedMs;    // millis() at capture
+    int64_t epochMs;        // wall clock at capture, 0 when not yet synced (device_clock.h)
+};
+
+template <size_t Capacity>
+class ReadingBuffer {
+public:
+    ReadingBuffer(size_t flushCount, uint32_t flushAgeMs)
+        : _flushCount(flushCount < Capacity ? flushCount : Capacity),
+          _flushAgeMs(flushAgeMs) {}
+
+    // Appends a reading. When full the oldest entry is overwritten
+    // and false is returned so the caller can log the loss.
+    bool push(const Reading& reading) {
+        bool kept = true;
+        if (_count == Capacity) {
+            _head = (_head + 1) % Capacity;
+            _count--;
+            kept = false;
+        }
+        _items[(_head + _count) % Capacity] = reading;
+        _count++;
+        return kept;
+    }
+
+    // True once enough readings are queued or the oldest one is too old
+    bool shouldFlush(uint32_t nowMs) const {
+        if (_count == 0) return false;
+        if (_count >= _flushCount) return true;
+        return nowMs - at(0).capturedMs >= _flushAgeMs;
+    }
+
+    // Index 0 is the oldest queued reading
+    const Reading& at(size_t index) const {
+        return _items[(_head + index) % Capacity];
+    }
+
+    // Removes the n oldest readings (after they were delivered)
+    void drop(size_t n) {
+        if (n > _count) n = _count;
+        _head = (_head + n) % Capacity;
+        _count -= n;
+    }
+
+    size_t size() const { return _count; }
+    bool empty() const { return _count == 0; }
+    static constexpr size_t capacity() { return Capacity; }
+
+private:
+    Reading _items[Capacity];
+    size_t _head = 0;
+    size_t _count = 0;
+    size_t _flushCount;
+    uint32_t _flushAgeMs;
+};
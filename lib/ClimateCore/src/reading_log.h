@@ -0,0 +1,229 @@
+// ============================================
+// READING LOG
+// Bounded store-and-forward log for readings that could not be
+// uploaded. Records live in a ring of fixed 24-byte slots; a
+// record's slot is its sequence number modulo the slot count, so
+// appends never rewrite older data except when the ring wraps.
+// The drained position is kept in two ping-pong cursor slots.
+//
+// Every record and cursor carries a CRC, so after a power cut a
+// torn write is simply ignored on the next mount: at most the
+// record being written is lost, and a torn cursor falls back to
+// the previous one (the last batch is re-sent, never skipped).
+//
+// Storage must provide:
+//   bool read(uint32_t offset, void* dst, size_t len);
+//   bool write(uint32_t offset, const void* src, size_t len);
+//   size_t size() const;
+// Plain C++ (no Arduino dependency).
+// ============================================
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "reading_buffer.h"
+
+inline uint32_t logCrc32(const uint8_t* data, size_t len) {
+    uint32_t crc = 0xFFFFFFFF;
+    for (size_t i = 0; i < len; i++) {
+        crc ^= data[i];
+        for (int b = 0; b < 8; b++) crc = (crc >> 1) ^ (0xEDB88320 & (0 - (crc & 1)));
+    }
+    return ~crc;
+}
+
+template <typename Storage>
+class ReadingLog {
+public:
+    static const uint32_t CURSOR_SIZE = 16;
+    static const uint32_t RECORD_SIZE = 24;
+    static const uint32_t RECORDS_OFFSET = 2 * CURSOR_SIZE;
+
+    explicit ReadingLog(Storage& storage) : _storage(storage) {}
+
+    // Scans storage and recovers head/tail; must be called before use.
+    // A log left by an older record layout is erased first.
+    bool mount() {
+        if (_storage.size() < RECORDS_OFFSET + RECORD_SIZE) return false;
+        _slots = (_storage.size() - RECORDS_OFFSET) / RECORD_SIZE;
+        _erasedOldLayout = false;
+        if (hasOldLayout()) {
+            if (!erase()) return false;
+            _erasedOldLayout = true;
+        }
+
+        // Newest valid cursor wins
+        _cursorGeneration = 0;
+        _drainedSeq = 0;
+        for (uint32_t i = 0; i < 2; i++) {
+            uint32_t generation, drained;
+            if (readCursor(i, generation, drained) && generation >= _cursorGeneration) {
+                _cursorGeneration = generation;
+                _drainedSeq = drained;
+            }
+        }
+
+        // Head is one past the newest valid record
+        _headSeq = _drainedSeq;
+        for (uint32_t slot = 0; slot < _slots; slot++) {
+            uint32_t seq;
+            Reading r;
+            if (readRecord(slot, seq, r) && seq >= _headSeq) _headSeq = seq + 1;
+        }
+        _mounted = true;
+        return true;
+    }
+
+    bool append(const Reading& reading) {
+        if (!_mounted) return false;
+        bool full = size() == _slots;
+        if (!writeRecord(_headSeq, reading)) return false;
+        _headSeq++;
+        if (full) _lost++;   // the oldest undelivered record was overwritten
+        return true;
+    }
+
+    // Copies up to max of the oldest undelivered readings into out.
+    // Slots that were overwritten or torn are skipped. Call consume()
+    // once they were delivered.
+    size_t peek(Reading* out, size_t max) {
+        size_t n = 0;
+        _peekSkipped = 0;
+        uint32_t seq = tailSeq();
+        while (seq < _headSeq && n < max) {
+            uint32_t stored;
+            Reading r;
+            if (readRecord(seq % _slots, stored, r) && stored == seq) {
+                out[n++] = r;
+            } else {
+                _peekSkipped++;
+            }
+            seq++;
+        }
+        _peekEndSeq = seq;
+        return n;
+    }
+
+    // Marks everything returned by the last peek() as delivered
+    bool consume() {
+        if (_peekEndSeq <= _drainedSeq) return true;
+        uint32_t generation = _cursorGeneration + 1;
+        if (!writeCursor(generation % 2, generation, _peekEndSeq)) return false;
+        _cursorGeneration = generation;
+        _drainedSeq = _peekEndSeq;
+        _lost += _peekSkipped;
+        _peekSkipped = 0;
+        return true;
+    }
+
+    size_t size() const { return _headSeq - tailSeq(); }
+    bool empty() const { return size() == 0; }
+    uint32_t capacity() const { return _slots; }
+    uint32_t lost() const { return _lost; }
+    // True when the last mount() found and erased an older layout
+    bool erasedOldLayout() const { return _erasedOldLayout; }
+
+private:
+    // Oldest sequence that may still be in storage
+    uint32_t tailSeq() const {
+        uint32_t oldest = _headSeq > _slots ? _headSeq - _slots : 0;
+        return _drainedSeq > oldest ? _drainedSeq : oldest;
+    }
+
+    static void putU32(uint8_t* p, uint32_t v) {
+        p[0] = (uint8_t)v; p[1] = (uint8_t)(v >> 8); p[2] = (uint8_t)(v >> 16); p[3] = (uint8_t)(v >> 24);
+    }
+    static uint32_t getU32(const uint8_t* p) {
+        return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+    }
+
+    // Record: seq u32, time u32, epoch ms i64, temperature i16 (0.01),
+    // humidity u16 (0.01), crc u32. The epoch is what survives a reboot;
+    // time is only meaningful within the boot that wrote it.
+    bool writeRecord(uint32_t seq, const Reading& r) {
+        uint8_t buf[RECORD_SIZE];
+        putU32(buf, seq);
+        putU32(buf + 4, r.capturedMs);
+        putU32(buf + 8, (uint32_t)((uint64_t)r.epochMs));
+        putU32(buf + 12, (uint32_t)((uint64_t)r.epochMs >> 32));
+        int16_t t = (int16_t)(r.temperature * 100.0f + (r.temperature < 0 ? -0.5f : 0.5f));
+        uint16_t h = (uint16_t)(r.humidity * 100.0f + 0.5f);
+        buf[16] = (uint8_t)t; buf[17] = (uint8_t)((uint16_t)t >> 8);
+        buf[18] = (uint8_t)h; buf[19] = (uint8_t)(h >> 8);
+        putU32(buf + 20, logCrc32(buf, 20));
+        return _storage.write(RECORDS_OFFSET + (seq % _slots) * RECORD_SIZE, buf, RECORD_SIZE);
+    }
+
+    bool readRecord(uint32_t slot, uint32_t& seq, Reading& r) {
+        uint8_t buf[RECORD_SIZE];
+        if (!_storage.read(RECORDS_OFFSET + slot * RECORD_SIZE, buf, RECORD_SIZE)) return false;
+        if (getU32(buf + 20) != logCrc32(buf, 20)) return false;
+        seq = getU32(buf);
+        if (seq % _slots != slot) return false;
+        r.capturedMs = getU32(buf + 4);
+        r.epochMs = (int64_t)((uint64_t)getU32(buf + 8) | ((uint64_t)getU32(buf + 12) << 32));
+        r.temperature = (int16_t)(buf[16] | (buf[17] << 8)) / 100.0f;
+        r.humidity = (uint16_t)(buf[18] | (buf[19] << 8)) / 100.0f;
+        return true;
+    }
+
+    // Cursor: magic u32, generation u32, drained seq u32, crc u32
+    bool writeCursor(uint32_t index, uint32_t generation, uint32_t drained) {
+        uint8_t buf[CURSOR_SIZE];
+        putU32(buf, CURSOR_MAGIC);
+        putU32(buf + 4, generation);
+        putU32(buf + 8, drained);
+        putU32(buf + 12, logCrc32(buf, 12));
+        return _storage.write(index * CURSOR_SIZE, buf, CURSOR_SIZE);
+    }
+
+    bool readCursor(uint32_t index, uint32_t& generation, uint32_t& drained) {
+        uint8_t buf[CURSOR_SIZE];
+        if (!_storage.read(index * CURSOR_SIZE, buf, CURSOR_SIZE)) return false;
+        if (getU32(buf) != CURSOR_MAGIC || getU32(buf + 12) != logCrc32(buf, 12)) return false;
+        generation = getU32(buf + 4);
+        drained = getU32(buf + 8);
+        return true;
+    }
+
+    // A cursor stamped "RLG" with another version byte
+    bool hasOldLayout() {
+        for (uint32_t i = 0; i < 2; i++) {
+            uint8_t magic[4];
+            if (!_storage.read(i * CURSOR_SIZE, magic, sizeof(magic))) return false;
+            uint32_t value = getU32(magic);
+            if ((value & 0x00FFFFFF) == (CURSOR_MAGIC & 0x00FFFFFF) && value != CURSOR_MAGIC) return true;
+        }
+        return false;
+    }
+
+    // Back to the blank (0xFF) state, cursors last so a cut before
+    // them leaves the old magic and the next mount erases again
+    bool erase() {
+        uint8_t blank[64];
+        for (size_t i = 0; i < sizeof(blank); i++) blank[i] = 0xFF;
+        for (size_t offset = _storage.size(); offset > 0;) {
+            size_t chunk = offset < sizeof(blank) ? offset : sizeof(blank);
+            offset -= chunk;
+            if (!_storage.write((uint32_t)offset, blank, chunk)) return false;
+        }
+        return true;
+    }
+
+    // Bumped with the record layout: logs from older firmware are not
+    // misread, mount() erases them
+    static const uint32_t CURSOR_MAGIC = 0x32474C52;   // "RLG2"
+
+    Storage& _storage;
+    uint32_t _slots = 0;
+    uint32_t _headSeq = 0;
+    uint32_t _drainedSeq = 0;
+    uint32_t _peekEndSeq = 0;
+    uint32_t _cursorGeneration = 0;
+    uint32_t _peekSkipped = 0;
+    uint32_t _lost = 0;
+    bool _mounted = false;
+    bool _erasedOldLayout = false;
+};
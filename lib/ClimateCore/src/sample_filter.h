@@ -0,0 +1,64 @@
+// ============================================
+// SAMPLE FILTER
+// Sliding median over the last Window raw samples (rejects
+// single glitches) followed by an exponential moving average.
+// Plain C++ (no Arduino dependency).
+// ============================================
+
+#pragma once
+
+#include <stddef.h>
+
+template <size_t Window>
+class SampleFilter {
+public:
+    // alpha = 1 disables smoothing (median only)
+    explicit SampleFilter(float alpha) : _alpha(alpha) {}
+
+    // Adds a raw sample and returns the filtered value
+    float add(float value) {
+        _window[_next] = value;
+        _next = (_next + 1) % Window;
+        if (_count < Window) _count++;
+
+        float m = median();
+        _value = _hasValue ? _value + _alpha * (m - _value) : m;
+        _hasValue = true;
+        return _value;
+    }
+
+    bool ready() const { return _hasValue; }
+    float value() const { return _value; }
+    size_t count() const { return _count; }
+
+    void reset() {
+        _count = 0;
+        _next = 0;
+        _hasValue = false;
+    }
+
+private:
+    float median() const {
+        float sorted[Window];
+        for (size_t i = 0; i < _count; i++) sorted[i] = _window[i];
+        // Insertion sort, Window is small
+        for (size_t i = 1; i < _count; i++) {
+            float v = sorted[i];
+            size_t j = i;
+            while (j > 0 && sorted[j - 1] > v) {
+                sorted[j] = sorted[j - 1];
+                j--;
+            }
+            sorted[j] = v;
+        }
+        if (_count % 2) return sorted[_count / 2];
+        return (sorted[_count / 2 - 1] + sorted[_count / 2]) / 2.0f;
+    }
+
+    float _alpha;
+    float _window[Window] = {};
+    size_t _count = 0;
+    size_t _next = 0;
+    float _value = 0;
+    bool _hasValue = false;
+};
@@ -0,0 +1,125 @@
+// ============================================
+// SCHEDULER
+// Deadline-based cooperative scheduler for loop(). Periodic
+// jobs keep their phase (deadline += period, never "now +
+// period"), one-shot jobs run once per at(). After running
+// what is due, idleTime() says how long the caller may sleep.
+// Time is passed in, so it runs on the host with a fake clock.
+// Plain C++ (no Arduino dependency).
+// ============================================
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+template <size_t MaxJobs>
+class Scheduler {
+public:
+    typedef void (*JobFn)(uint32_t nowMs);
+
+    static const int NO_JOB = -1;
+
+    // Periodic job, first due at firstDueMs; returns its id or NO_JOB when full
+    int every(uint32_t periodMs, JobFn fn, uint32_t firstDueMs) {
+        int id = add(periodMs, fn);
+        if (id != NO_JOB) at(id, firstDueMs);
+        return id;
+    }
+
+    // One-shot job; stays idle until armed with at()
+    int once(JobFn fn) { return add(0, fn); }
+
+    // (Re)arms a job to run at dueMs
+    void at(int id, uint32_t dueMs) {
+        if (!valid(id)) return;
+        _jobs[id].dueMs = dueMs;
+        _jobs[id].armed = true;
+    }
+
+    void cancel(int id) {
+        if (valid(id)) _jobs[id].armed = false;
+    }
+
+    bool armed(int id) const { return valid(id) && _jobs[id].armed; }
+    uint32_t dueAt(int id) const { return valid(id) ? _jobs[id].dueMs : 0; }
+
+    // Runs every job whose deadline has passed, earliest deadline first.
+    // A job runs at most once per call even if it re-arms itself for now.
+    size_t runDue(uint32_t nowMs) {
+        bool ran[MaxJobs] = {};
+        size_t runs = 0;
+
+        for (;;) {
+            int next = NO_JOB;
+            for (size_t i = 0; i < _count; i++) {
+                const Job& job = _jobs[i];
+                if (!job.armed || ran[i] || !reached(job.dueMs, nowMs)) continue;
+                if (next == NO_JOB || before(job.dueMs, _jobs[next].dueMs)) next = (int)i;
+            }
+            if (next == NO_JOB) return runs;
+
+            Job& job = _jobs[next];
+            uint32_t late = nowMs - job.dueMs;
+            if (late > _maxLateMs) _maxLateMs = late;
+
+            // Re-arm before running so the job can override it
+            if (job.periodMs > 0) {
+                uint32_t missed = late / job.periodMs;
+                _skipped += missed;
+                job.dueMs += (missed + 1) * job.periodMs;
+            } else {
+                job.armed = false;
+            }
+
+            ran[next] = true;
+            runs++;
+            job.fn(nowMs);
+        }
+    }
+
+    // Milliseconds until the earliest armed deadline (0 if one is
+    // already due), never more than maxMs
+    uint32_t idleTime(uint32_t nowMs, uint32_t maxMs) const {
+        uint32_t idle = maxMs;
+        for (size_t i = 0; i < _count; i++) {
+            const Job& job = _jobs[i];
+            if (!job.armed) continue;
+            if (reached(job.dueMs, nowMs)) return 0;
+            uint32_t wait = job.dueMs - nowMs;
+            if (wait < idle) idle = wait;
+        }
+        return idle;
+    }
+
+    // Worst lateness seen when a job started, and whole periods skipped
+    // because a periodic job fell more than one period behind
+    uint32_t maxLatenessMs() const { return _maxLateMs; }
+    uint32_t skippedPeriods() const { return _skipped; }
+    void resetStats() { _maxLateMs = 0; _skipped = 0; }
+
+private:
+    struct Job {
+        JobFn fn;
+        uint32_t periodMs;
+        uint32_t dueMs;
+        bool armed;
+    };
+
+    int add(uint32_t periodMs, JobFn fn) {
+        if (_count == MaxJobs || !fn) return NO_JOB;
+        _jobs[_count] = Job{ fn, periodMs, 0, false };
+        return (int)_count++;
+    }
+
+    bool valid(int id) const { return id >= 0 && (size_t)id < _count; }
+
+    // Wrap-safe comparisons on the 32-bit millisecond clock
+    static bool reached(uint32_t dueMs, uint32_t nowMs) { return (int32_t)(nowMs - dueMs) >= 0; }
+    static bool before(uint32_t a, uint32_t b) { return (int32_t)(a - b) < 0; }
+
+    Job _jobs[MaxJobs] = {};
+    size_t _count = 0;
+    uint32_t _maxLateMs = 0;
+    uint32_t _skipped = 0;
+};
@@ -0,0 +1,14 @@
+// ============================================
+// SENSOR LOGIC
+// Delay clamping used by the delay watch task
+// (periodic jobs moved to scheduler.h).
+// Plain C++ (no Arduino dependency).
+// ============================================
+
+#pragma once
+
+#include <stdint.h>
+
+inline int clampDelay(int value, int minDelay, int maxDelay) {
+    return value < minDelay ? minDelay : (value > maxDelay ? maxDelay : value);
+}
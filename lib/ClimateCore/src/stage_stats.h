@@ -0,0 +1,70 @@
+// ============================================
+// STAGE STATS
+// One timing histogram per firmware stage (sensor read, DNS,
+// TLS connect, request, JSON parse, LED render/update), in
+// microseconds. Bucket widths are sized per stage so both a
+// 30 us pixel update and a 1 s TLS handshake resolve well.
+// Plain C++ (no Arduino dependency).
+// ============================================
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "histogram.h"
+
+enum class Stage : uint8_t {
+    DhtRead,        // conversion start until the frame is collected
+    Dns,
+    TlsConnect,     // TCP connect + TLS handshake
+    Request,        // send + wait for the response headers
+    JsonParse,      // reading and parsing a response body
+    PixelShow,      // starting the LED transfer
+    LedRender,      // computing one LED frame
+    Count
+};
+
+const size_t STAGE_COUNT = (size_t)Stage::Count;
+
+// Short names used in telemetry payloads
+inline const char* stageName(Stage stage) {
+    switch (stage) {
+        case Stage::DhtRead: return "dht_read";
+        case Stage::Dns: return "dns";
+        case Stage::TlsConnect: return "tls_connect";
+        case Stage::Request: return "request";
+        case Stage::JsonParse: return "json_parse";
+        case Stage::PixelShow: return "pixel_show";
+        case Stage::LedRender: return "led_render";
+        default: return "unknown";
+    }
+}
+
+template <size_t Buckets = 32>
+class StageStats {
+public:
+    StageStats()
+        : _histograms{
+              Histogram<Buckets>(1000),     // DhtRead:    1 ms buckets
+              Histogram<Buckets>(5000),     // Dns:        5 ms
+              Histogram<Buckets>(50000),    // TlsConnect: 50 ms
+              Histogram<Buckets>(25000),    // Request:    25 ms
+              Histogram<Buckets>(500),      // JsonParse:  0.5 ms
+              Histogram<Buckets>(10),       // PixelShow:  10 us
+              Histogram<Buckets>(20),       // LedRender:  20 us
+          } {}
+
+    void record(Stage stage, uint32_t elapsedUs) {
+        if (stage < Stage::Count) _histograms[(size_t)stage].record(elapsedUs);
+    }
+
+    const Histogram<Buckets>& operator[](Stage stage) const { return _histograms[(size_t)stage]; }
+
+    void reset() {
+        for (size_t i = 0; i < STAGE_COUNT; i++) _histograms[i].reset();
+    }
+
+private:
+    Histogram<Buckets> _histograms[STAGE_COUNT];
+};
@@ -0,0 +1,125 @@
+// ============================================
+// SWINGING DOOR COMPRESSION
+// Multi-channel swinging-door trend compression. A sample is only
+// emitted when linear interpolation between emitted samples would
+// otherwise miss some channel by more than its error bound, or when
+// nothing was emitted for maxSilenceMs (heartbeat, sent with the
+// first sample at or after that).
+//
+// Every offered sample is reconstructed within errorBound[c] by
+// interpolating between the emitted ones. Emitted samples may be
+// the previous sample rather than the one just offered, so they
+// carry their own timestamp.
+// Plain C++ (no Arduino dependency).
+// ============================================
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+template <size_t Channels>
+struct TrendSample {
+    uint32_t timeMs;
+    float values[Channels];
+};
+
+template <size_t Channels>
+class SwingingDoor {
+public:
+    typedef TrendSample<Channels> Sample;
+
+    SwingingDoor(const float (&errorBound)[Channels], uint32_t maxSilenceMs)
+        : _maxSilenceMs(maxSilenceMs) {
+        for (size_t c = 0; c < Channels; c++) _errorBound[c] = errorBound[c];
+    }
+
+    // Feeds one sample; returns true and fills out when a sample must be kept
+    bool offer(const Sample& sample, Sample& out) {
+        if (!_hasArchive) {
+            restart(sample);
+            out = sample;
+            return true;
+        }
+
+        if (fitsDoor(sample)) {
+            // Heartbeat: keep the stream alive even when nothing moves.
+            // The line to this sample covers everything since the archive,
+            // so nothing in between has to go out with it
+            if (sample.timeMs - _archive.timeMs >= _maxSilenceMs) {
+                restart(sample);
+                out = sample;
+                return true;
+            }
+            narrowDoor(sample);
+            _last = sample;
+            _hasLast = true;
+            return false;
+        }
+
+        // The door closed: keep the previous sample and swing a new
+        // door from there that already includes this one. This also
+        // stands in for a heartbeat that falls due here.
+        out = _last;
+        restart(_last);
+        narrowDoor(sample);
+        _last = sample;
+        _hasLast = true;
+        return true;
+    }
+
+    // Last sample seen but not emitted (e.g. to flush before sleeping)
+    bool pending(Sample& out) const {
+        if (!_hasLast) return false;
+        out = _last;
+        return true;
+    }
+
+    void reset() {
+        _hasArchive = false;
+        _hasLast = false;
+    }
+
+private:
+    void restart(const Sample& sample) {
+        _archive = sample;
+        _hasArchive = true;
+        _hasLast = false;
+        _doorOpen = false;
+    }
+
+    bool fitsDoor(const Sample& sample) const {
+        if (!_doorOpen) return true;
+        float dt = (float)(sample.timeMs - _archive.timeMs);
+        if (dt <= 0) return true;
+        for (size_t c = 0; c < Channels; c++) {
+            float slope = (sample.values[c] - _archive.values[c]) / dt;
+            if (slope > _upper[c] || slope < _lower[c]) return false;
+        }
+        return true;
+    }
+
+    // Upper slope = min over samples of (v + E - v0)/dt,
+    // lower slope = max over samples of (v - E - v0)/dt
+    void narrowDoor(const Sample& sample) {
+        float dt = (float)(sample.timeMs - _archive.timeMs);
+        if (dt <= 0) return;
+        for (size_t c = 0; c < Channels; c++) {
+            float up = (sample.values[c] + _errorBound[c] - _archive.values[c]) / dt;
+            float low = (sample.values[c] - _errorBound[c] - _archive.values[c]) / dt;
+            if (!_doorOpen || up < _upper[c]) _upper[c] = up;
+            if (!_doorOpen || low > _lower[c]) _lower[c] = low;
+        }
+        _doorOpen = true;
+    }
+
+    float _errorBound[Channels];
+    uint32_t _maxSilenceMs;
+    Sample _archive = {};
+    Sample _last = {};
+    bool _hasArchive = false;
+    bool _hasLast = false;
+    bool _doorOpen = false;
+    float _upper[Channels] = {};
+    float _lower[Channels] = {};
+};
@@ -0,0 +1,128 @@
+// ============================================
+// WIFI RECONNECT
+// Non-blocking reconnect state machine with exponential
+// backoff and jitter. Link events may arrive from another
+// task; poll() is called from loop() and never blocks.
+//
+// Driver must provide:
+//   void begin();       // start an association attempt
+//   void disconnect();  // abort the current attempt
+// Plain C++ (no Arduino dependency).
+// ============================================
+
+#pragma once
+
+#include <stdint.h>
+#include <atomic>
+
+struct WiFiReconnectConfig {
+    uint32_t connectTimeoutMs = 15000;  // give up on one attempt after this
+    uint32_t initialBackoffMs = 500;
+    uint32_t maxBackoffMs = 60000;
+};
+
+template <typename Driver>
+class WiFiReconnect {
+public:
+    enum class State : uint8_t { Idle, Connecting, Connected, Backoff };
+
+    WiFiReconnect(Driver& driver, const WiFiReconnectConfig& config, uint32_t seed = 1)
+        : _driver(driver), _config(config), _rng(seed ? seed : 1) {}
+
+    // Event hooks, safe to call from the Wi-Fi event task
+    void onConnected() { _pendingEvent.store(EventConnected); }
+    void onDisconnected() { _pendingEvent.store(EventDisconnected); }
+
+    void poll(uint32_t nowMs) {
+        uint8_t event = _pendingEvent.exchange(EventNone);
+        State state = _state.load();
+
+        switch (state) {
+            case State::Idle:
+                startAttempt(nowMs);
+                break;
+
+            case State::Connecting:
+                if (event == EventConnected) {
+                    _failures = 0;
+                    _state.store(State::Connected);
+                } else if (event == EventDisconnected || nowMs - _stateSinceMs >= _config.connectTimeoutMs) {
+                    _driver.disconnect();
+                    scheduleRetry(nowMs);
+                }
+                break;
+
+            case State::Connected:
+                if (event == EventDisconnected) {
+                    // Link was up: retry right away, back off only if that fails
+                    _drops++;
+                    startAttempt(nowMs);
+                }
+                break;
+
+            case State::Backoff:
+                if (event == EventConnected) {
+                    _failures = 0;
+                    _state.store(State::Connected);
+                } else if ((int32_t)(nowMs - _retryAtMs) >= 0) {
+                    startAttempt(nowMs);
+                }
+                break;
+        }
+    }
+
+    bool connected() const { return _state.load() == State::Connected; }
+    State state() const { return _state.load(); }
+    uint32_t failures() const { return _failures; }
+    uint32_t attempts() const { return _attempts; }
+    uint32_t drops() const { return _drops; }
+    uint32_t retryAtMs() const { return _retryAtMs; }
+
+    // Backoff before the next retry: exponential in the number of consecutive
+    // failures, capped, with the upper half randomised to spread out a fleet
+    uint32_t backoffMs() {
+        uint32_t base = _config.initialBackoffMs;
+        for (uint32_t i = 1; i < _failures && base < _config.maxBackoffMs; i++) {
+            base *= 2;
+        }
+        if (base > _config.maxBackoffMs) base = _config.maxBackoffMs;
+        uint32_t half = base / 2;
+        return half + (half ? nextRandom() % (half + 1) : 0);
+    }
+
+private:
+    enum : uint8_t { EventNone, EventConnected, EventDisconnected };
+
+    void startAttempt(uint32_t nowMs) {
+        _attempts++;
+        _stateSinceMs = nowMs;
+        _state.store(State::Connecting);
+        _driver.begin();
+    }
+
+    void scheduleRetry(uint32_t nowMs) {
+        _failures++;
+        _retryAtMs = nowMs + backoffMs();
+        _stateSinceMs = nowMs;
+        _state.store(State::Backoff);
+    }
+
+    // xorshift32
+    uint32_t nextRandom() {
+        _rng ^= _rng << 13;
+        _rng ^= _rng >> 17;
+        _rng ^= _rng << 5;
+        return _rng;
+    }
+
+    Driver& _driver;
+    WiFiReconnectConfig _config;
+    std::atomic<State> _state{State::Idle};
+    std::atomic<uint8_t> _pendingEvent{EventNone};
+    uint32_t _stateSinceMs = 0;
+    uint32_t _retryAtMs = 0;
+    uint32_t _failures = 0;
+    uint32_t _attempts = 0;
+    uint32_t _drops = 0;
+    uint32_t _rng;
+};
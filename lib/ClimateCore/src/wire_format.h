@@ -0,0 +1,138 @@
+// ============================================
+// WIRE FORMAT
+// Compact binary encoding for batched sensor uploads,
+// sent as Content-Type WIRE_CONTENT_TYPE. Little-endian:
+//
+//   header (20 bytes)
+//     u8[2]  magic 'C','C'
+//     u8     version (2)
+//     u8     reading count
+//     u32    device id
+//     u32    batch sequence number
+//     i64    base time, epoch ms (0: no reading is stamped)
+//   reading (5-14 bytes each)
+//     i16    temperature, 0.01 °C
+//     u16    humidity, 0.01 %RH
+//     varint time: 0 = not stamped, else 1 + zigzag(ms since
+//            the previous stamped reading, or the base)
+//
+// A 2 s sampling cadence costs 2 bytes of time per reading.
+// Version 1 (no base, 4-byte readings) is still decoded.
+// Decoded by api/_lib/wire.js. Plain C++ (no Arduino dependency).
+// ============================================
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define WIRE_CONTENT_TYPE "application/x-climate-readings"
+
+const uint8_t WIRE_VERSION = 2;
+const size_t WIRE_HEADER_SIZE = 20;
+const size_t WIRE_READING_SIZE = 4;         // without the time varint
+const size_t WIRE_MAX_TIME_SIZE = 10;       // varint of a 64-bit value
+const size_t WIRE_MAX_READINGS = 255;
+
+// Upper bound; most batches are much smaller
+constexpr size_t wireEncodedSize(size_t count) {
+    return WIRE_HEADER_SIZE + count * (WIRE_READING_SIZE + WIRE_MAX_TIME_SIZE);
+}
+
+class WireEncoder {
+public:
+    WireEncoder(uint8_t* buffer, size_t capacity, uint32_t deviceId, uint32_t sequence)
+        : _buf(buffer), _capacity(capacity) {
+        if (_capacity < WIRE_HEADER_SIZE) {
+            _overflow = true;
+            return;
+        }
+        _buf[0] = 'C';
+        _buf[1] = 'C';
+        _buf[2] = WIRE_VERSION;
+        _buf[3] = 0;
+        putU32(4, deviceId);
+        putU32(8, sequence);
+        putU64(12, 0);
+        _len = WIRE_HEADER_SIZE;
+    }
+
+    // epochMs 0 leaves the reading unstamped (the server uses its own time).
+    // Returns false (and leaves the buffer unchanged) when full
+    bool add(float temperature, float humidity, int64_t epochMs = 0) {
+        if (_overflow || _buf[3] == WIRE_MAX_READINGS) return false;
+
+        // The first stamped reading becomes the base
+        int64_t previous = _stamped ? _lastEpochMs : epochMs;
+        uint64_t time = epochMs != 0 ? 1 + zigzag(epochMs - previous) : 0;
+        if (_len + WIRE_READING_SIZE + varintSize(time) > _capacity) return false;
+
+        if (epochMs != 0) {
+            if (!_stamped) putU64(12, (uint64_t)epochMs);
+            _stamped = true;
+            _lastEpochMs = epochMs;
+        }
+        putU16(_len, (uint16_t)scale(temperature, -32768, 32767));
+        putU16(_len + 2, (uint16_t)scale(humidity, 0, 65535));
+        _len += WIRE_READING_SIZE;
+        _len += putVarint(_len, time);
+        _buf[3]++;
+        return true;
+    }
+
+    size_t length() const { return _overflow ? 0 : _len; }
+    size_t count() const { return _overflow ? 0 : _buf[3]; }
+
+private:
+    static int32_t scale(float value, int32_t lo, int32_t hi) {
+        float scaled = value * 100.0f;
+        int32_t v = (int32_t)(scaled < 0 ? scaled - 0.5f : scaled + 0.5f);
+        return v < lo ? lo : (v > hi ? hi : v);
+    }
+
+    // Small deltas of either sign -> small unsigned values
+    static uint64_t zigzag(int64_t v) {
+        return ((uint64_t)v << 1) ^ (uint64_t)(v >> 63);
+    }
+
+    static size_t varintSize(uint64_t v) {
+        size_t n = 1;
+        while (v >= 0x80) {
+            v >>= 7;
+            n++;
+        }
+        return n;
+    }
+
+    size_t putVarint(size_t at, uint64_t v) {
+        size_t n = 0;
+        while (v >= 0x80) {
+            _buf[at + n++] = (uint8_t)(v | 0x80);
+            v >>= 7;
+        }
+        _buf[at + n++] = (uint8_t)v;
+        return n;
+    }
+
+    void putU16(size_t at, uint16_t v) {
+        _buf[at] = (uint8_t)(v & 0xFF);
+        _buf[at + 1] = (uint8_t)(v >> 8);
+    }
+
+    void putU32(size_t at, uint32_t v) {
+        putU16(at, (uint16_t)(v & 0xFFFF));
+        putU16(at + 2, (uint16_t)(v >> 16));
+    }
+
+    void putU64(size_t at, uint64_t v) {
+        putU32(at, (uint32_t)v);
+        putU32(at + 4, (uint32_t)(v >> 32));
+    }
+
+    uint8_t* _buf;
+    size_t _capacity;
+    size_t _len = 0;
+    int64_t _lastEpochMs = 0;
+    bool _stamped = false;
+    bool _overflow = false;
+};
@@ -0,0 +1,58 @@
+#include "rmt_pixel_output.h"
+
+// 80 MHz APB / 2 = 25 ns per tick
+static const uint8_t RMT_CLOCK_DIV = 2;
+// WS2812 bit timings in ticks: 0 = 0.4 us high + 0.85 us low,
+// 1 = 0.8 us high + 0.45 us low
+static const rmt_item32_t WS2812_BIT0 = {{{ 16, 1, 34, 0 }}};
+static const rmt_item32_t WS2812_BIT1 = {{{ 32, 1, 18, 0 }}};
+
+RmtPixelOutput::RmtPixelOutput(gpio_num_t pin, rmt_channel_t channel)
+    : _pin(pin), _channel(channel) {}
+
+bool RmtPixelOutput::begin() {
+    rmt_config_t config = RMT_DEFAULT_CONFIG_TX(_pin, _channel);
+    config.clk_div = RMT_CLOCK_DIV;
+
+    if (rmt_config(&config) != ESP_OK) return false;
+    if (rmt_driver_install(_channel, 0, 0) != ESP_OK) return false;
+    if (rmt_translator_init(_channel, translate) != ESP_OK) return false;
+    _ready = true;
+    return true;
+}
+
+bool RmtPixelOutput::busy() const {
+    return _ready && rmt_wait_tx_done(_channel, 0) != ESP_OK;
+}
+
+bool RmtPixelOutput::show(const uint8_t* frame, size_t length, uint32_t waitMs) {
+    if (!_ready || rmt_wait_tx_done(_channel, pdMS_TO_TICKS(waitMs)) != ESP_OK) return false;
+    return rmt_write_sample(_channel, frame, length, false) == ESP_OK;
+}
+
+void RmtPixelOutput::wait() {
+    if (_ready) rmt_wait_tx_done(_channel, portMAX_DELAY);
+}
+
+// Called from the RMT ISR as its memory drains: one item per bit, MSB first
+void IRAM_ATTR RmtPixelOutput::translate(const void* src, rmt_item32_t* dest, size_t srcSize,
+                                         size_t wantedNum, size_t* translatedSize, size_t* itemNum) {
+    if (src == nullptr || dest == nullptr) {
+        *translatedSize = 0;
+        *itemNum = 0;
+        return;
+    }
+
+    const uint8_t* in = (const uint8_t*)src;
+    size_t size = 0;
+    size_t num = 0;
+    while (size < srcSize && num + 8 <= wantedNum) {
+        uint8_t value = in[size];
+        for (int bit = 7; bit >= 0; bit--) {
+            dest[num++] = (value & (1 << bit)) ? WS2812_BIT1 : WS2812_BIT0;
+        }
+        size++;
+    }
+    *translatedSize = size;
+    *itemNum = num;
+}
@@ -0,0 +1,39 @@
+// ============================================
+// RMT PIXEL OUTPUT
+// Drives a WS2812 strip from a GRB frame buffer through an RMT
+// transmit channel. show() only starts the transfer: the RMT
+// interrupt converts bytes to pulses as the hardware drains its
+// memory, so the core is free while hundreds of pixels go out.
+// The frame must stay untouched until the transfer finishes
+// (double-buffer, see busy()).
+// ============================================
+
+#pragma once
+
+#include <Arduino.h>
+#include <driver/rmt.h>
+
+class RmtPixelOutput {
+public:
+    RmtPixelOutput(gpio_num_t pin, rmt_channel_t channel);
+
+    bool begin();
+
+    // Starts sending length bytes of GRB. Waits up to waitMs for the
+    // previous frame to finish; false (nothing sent) if it is still on
+    // the wire then
+    bool show(const uint8_t* frame, size_t length, uint32_t waitMs = 0);
+
+    bool busy() const;
+
+    // Blocks until the current transfer is done (setup code only)
+    void wait();
+
+private:
+    static void IRAM_ATTR translate(const void* src, rmt_item32_t* dest, size_t srcSize,
+                                    size_t wantedNum, size_t* translatedSize, size_t* itemNum);
+
+    gpio_num_t _pin;
+    rmt_channel_t _channel;
+    bool _ready = false;
+};
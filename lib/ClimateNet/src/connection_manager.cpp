@@ -0,0 +1,126 @@
+#include "connection_manager.h"
+
+#include <WiFi.h>
+
+#include "rate_controller.h"
+
+ConnectionManager::ConnectionManager(unsigned long timeoutMs)
+    : _timeoutMs(timeoutMs), _chunked(_chunkedBuf, sizeof(_chunkedBuf)) {}
+
+void ConnectionManager::begin() {
+    static const char* headerKeys[] = { "ETag", "Retry-After" };
+    _http.collectHeaders(headerKeys, 2);
+    _client.setInsecure();
+    _http.setReuse(true);
+    _http.setTimeout(_timeoutMs);
+    _http.setConnectTimeout(_timeoutMs);
+}
+
+bool ConnectionManager::open(const char* url) {
+    // HTTPClient reuses the socket when it is still connected to the same host
+    _wasConnected = _client.connected();
+    _chunked.clear();
+    _chunkedLoaded = false;
+
+    // HTTPClient reuses a socket that is already connected, so connecting
+    // here first lets DNS and the handshake be timed separately
+    if (!_wasConnected && _telemetry && !connectTimed(url)) return false;
+    return _http.begin(_client, url);
+}
+
+bool ConnectionManager::connectTimed(const char* url) {
+    // https://host[:port]/path
+    const char* host = strstr(url, "://");
+    host = host ? host + 3 : url;
+    size_t hostLen = strcspn(host, ":/");
+    char hostname[64];
+    if (hostLen == 0 || hostLen >= sizeof(hostname)) return false;
+    memcpy(hostname, host, hostLen);
+    hostname[hostLen] = '\0';
+    uint16_t port = host[hostLen] == ':' ? (uint16_t)atoi(host + hostLen + 1) : 443;
+
+    uint32_t start = Telemetry::nowUs();
+    IPAddress ip;
+    if (!WiFi.hostByName(hostname, ip)) return false;
+    _telemetry->record(Stage::Dns, start);
+
+    // Passing the hostname keeps SNI, which the API host requires
+    start = Telemetry::nowUs();
+    if (!_client.connect(ip, port, hostname, nullptr, nullptr, nullptr)) return false;
+    _telemetry->record(Stage::TlsConnect, start);
+    return true;
+}
+
+void ConnectionManager::count(int httpCode) {
+    _retryAfterMs = 0;
+    if (httpCode <= 0) return;
+    char retryAfter[16];
+    if (_http.copyHeader("Retry-After", retryAfter, sizeof(retryAfter))) {
+        _retryAfterMs = parseRetryAfterMs(retryAfter);
+    }
+    if (_wasConnected) {
+        _reused++;
+    } else {
+        _handshakes++;
+    }
+}
+
+int ConnectionManager::post(const char* url, const char* contentType, const uint8_t* body, size_t length) {
+    if (!open(url)) return HTTPC_ERROR_CONNECTION_REFUSED;
+    _http.addHeader("Content-Type", contentType);
+
+    uint32_t start = Telemetry::nowUs();
+    int httpCode = _http.POST(const_cast<uint8_t*>(body), length);
+    if (_telemetry && httpCode > 0) _telemetry->record(Stage::Request, start);
+    count(httpCode);
+    return httpCode;
+}
+
+int ConnectionManager::get(const char* url, const char* ifNoneMatch) {
+    if (!open(url)) return HTTPC_ERROR_CONNECTION_REFUSED;
+    if (ifNoneMatch && ifNoneMatch[0]) _http.addHeader("If-None-Match", ifNoneMatch);
+
+    uint32_t start = Telemetry::nowUs();
+    int httpCode = _http.GET();
+    if (_telemetry && httpCode > 0) _telemetry->record(Stage::Request, start);
+    count(httpCode);
+    return httpCode;
+}
+
+Stream& ConnectionManager::body() {
+    // Identity bodies are read straight off the socket; chunked ones
+    // (no Content-Length) need HTTPClient to strip the framing first
+    if (_http.getSize() >= 0) return _http.getStream();
+    if (!_chunkedLoaded) {
+        _http.writeToStream(&_chunked);
+        _chunkedLoaded = true;
+    }
+    return _chunked;
+}
+
+size_t ConnectionManager::readBody(char* out, size_t size) {
+    if (size == 0) return 0;
+    Stream& stream = body();
+
+    // Never ask for more than the body holds, readBytes() would wait it out
+    int remaining = (&stream == &_chunked) ? _chunked.available() : _http.getSize();
+    size_t want = size - 1;
+    if (remaining >= 0 && (size_t)remaining < want) want = remaining;
+
+    size_t n = stream.readBytes(out, want);
+    out[n] = '\0';
+    return n;
+}
+
+bool ConnectionManager::etag(char* out, size_t size) {
+    return _http.copyHeader("ETag", out, size);
+}
+
+void ConnectionManager::end() {
+    // end() drains what is left of the body and keeps the socket when allowed
+    _http.end();
+}
+
+void ConnectionManager::reset() {
+    _client.stop();
+}
@@ -0,0 +1,120 @@
+// ============================================
+// CONNECTION MANAGER
+// Keeps one HTTP/1.1 keep-alive TLS connection to the API
+// host open and runs every request on a channel over it.
+// Request and response bodies go through caller-owned or
+// preallocated buffers; nothing is heap-allocated per request.
+// ============================================
+
+#pragma once
+
+#include <Arduino.h>
+#include <WiFiClientSecure.h>
+#include <HTTPClient.h>
+
+#include "telemetry.h"
+
+// Stream over a fixed char buffer (writes truncate, reads drain)
+class BufferStream : public Stream {
+public:
+    BufferStream(char* buffer, size_t size) : _buf(buffer), _size(size) { clear(); }
+
+    void clear() { _len = 0; _pos = 0; _buf[0] = '\0'; }
+    const char* c_str() const { return _buf; }
+
+    size_t write(uint8_t c) override { return write(&c, 1); }
+    size_t write(const uint8_t* data, size_t length) override {
+        size_t room = _size - 1 - _len;
+        if (length > room) length = room;
+        memcpy(_buf + _len, data, length);
+        _len += length;
+        _buf[_len] = '\0';
+        return length;
+    }
+    int available() override { return (int)(_len - _pos); }
+    int read() override { return _pos < _len ? (uint8_t)_buf[_pos++] : -1; }
+    int peek() override { return _pos < _len ? (uint8_t)_buf[_pos] : -1; }
+    void flush() override {}
+
+private:
+    char* _buf;
+    size_t _size;
+    size_t _len;
+    size_t _pos;
+};
+
+// HTTPClient::header() returns a new String per call; this copies a
+// collected header straight out of the client's own storage instead
+class HeaderHttpClient : public HTTPClient {
+public:
+    // Copies the header's value (empty when absent); false if it didn't fit
+    bool copyHeader(const char* name, char* out, size_t size) {
+        if (size == 0) return false;
+        out[0] = '\0';
+        for (size_t i = 0; i < _headerKeysCount; i++) {
+            if (strcasecmp(_currentHeaders[i].key.c_str(), name) != 0) continue;
+            size_t length = _currentHeaders[i].value.length();
+            if (length >= size) return false;
+            memcpy(out, _currentHeaders[i].value.c_str(), length + 1);
+            return true;
+        }
+        return true;
+    }
+};
+
+class ConnectionManager {
+public:
+    explicit ConnectionManager(unsigned long timeoutMs);
+
+    void begin();
+
+    // Times DNS, TLS connect and request stages from now on. Only for
+    // connections with short requests; a long-poll would skew Request.
+    void setTelemetry(Telemetry* telemetry) { _telemetry = telemetry; }
+
+    // Both return the HTTP status code (or a negative HTTPClient error).
+    // The response stays open until end() is called.
+    int post(const char* url, const char* contentType, const uint8_t* body, size_t length);
+    // ifNoneMatch (an ETag from an earlier response) makes the GET
+    // conditional; the server then answers 304 with no body
+    int get(const char* url, const char* ifNoneMatch = nullptr);
+
+    // Response body of the current request, valid until end()
+    Stream& body();
+    // Copies the body into out (truncated, NUL-terminated) for logging
+    size_t readBody(char* out, size_t size);
+    // Copies the response's ETag (empty when absent); false if it didn't fit
+    bool etag(char* out, size_t size);
+    // Retry-After of the last response in ms, 0 when it had none
+    uint32_t retryAfterMs() const { return _retryAfterMs; }
+    // Finishes the request; the socket stays open when keep-alive allows
+    void end();
+
+    // Drops the connection, e.g. after Wi-Fi was lost
+    void reset();
+
+    // Requests that needed a fresh TLS handshake vs. ran on the open connection
+    uint32_t handshakes() const { return _handshakes; }
+    uint32_t reusedRequests() const { return _reused; }
+
+private:
+    static const size_t CHUNKED_BUFFER_SIZE = 256;
+
+    bool open(const char* url);
+    bool connectTimed(const char* url);
+    void count(int httpCode);
+
+    WiFiClientSecure _client;
+    HeaderHttpClient _http;
+    unsigned long _timeoutMs;
+    bool _wasConnected = false;
+    uint32_t _handshakes = 0;
+    uint32_t _reused = 0;
+    uint32_t _retryAfterMs = 0;
+    Telemetry* _telemetry = nullptr;
+
+    // Chunked responses are de-chunked into this buffer
+    char _chunkedBuf[CHUNKED_BUFFER_SIZE];
+    BufferStream _chunked;
+    bool _chunkedLoaded = false;
+};
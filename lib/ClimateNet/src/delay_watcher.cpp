@@ -0,0 +1,48 @@
+#include "delay_watcher.h"
+
+#include "json_codec.h"
+#include "sensor_logic.h"
+
+DelayWatcher::DelayWatcher(ConnectionManager& connection, const char* url,
+                           int minDelay, int maxDelay, unsigned long waitMs)
+    : _connection(connection), _url(url), _minDelay(minDelay), _maxDelay(maxDelay), _waitMs(waitMs) {}
+
+bool DelayWatcher::poll(int& delay) {
+    char url[160];
+    if (_waitMs > 0) {
+        snprintf(url, sizeof(url), "%s?since=%d&wait=%lu", _url, delay, _waitMs);
+    } else {
+        snprintf(url, sizeof(url), "%s?since=%d", _url, delay);
+    }
+
+    int httpCode = _connection.get(url, _etag);
+    bool ok = false;
+
+    if (httpCode == HTTP_CODE_NOT_MODIFIED) {
+        // Nothing changed: no body to read or parse
+        ok = true;
+    } else if (httpCode == HTTP_CODE_OK) {
+        // Parse straight off the socket
+        int newDelay = 0;
+        uint32_t start = Telemetry::nowUs();
+        DeserializationError error = parseDelayJson(_connection.body(), newDelay);
+        if (_telemetry) _telemetry->record(Stage::JsonParse, start);
+
+        if (!error) {
+            delay = clampDelay(newDelay, _minDelay, _maxDelay);
+            Serial.printf("[Delay] Received: %dms\n", delay);
+
+            if (!_connection.etag(_etag, sizeof(_etag))) {
+                Serial.println("[Delay] ETag too long, polling unconditionally");
+            }
+            ok = true;
+        } else {
+            Serial.printf("[Delay] JSON parse failed: %s\n", error.c_str());
+        }
+    } else {
+        Serial.printf("[Delay] HTTP Error: %d\n", httpCode);
+    }
+
+    _connection.end();
+    return ok;
+}
@@ -0,0 +1,37 @@
+// ============================================
+// DELAY WATCHER
+// Client for GET /api/delay. Sends the last ETag as
+// If-None-Match so an unchanged delay comes back as a bodyless
+// 304; with waitMs > 0 the server long-polls until it changes.
+// Received values are clamped to the device's delay range.
+// ============================================
+
+#pragma once
+
+#include <Arduino.h>
+
+#include "connection_manager.h"
+
+class DelayWatcher {
+public:
+    // waitMs = 0 makes every poll() return immediately
+    DelayWatcher(ConnectionManager& connection, const char* url,
+                 int minDelay, int maxDelay, unsigned long waitMs);
+
+    // One request. On success returns true and sets delay to the
+    // server's value (unchanged on 304); false on HTTP/parse errors.
+    bool poll(int& delay);
+
+    // Times response body parsing
+    void setTelemetry(Telemetry* telemetry) { _telemetry = telemetry; }
+
+private:
+    ConnectionManager& _connection;
+    const char* _url;
+    int _minDelay;
+    int _maxDelay;
+    unsigned long _waitMs;
+    Telemetry* _telemetry = nullptr;
+    // ETag of the last delay received
+    char _etag[24] = "";
+};
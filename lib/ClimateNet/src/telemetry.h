@@ -0,0 +1,61 @@
+// ============================================
+// TELEMETRY
+// Thread-safe stage timing for the ESP32: probes read the
+// microsecond timer at the start of a stage and record the
+// elapsed time into StageStats on exit. Recording takes a
+// spinlock for a handful of instructions, so probes may run on
+// any task or core.
+// ============================================
+
+#pragma once
+
+#include <Arduino.h>
+#include <esp_timer.h>
+
+#include "stage_stats.h"
+
+class Telemetry {
+public:
+    typedef StageStats<> Stats;
+
+    static uint32_t nowUs() { return (uint32_t)esp_timer_get_time(); }
+
+    void record(Stage stage, uint32_t startUs) {
+        uint32_t elapsed = nowUs() - startUs;
+        portENTER_CRITICAL(&_mux);
+        _stats.record(stage, elapsed);
+        portEXIT_CRITICAL(&_mux);
+    }
+
+    // Copies the current window into out and starts a new one
+    void takeSnapshot(Stats& out) {
+        portENTER_CRITICAL(&_mux);
+        out = _stats;
+        _stats.reset();
+        portEXIT_CRITICAL(&_mux);
+    }
+
+    // Measures the cost of one probe (timer read + record) by running
+    // CALIBRATION_PROBES of them; call once at boot, before real probes
+    uint32_t calibrate() {
+        uint32_t start = nowUs();
+        for (uint32_t i = 0; i < CALIBRATION_PROBES; i++) record(Stage::PixelShow, nowUs());
+        uint32_t elapsed = nowUs() - start;
+
+        portENTER_CRITICAL(&_mux);
+        _stats.reset();
+        portEXIT_CRITICAL(&_mux);
+
+        _probeOverheadNs = (uint32_t)((uint64_t)elapsed * 1000 / CALIBRATION_PROBES);
+        return _probeOverheadNs;
+    }
+
+    uint32_t probeOverheadNs() const { return _probeOverheadNs; }
+
+private:
+    static const uint32_t CALIBRATION_PROBES = 1000;
+
+    Stats _stats;
+    portMUX_TYPE _mux = portMUX_INITIALIZER_UNLOCKED;
+    uint32_t _probeOverheadNs = 0;
+};
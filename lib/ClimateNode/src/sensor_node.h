@@ -0,0 +1,281 @@
+// ============================================
+// SENSOR NODE
+// Complete firmware for the upload-only boards (espfirm,
+// firmware, temphumid): DHT22 over RMT, median + EMA filter,
+// swinging-door compression, batched JSON uploads on one
+// keep-alive connection that back off on 429/5xx, and Wi-Fi
+// reconnect with backoff, all driven by the deadline scheduler.
+//
+// Everything that differs between boards comes from Profile,
+// which derives from SensorNodeDefaults and overrides fields:
+//   wifiSsid(), wifiPassword(), apiUrl()   (required)
+//   Keys, DHT_PIN, SAMPLE_INTERVAL_MS, *_ERROR_BOUND, BATCH_*...
+// ============================================
+
+#pragma once
+
+#include <Arduino.h>
+#include <WiFi.h>
+
+#include "connection_manager.h"
+#include "dht22_reader.h"
+#include "json_codec.h"
+#include "rate_controller.h"
+#include "reading_buffer.h"
+#include "sample_filter.h"
+#include "scheduler.h"
+#include "swinging_door.h"
+#include "wifi_reconnect.h"
+
+struct SensorNodeDefaults {
+    typedef ReadingKeys Keys;
+
+    static constexpr int DHT_PIN = 38;
+    static constexpr rmt_channel_t DHT_RMT_CHANNEL = RMT_CHANNEL_4;
+    static constexpr uint32_t SAMPLE_INTERVAL_MS = 2000;   // DHT22 minimum
+    static constexpr size_t FILTER_WINDOW = 5;
+    static constexpr float FILTER_ALPHA = 0.5f;
+
+    // A reading is uploaded when interpolating between uploaded ones
+    // would miss it by more than this, or after MAX_SILENCE_MS
+    static constexpr float TEMPERATURE_ERROR_BOUND = 0.1f;   // °C
+    static constexpr float HUMIDITY_ERROR_BOUND = 0.1f;      // %RH
+    static constexpr uint32_t MAX_SILENCE_MS = 300000;
+
+    // BATCH_SIZE 1 uploads every kept reading right away
+    static constexpr size_t BATCH_SIZE = 1;
+    static constexpr size_t BATCH_CAPACITY = 30;
+    static constexpr uint32_t BATCH_MAX_AGE_MS = 20000;
+    static constexpr size_t UPLOAD_BUFFER_SIZE = 256;
+
+    static constexpr unsigned long HTTP_TIMEOUT_MS = 5000;
+};
+
+template <typename Profile>
+class SensorNode {
+    static_assert(Profile::UPLOAD_BUFFER_SIZE >= jsonBatchMaxSize<typename Profile::Keys>(Profile::BATCH_SIZE),
+                  "a full batch does not fit UPLOAD_BUFFER_SIZE");
+
+public:
+    SensorNode()
+        : _dht((gpio_num_t)Profile::DHT_PIN, Profile::DHT_RMT_CHANNEL),
+          _temperatureFilter(Profile::FILTER_ALPHA),
+          _humidityFilter(Profile::FILTER_ALPHA),
+          _compressor(errorBounds(), Profile::MAX_SILENCE_MS),
+          _buffer(Profile::BATCH_SIZE, Profile::BATCH_MAX_AGE_MS),
+          _connection(Profile::HTTP_TIMEOUT_MS),
+          _throttle(UploadThrottleConfig(), (uint32_t)esp_random()),
+          _wifiLink(_wifiDriver, WiFiReconnectConfig(), (uint32_t)esp_random()) {}
+
+    // Call once from setup()
+    void begin() {
+        _self = this;
+        _loopTask = xTaskGetCurrentTaskHandle();
+
+        if (!_dht.begin()) {
+            Serial.println("[Sensor] ❌ RMT setup failed");
+        }
+        _connection.begin();
+
+        Serial.printf("[WiFi] Connecting to: %s\n", Profile::wifiSsid());
+        WiFi.mode(WIFI_STA);
+        WiFi.setAutoReconnect(false);   // _wifiLink owns reconnects
+        WiFi.setSleep(WIFI_PS_MIN_MODEM);
+        WiFi.onEvent(onWiFiEvent);
+        _wifiLink.poll(millis());
+
+        uint32_t now = millis();
+        _wifiJob = _scheduler.once(wifiStep);
+        _scheduler.at(_wifiJob, now + WIFI_POLL_INTERVAL_MS);
+        _dhtPollJob = _scheduler.once(dhtPollStep);
+        _flushJob = _scheduler.once(flushStep);
+        _scheduler.every(Profile::SAMPLE_INTERVAL_MS, sensorStep, now + Profile::SAMPLE_INTERVAL_MS);
+    }
+
+    // Call from loop(): runs what is due, then blocks until the next deadline
+    void run() {
+        _scheduler.runDue(millis());
+
+        uint32_t idleMs = _scheduler.idleTime(millis(), MAX_IDLE_MS);
+        if (idleMs > 0 && ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(idleMs)) > 0) {
+            _scheduler.at(_wifiJob, millis());
+        }
+    }
+
+private:
+    typedef SwingingDoor<2> Compressor;
+
+    static const uint32_t WIFI_POLL_INTERVAL_MS = 1000;
+    static const uint32_t DHT_POLL_STEP_MS = 5;
+    static const uint32_t MAX_IDLE_MS = 1000;
+    static const size_t ERROR_BODY_SIZE = 96;
+
+    struct WiFiDriver {
+        void begin() {
+            _self->_connection.reset();
+            WiFi.begin(Profile::wifiSsid(), Profile::wifiPassword());
+        }
+        void disconnect() { WiFi.disconnect(); }
+    };
+
+    static const float (&errorBounds())[2] {
+        static const float bounds[2] = { Profile::TEMPERATURE_ERROR_BOUND, Profile::HUMIDITY_ERROR_BOUND };
+        return bounds;
+    }
+
+    static void onWiFiEvent(WiFiEvent_t event) {
+        switch (event) {
+            case ARDUINO_EVENT_WIFI_STA_GOT_IP:
+                _self->_wifiLink.onConnected();
+                break;
+            case ARDUINO_EVENT_WIFI_STA_DISCONNECTED:
+            case ARDUINO_EVENT_WIFI_STA_LOST_IP:
+                _self->_wifiLink.onDisconnected();
+                break;
+            default:
+                return;
+        }
+        // Run wifiStep now instead of at its next deadline
+        xTaskNotifyGive(_self->_loopTask);
+    }
+
+    static void wifiStep(uint32_t nowMs) {
+        typedef typename WiFiReconnect<WiFiDriver>::State State;
+        SensorNode& node = *_self;
+        node._wifiLink.poll(nowMs);
+
+        State state = node._wifiLink.state();
+        if (state != node._lastWifiState) {
+            node._lastWifiState = state;
+            if (state == State::Connected) {
+                Serial.print("[WiFi] ✅ Connected! IP: ");
+                Serial.println(WiFi.localIP());
+            } else if (state == State::Backoff) {
+                Serial.printf("[WiFi] ❌ Attempt failed (%u in a row)\n", (unsigned)node._wifiLink.failures());
+            }
+        }
+
+        // Connected: nothing to time, the next event wakes us
+        if (state == State::Backoff) {
+            node._scheduler.at(node._wifiJob, node._wifiLink.retryAtMs());
+        } else if (state != State::Connected) {
+            node._scheduler.at(node._wifiJob, nowMs + WIFI_POLL_INTERVAL_MS);
+        }
+    }
+
+    static void sensorStep(uint32_t nowMs) {
+        // The capture runs in the background and is collected by dhtPollStep
+        if (_self->_dht.start(nowMs)) {
+            _self->_scheduler.at(_self->_dhtPollJob, nowMs + DHT_POLL_STEP_MS);
+        }
+    }
+
+    static void dhtPollStep(uint32_t nowMs) {
+        SensorNode& node = *_self;
+        DhtFrame frame;
+        if (!node._dht.poll(nowMs, frame)) {
+            node._scheduler.at(node._dhtPollJob, nowMs + DHT_POLL_STEP_MS);
+            return;
+        }
+        node.addFrame(frame);
+        if (node._buffer.shouldFlush(nowMs)) {
+            node.flush();
+        }
+    }
+
+    // A batch held back by the throttle goes out when the wait ends,
+    // not at whichever frame comes after it
+    static void flushStep(uint32_t nowMs) {
+        (void)nowMs;
+        if (!_self->_buffer.empty()) _self->flush();
+    }
+
+    void addFrame(const DhtFrame& frame) {
+        if (frame.status != DhtStatus::Ok) {
+            Serial.printf("[Sensor] DHT22 frame dropped (%s)\n",
+                          frame.status == DhtStatus::Checksum ? "checksum" : "timeout");
+            return;
+        }
+
+        float temperature = _temperatureFilter.add(frame.temperature);
+        float humidity = _humidityFilter.add(frame.humidity);
+        Serial.printf("[Sensor] T=%.2f°C, H=%.2f%%\n", temperature, humidity);
+
+        typename Compressor::Sample sample = { (uint32_t)millis(), { temperature, humidity } };
+        typename Compressor::Sample kept;
+        if (!_compressor.offer(sample, kept)) return;
+
+        Reading reading = { kept.values[0], kept.values[1], kept.timeMs };
+        if (!_buffer.push(reading)) {
+            Serial.println("[Sensor] ⚠️ Buffer full, oldest reading dropped");
+        }
+    }
+
+    // Uploads the oldest batch; readings stay queued while offline
+    // and while the server's Retry-After or our backoff is running
+    void flush() {
+        if (!_wifiLink.connected()) return;
+        if (!_throttle.allowed(millis())) {
+            _scheduler.at(_flushJob, _throttle.resumeAtMs());
+            return;
+        }
+
+        size_t count = _buffer.size() < Profile::BATCH_SIZE ? _buffer.size() : Profile::BATCH_SIZE;
+        for (size_t i = 0; i < count; i++) _batch[i] = _buffer.at(i);
+
+        size_t length = encodeJsonBatch<Profile::BATCH_SIZE, typename Profile::Keys>(
+            _batch, count, _uploadBuffer, sizeof(_uploadBuffer));
+        if (length == 0) {
+            Serial.println("[Sensor] ❌ Batch does not fit the upload buffer");
+            _buffer.drop(count);
+            return;
+        }
+
+        int httpCode = _connection.post(Profile::apiUrl(), "application/json", (const uint8_t*)_uploadBuffer, length);
+        UploadOutcome outcome = uploadOutcome(httpCode);
+        uint32_t now = millis();
+        _throttle.onResult(now, httpCode, _connection.retryAfterMs());
+        if (outcome == UploadOutcome::Delivered) {
+            _buffer.drop(count);
+            Serial.printf("[Sensor] ✅ Uploaded %u (handshakes %u, reused %u)\n", (unsigned)count,
+                          (unsigned)_connection.handshakes(), (unsigned)_connection.reusedRequests());
+        } else {
+            if (httpCode > 0) _connection.readBody(_errorBody, sizeof(_errorBody));
+            Serial.printf("[Sensor] ❌ HTTP %d: %s\n", httpCode, httpCode > 0 ? _errorBody : "");
+            // Refused for good: retrying would block every reading behind it
+            if (outcome == UploadOutcome::Rejected) _buffer.drop(count);
+            if (!_throttle.allowed(now)) {
+                Serial.printf("[Sensor] ⏸ Uploads paused for %lu ms (%u failures in a row)\n",
+                              (unsigned long)(_throttle.resumeAtMs() - now), (unsigned)_throttle.failures());
+                _scheduler.at(_flushJob, _throttle.resumeAtMs());
+            }
+        }
+        _connection.end();
+    }
+
+    static SensorNode* _self;
+
+    Dht22Reader _dht;
+    SampleFilter<Profile::FILTER_WINDOW> _temperatureFilter;
+    SampleFilter<Profile::FILTER_WINDOW> _humidityFilter;
+    Compressor _compressor;
+    ReadingBuffer<Profile::BATCH_CAPACITY> _buffer;
+    Reading _batch[Profile::BATCH_SIZE];
+    char _uploadBuffer[Profile::UPLOAD_BUFFER_SIZE];
+    char _errorBody[ERROR_BODY_SIZE];
+    ConnectionManager _connection;
+    UploadThrottle _throttle;
+
+    WiFiDriver _wifiDriver;
+    WiFiReconnect<WiFiDriver> _wifiLink;
+    typename WiFiReconnect<WiFiDriver>::State _lastWifiState = WiFiReconnect<WiFiDriver>::State::Idle;
+
+    Scheduler<4> _scheduler;
+    int _wifiJob = Scheduler<4>::NO_JOB;
+    int _dhtPollJob = Scheduler<4>::NO_JOB;
+    int _flushJob = Scheduler<4>::NO_JOB;
+    TaskHandle_t _loopTask = nullptr;
+};
+
+template <typename Profile>
+SensorNode<Profile>* SensorNode<Profile>::_self = nullptr;
@@ -0,0 +1,77 @@
+#include "dht22_reader.h"
+
+Dht22Reader::Dht22Reader(gpio_num_t pin, rmt_channel_t channel)
+    : _pin(pin), _channel(channel) {}
+
+bool Dht22Reader::begin() {
+    rmt_config_t config = RMT_DEFAULT_CONFIG_RX(_pin, _channel);
+    config.clk_div = 80;                            // 1 tick = 1 us
+    config.rx_config.filter_en = true;
+    config.rx_config.filter_ticks_thresh = 100;     // ignore < 1.25 us glitches
+    config.rx_config.idle_threshold = 200;          // frame ends after 200 us idle
+
+    if (rmt_config(&config) != ESP_OK) return false;
+    if (rmt_driver_install(_channel, 512, 0) != ESP_OK) return false;
+    if (rmt_get_ringbuf_handle(_channel, &_ring) != ESP_OK) return false;
+
+    // Open-drain keeps the RMT input path connected while we drive the start pulse
+    gpio_set_direction(_pin, GPIO_MODE_INPUT_OUTPUT_OD);
+    gpio_set_pull_mode(_pin, GPIO_PULLUP_ONLY);
+    gpio_set_level(_pin, 1);
+    return true;
+}
+
+bool Dht22Reader::start(uint32_t nowMs) {
+    if (_state != State::Idle || !_ring) return false;
+    gpio_set_level(_pin, 0);
+    _state = State::StartPulse;
+    _stateSinceMs = nowMs;
+    return true;
+}
+
+bool Dht22Reader::poll(uint32_t nowMs, DhtFrame& frame) {
+    switch (_state) {
+        case State::Idle:
+            return false;
+
+        case State::StartPulse:
+            if (nowMs - _stateSinceMs < START_PULSE_MS) return false;
+            rmt_rx_start(_channel, true);
+            gpio_set_level(_pin, 1);        // release; the sensor answers within 40 us
+            _state = State::Capturing;
+            _stateSinceMs = nowMs;
+            return false;
+
+        case State::Capturing: {
+            size_t length = 0;
+            rmt_item32_t* items = (rmt_item32_t*)xRingbufferReceive(_ring, &length, 0);
+            if (!items) {
+                if (nowMs - _stateSinceMs < CAPTURE_TIMEOUT_MS) return false;
+                DhtFrame timeout = { DhtStatus::TooShort, 0, 0 };
+                return finish(frame, timeout);
+            }
+
+            size_t count = 0;
+            size_t itemCount = length / sizeof(rmt_item32_t);
+            for (size_t i = 0; i < itemCount && count + 2 <= MAX_LEVELS; i++) {
+                _levels[count++] = { (uint8_t)items[i].level0, (uint16_t)items[i].duration0 };
+                _levels[count++] = { (uint8_t)items[i].level1, (uint16_t)items[i].duration1 };
+            }
+            vRingbufferReturnItem(_ring, items);
+            return finish(frame, decodeDht22(_levels, count));
+        }
+    }
+    return false;
+}
+
+bool Dht22Reader::finish(DhtFrame& frame, const DhtFrame& result) {
+    rmt_rx_stop(_channel);
+    _state = State::Idle;
+    frame = result;
+    if (result.status == DhtStatus::Ok) {
+        _frames++;
+    } else {
+        _errors++;
+    }
+    return true;
+}
@@ -0,0 +1,49 @@
+// ============================================
+// DHT22 READER
+// Non-blocking DHT22 acquisition: the start pulse is timed
+// from poll() and the frame is captured by an RMT receive
+// channel, so no interrupts are disabled and the CPU never
+// bit-bangs. Frames are decoded by dht22_decoder.h.
+// ============================================
+
+#pragma once
+
+#include <Arduino.h>
+#include <driver/rmt.h>
+
+#include "dht22_decoder.h"
+
+class Dht22Reader {
+public:
+    Dht22Reader(gpio_num_t pin, rmt_channel_t channel);
+
+    bool begin();
+
+    // Starts a conversion; returns false while one is still running
+    bool start(uint32_t nowMs);
+
+    // Advances the conversion; returns true once it has finished and
+    // fills frame (check frame.status for checksum/timeout failures)
+    bool poll(uint32_t nowMs, DhtFrame& frame);
+
+    uint32_t frames() const { return _frames; }
+    uint32_t errors() const { return _errors; }
+
+private:
+    enum class State : uint8_t { Idle, StartPulse, Capturing };
+
+    static const uint32_t START_PULSE_MS = 2;    // datasheet: at least 1 ms low
+    static const uint32_t CAPTURE_TIMEOUT_MS = 20;
+    static const size_t MAX_LEVELS = 96;
+
+    bool finish(DhtFrame& frame, const DhtFrame& result);
+
+    gpio_num_t _pin;
+    rmt_channel_t _channel;
+    RingbufHandle_t _ring = nullptr;
+    State _state = State::Idle;
+    uint32_t _stateSinceMs = 0;
+    DhtLevel _levels[MAX_LEVELS];
+    uint32_t _frames = 0;
+    uint32_t _errors = 0;
+};
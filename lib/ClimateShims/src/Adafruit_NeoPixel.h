@@ -0,0 +1,61 @@
+// ============================================
+// ADAFRUIT_NEOPIXEL SHIM (native env only)
+// Keeps the pixel buffer in memory (GRB order, brightness
+// applied on set like the real library) and counts show()
+// calls, so tests can compare frames.
+// ============================================
+
+#pragma once
+
+#include <Arduino.h>
+
+#define NEO_GRB 0x52
+#define NEO_RGB 0x06
+#define NEO_KHZ800 0x0000
+
+class Adafruit_NeoPixel {
+public:
+    Adafruit_NeoPixel(uint16_t count, int16_t pin, uint16_t type = NEO_GRB + NEO_KHZ800)
+        : _count(count), _pin(pin), _type(type) {
+        _pixels = (uint8_t*)calloc(count * 3, 1);
+    }
+    ~Adafruit_NeoPixel() { free(_pixels); }
+
+    Adafruit_NeoPixel(const Adafruit_NeoPixel&) = delete;
+    Adafruit_NeoPixel& operator=(const Adafruit_NeoPixel&) = delete;
+
+    void begin() {}
+    void show() { _shows++; }
+    void clear() { memset(_pixels, 0, _count * 3); }
+    void setBrightness(uint8_t brightness) { _brightness = brightness + 1; }
+
+    void setPixelColor(uint16_t n, uint8_t r, uint8_t g, uint8_t b) {
+        if (n >= _count) return;
+        uint8_t* p = _pixels + n * 3;
+        p[0] = scale(g);
+        p[1] = scale(r);
+        p[2] = scale(b);
+    }
+    void setPixelColor(uint16_t n, uint32_t color) {
+        setPixelColor(n, (uint8_t)(color >> 16), (uint8_t)(color >> 8), (uint8_t)color);
+    }
+
+    static uint32_t Color(uint8_t r, uint8_t g, uint8_t b) {
+        return ((uint32_t)r << 16) | ((uint32_t)g << 8) | b;
+    }
+
+    uint16_t numPixels() const { return _count; }
+    uint8_t* getPixels() const { return _pixels; }
+    uint32_t shows() const { return _shows; }
+
+private:
+    // Same scaling as the library: brightness is stored +1, 0 = full
+    uint8_t scale(uint8_t c) const { return _brightness ? (uint8_t)((c * _brightness) >> 8) : c; }
+
+    uint16_t _count;
+    int16_t _pin;
+    uint16_t _type;
+    uint8_t* _pixels;
+    uint8_t _brightness = 0;
+    uint32_t _shows = 0;
+};
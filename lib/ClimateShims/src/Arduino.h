@@ -0,0 +1,73 @@
+// ============================================
+// ARDUINO SHIM (native env only)
+// Just enough of the Arduino core for firmware logic to build
+// on the host: millis()/micros()/delay() run on a fake clock
+// that tests move by hand, Serial prints to stdout.
+// ============================================
+
+#pragma once
+
+#include <math.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Time only moves when a test (or delay()) moves it
+class FakeClock {
+public:
+    static void reset(uint64_t us = 0) { _nowUs = us; }
+    static void setMs(uint32_t ms) { _nowUs = (uint64_t)ms * 1000; }
+    static void advanceMs(uint32_t ms) { _nowUs += (uint64_t)ms * 1000; }
+    static void advanceUs(uint32_t us) { _nowUs += us; }
+    static uint64_t nowUs() { return _nowUs; }
+
+private:
+    static inline uint64_t _nowUs = 0;
+};
+
+inline uint32_t millis() { return (uint32_t)(FakeClock::nowUs() / 1000); }
+inline uint32_t micros() { return (uint32_t)FakeClock::nowUs(); }
+inline void delay(uint32_t ms) { FakeClock::advanceMs(ms); }
+inline void delayMicroseconds(uint32_t us) { FakeClock::advanceUs(us); }
+inline void yield() {}
+
+#define HIGH 1
+#define LOW 0
+#define INPUT 0
+#define OUTPUT 1
+#define INPUT_PULLUP 2
+
+inline void pinMode(uint8_t, uint8_t) {}
+inline void digitalWrite(uint8_t, uint8_t) {}
+inline int digitalRead(uint8_t) { return LOW; }
+
+// Serial on stdout; quiet() silences it for benchmarks
+class HostSerial {
+public:
+    void begin(unsigned long) {}
+    void quiet(bool on) { _quiet = on; }
+
+    size_t print(const char* s) { return _quiet ? 0 : (size_t)fputs(s, stdout); }
+    size_t print(long v) { return printf("%ld", v); }
+    size_t print(double v, int digits = 2) { return printf("%.*f", digits, v); }
+    size_t println(const char* s = "") { return print(s) + print("\n"); }
+    size_t println(long v) { return print(v) + print("\n"); }
+    size_t println(double v, int digits = 2) { return print(v, digits) + print("\n"); }
+
+    size_t printf(const char* format, ...) __attribute__((format(printf, 2, 3))) {
+        if (_quiet) return 0;
+        va_list args;
+        va_start(args, format);
+        int n = vprintf(format, args);
+        va_end(args);
+        return n < 0 ? 0 : (size_t)n;
+    }
+
+private:
+    bool _quiet = false;
+};
+
+inline HostSerial Serial;
@@ -0,0 +1,44 @@
+// ============================================
+// DHT SHIM (native env only)
+// Stands in for the Adafruit DHT sensor library. Readings come
+// from DHT::script(); each read costs the 2 s the real sensor
+// needs between conversions, tracked on the fake clock.
+// ============================================
+
+#pragma once
+
+#include <Arduino.h>
+
+#define DHT11 11
+#define DHT22 22
+
+class DHT {
+public:
+    DHT(uint8_t pin, uint8_t type) : _pin(pin), _type(type) {}
+
+    void begin() {}
+
+    // Values the next reads return; NAN makes them fail like a timeout
+    static void script(float temperature, float humidity) {
+        _temperature = temperature;
+        _humidity = humidity;
+    }
+    static uint32_t reads() { return _reads; }
+    static void resetReads() { _reads = 0; }
+
+    float readTemperature(bool = false, bool = false) {
+        _reads++;
+        return _temperature;
+    }
+    float readHumidity(bool = false) {
+        _reads++;
+        return _humidity;
+    }
+
+private:
+    uint8_t _pin;
+    uint8_t _type;
+    static inline float _temperature = 21.0f;
+    static inline float _humidity = 45.0f;
+    static inline uint32_t _reads = 0;
+};
@@ -0,0 +1,67 @@
+// ============================================
+// HTTPCLIENT SHIM (native env only)
+// Answers every request with a scripted status code and body
+// and records what was sent, so upload paths run on the host
+// without a network. Header values are plain C strings here;
+// the real library returns Arduino Strings.
+// ============================================
+
+#pragma once
+
+#include <Arduino.h>
+
+#define HTTPC_ERROR_CONNECTION_REFUSED (-1)
+#define HTTPC_ERROR_READ_TIMEOUT (-11)
+
+class HTTPClient {
+public:
+    // Status code and body of the next responses (until changed)
+    static void script(int code, const char* body = "", const char* retryAfter = nullptr) {
+        _code = code;
+        _body = body;
+        _retryAfter = retryAfter;
+    }
+    static uint32_t requests() { return _requests; }
+    static size_t lastBodyLength() { return _lastBodyLength; }
+    static const uint8_t* lastBody() { return _lastBody; }
+    static void resetStats() {
+        _requests = 0;
+        _lastBodyLength = 0;
+    }
+
+    bool begin(const char*) { return true; }
+    void end() {}
+    void setReuse(bool) {}
+    void setTimeout(uint16_t) {}
+    void setConnectTimeout(int32_t) {}
+    void addHeader(const char*, const char*) {}
+    void collectHeaders(const char* [], size_t) {}
+
+    int POST(uint8_t* payload, size_t size) {
+        _requests++;
+        _lastBodyLength = size < sizeof(_lastBody) ? size : sizeof(_lastBody);
+        memcpy(_lastBody, payload, _lastBodyLength);
+        return _code;
+    }
+    int GET() {
+        _requests++;
+        return _code;
+    }
+
+    int getSize() const { return (int)strlen(_body); }
+    const char* getBody() const { return _body; }
+
+    bool hasHeader(const char* name) const { return header(name) != nullptr; }
+    const char* header(const char* name) const {
+        if (strcmp(name, "Retry-After") == 0) return _retryAfter;
+        return nullptr;
+    }
+
+private:
+    static inline int _code = 200;
+    static inline const char* _body = "";
+    static inline const char* _retryAfter = nullptr;
+    static inline uint32_t _requests = 0;
+    static inline uint8_t _lastBody[1024];
+    static inline size_t _lastBodyLength = 0;
+};
@@ -0,0 +1,62 @@
+// ============================================
+// RAM STORAGE SHIM (native env only)
+// Stands in for LittleFsStorage behind ReadingLog. Starts erased
+// (0xFF) and can cut the power part-way through a write: the bytes
+// up to the cut land, the rest keep their old contents, and every
+// later write fails until powerOn() (the reboot).
+// ============================================
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <vector>
+
+class RamStorage {
+public:
+    explicit RamStorage(size_t size) : _bytes(size, 0xFF) {}
+
+    bool read(uint32_t offset, void* dst, size_t len) {
+        if (offset + len > _bytes.size()) return false;
+        memcpy(dst, _bytes.data() + offset, len);
+        return true;
+    }
+
+    bool write(uint32_t offset, const void* src, size_t len) {
+        if (!_powered || offset + len > _bytes.size()) return false;
+        _writes++;
+        if (_cutAfter >= 0 && (size_t)_cutAfter < len) {
+            memcpy(_bytes.data() + offset, src, (size_t)_cutAfter);
+            _powered = false;
+            return false;
+        }
+        memcpy(_bytes.data() + offset, src, len);
+        if (_cutAfter >= 0) _cutAfter -= (long)len;
+        _written += len;
+        return true;
+    }
+
+    size_t size() const { return _bytes.size(); }
+
+    // Power fails once bytes more bytes were written (a torn write
+    // when it falls inside one); negative never cuts
+    void cutPowerAfter(long bytes) { _cutAfter = bytes; }
+    void powerOn() {
+        _powered = true;
+        _cutAfter = -1;
+    }
+    bool powered() const { return _powered; }
+
+    size_t written() const { return _written; }
+    uint32_t writes() const { return _writes; }
+    uint8_t* data() { return _bytes.data(); }
+
+private:
+    std::vector<uint8_t> _bytes;
+    long _cutAfter = -1;
+    bool _powered = true;
+    size_t _written = 0;
+    uint32_t _writes = 0;
+};
@@ -0,0 +1,65 @@
+#include "littlefs_storage.h"
+
+bool LittleFsStorage::begin() {
+    if (!LittleFS.begin(true)) {
+        Serial.println("[Log] ❌ LittleFS mount failed");
+        return false;
+    }
+
+    // A log sized for another record layout can't be reused: start over
+    if (LittleFS.exists(_path)) {
+        File existing = LittleFS.open(_path, FILE_READ);
+        size_t found = existing ? existing.size() : 0;
+        if (existing) existing.close();
+        if (found != _size) {
+            Serial.printf("[Log] ⚠️ %s is %u bytes, expected %u: recreating it\n",
+                          _path, (unsigned)found, (unsigned)_size);
+            if (!LittleFS.remove(_path)) {
+                Serial.printf("[Log] ❌ Could not remove %s\n", _path);
+                return false;
+            }
+        }
+    }
+
+    if (!LittleFS.exists(_path) && !create()) {
+        Serial.printf("[Log] ❌ Could not create %s (%u bytes, %u free)\n", _path, (unsigned)_size,
+                      (unsigned)(LittleFS.totalBytes() - LittleFS.usedBytes()));
+        LittleFS.remove(_path);
+        return false;
+    }
+
+    _file = LittleFS.open(_path, "r+");
+    if (!_file) {
+        Serial.printf("[Log] ❌ Could not open %s\n", _path);
+        return false;
+    }
+    return true;
+}
+
+bool LittleFsStorage::create() {
+    File created = LittleFS.open(_path, FILE_WRITE);
+    if (!created) return false;
+    uint8_t blank[64];
+    memset(blank, 0xFF, sizeof(blank));
+    for (size_t written = 0; written < _size; written += sizeof(blank)) {
+        size_t chunk = min(sizeof(blank), _size - written);
+        if (created.write(blank, chunk) != chunk) {
+            created.close();
+            return false;
+        }
+    }
+    created.close();
+    return true;
+}
+
+bool LittleFsStorage::read(uint32_t offset, void* dst, size_t len) {
+    if (!_file || offset + len > _size || !_file.seek(offset)) return false;
+    return _file.read((uint8_t*)dst, len) == len;
+}
+
+bool LittleFsStorage::write(uint32_t offset, const void* src, size_t len) {
+    if (!_file || offset + len > _size || !_file.seek(offset)) return false;
+    if (_file.write((const uint8_t*)src, len) != len) return false;
+    _file.flush();
+    return true;
+}
@@ -0,0 +1,33 @@
+// ============================================
+// LITTLEFS STORAGE
+// Fixed-size file on LittleFS used as the backing store for
+// ReadingLog. Every write is synced, and LittleFS commits each
+// sync atomically, so a power cut leaves either the old or the
+// new bytes in place.
+// ============================================
+
+#pragma once
+
+#include <Arduino.h>
+#include <FS.h>
+#include <LittleFS.h>
+
+class LittleFsStorage {
+public:
+    LittleFsStorage(const char* path, size_t size) : _path(path), _size(size) {}
+
+    // Mounts LittleFS (formatting it on first use) and creates the file,
+    // recreating it blank when its size doesn't match. Logs why it failed.
+    bool begin();
+
+    bool read(uint32_t offset, void* dst, size_t len);
+    bool write(uint32_t offset, const void* src, size_t len);
+    size_t size() const { return _size; }
+
+private:
+    bool create();
+
+    const char* _path;
+    size_t _size;
+    File _file;
+};
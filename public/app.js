@@ -7,12 +7,25 @@ const els = {
   pollMs: document.getElementById("pollMs"),
   historyLimit: document.getElementById("historyLimit"),
   applyBtn: document.getElementById("applyBtn"),
+  localDevice: document.getElementById("localDevice"),
+  localToken: document.getElementById("localToken"),
   navItems: Array.from(document.querySelectorAll(".nav-item")),
 };
 
 let pollIntervalMs = 2000;
-let historyLimit = 200;
+let historyLimit = 10000;
 let latestSeenTs = null;
+// Flash controller on the LAN (mDNS name announced by the firmware);
+// empty disables the local control path
+let localDeviceUrl = localStorage.getItem("localDeviceUrl") ?? "http://climate-monitor.local";
+// Bearer token the device expects (LOCAL_CONTROL_TOKEN in the firmware)
+let localToken = localStorage.getItem("localToken") ?? "";
+
+// History rows kept in the browser (ring buffer of historyLimit readings,
+// see series.js), and the table and chart showing them once History opens
+const historyStore = new SeriesStore(historyLimit);
+let historyView = null;
+let historyLoaded = false;
 
 // ------------------------------
 // 1. UTILITY FUNCTIONS
@@ -50,8 +63,9 @@ function setStatus(state, text) {
 // ------------------------------
 // 3. API FETCH
 // ------------------------------
+// "no-cache" revalidates every time; unchanged data comes back as a 304
 async function fetchJson(url) {
-  const res = await fetch(url, { cache: "no-store" });
+  const res = await fetch(url, { cache: "no-cache" });
   if (!res.ok) throw new Error(`HTTP ${res.status}`);
   return await res.json();
 }
@@ -59,6 +73,11 @@ async function fetchJson(url) {
 // ------------------------------
 // 4. RENDER LATEST DATA
 // ------------------------------
+// Capture time on the device when it was stamped, else arrival time
+function observedTs(row) {
+  return row.device_recorded_at || row.recorded_at || row.timestamp;
+}
+
 function renderLatest(latest) {
   if (!latest) {
     els.tempValue.textContent = "-- °C";
@@ -68,7 +87,7 @@ function renderLatest(latest) {
     return;
   }
 
-  const ts = latest.recorded_at || latest.timestamp;
+  const ts = observedTs(latest);
   els.tempValue.textContent = fmtNum(latest.temperature, 1) + " °C";
   els.humValue.textContent = fmtNum(latest.humidity, 1) + " %";
   els.tempTs.textContent = fmtTs(ts);
@@ -78,6 +97,16 @@ function renderLatest(latest) {
 // ------------------------------
 // 5. REFRESH LATEST DATA
 // ------------------------------
+function applyLatest(latest) {
+  renderLatest(latest);
+  if (latestSeenTs !== observedTs(latest)) {
+    latestSeenTs = observedTs(latest);
+    setStatus("ok", `● Live (${fmtNum(latest.temperature, 1)}°C)`);
+  } else {
+    setStatus("ok", "● Live");
+  }
+}
+
 async function refreshLatest() {
   try {
     const latest = await fetchJson("/api/latest");
@@ -88,13 +117,7 @@ async function refreshLatest() {
       return;
     }
 
-    renderLatest(latest);
-    if (latestSeenTs !== latest.recorded_at) {
-      latestSeenTs = latest.recorded_at;
-      setStatus("ok", `● Live (${fmtNum(latest.temperature, 1)}°C)`);
-    } else {
-      setStatus("ok", "● Live");
-    }
+    applyLatest(latest);
   } catch (e) {
     setStatus("bad", "● Offline");
     renderLatest(null);
@@ -102,41 +125,69 @@ async function refreshLatest() {
 }
 
 // ------------------------------
-// 6. REFRESH HISTORY (FULL TABLE)
+// 6. HISTORY (VIRTUAL TABLE + CHART)
 // ------------------------------
+// Only the rows in view are in the DOM and the chart draws one min/max
+// stroke per pixel column, so tens of thousands of rows stay smooth
+const HISTORY_COLUMNS = [
+  (store, i) => new Date(store.time(i)).toLocaleString(),
+  (store, i) => fmtNum(store.value("temperature", i), 1),
+  (store, i) => fmtNum(store.value("humidity", i), 1),
+];
+
+function getHistoryView() {
+  if (historyView) return historyView;
+  const scroller = document.getElementById("historyScroll");
+  const body = document.getElementById("historyBodyFull");
+  const canvas = document.getElementById("historyChart");
+  if (!scroller || !body || !canvas) return null;
+
+  historyView = {
+    table: new VirtualTable({ scroller, body, store: historyStore, columns: HISTORY_COLUMNS }),
+    chart: new DecimatedChart(canvas, historyStore, [
+      { key: "temperature", color: "#ff9f5a", unit: "°C" },
+      { key: "humidity", color: "#55a6ff", unit: "%" },
+    ]),
+  };
+  window.addEventListener("resize", () => historyView.chart.invalidate());
+  return historyView;
+}
+
+// Redraws after rows were added, removed or the store was resized
+function historyChanged(added = 0) {
+  const countEl = document.getElementById("historyCountFull");
+  if (countEl) countEl.textContent = historyStore.length;
+  if (!historyView) return;
+  historyView.table.append(added);
+  historyView.chart.invalidate();
+}
+
+// The first load fetches the newest historyLimit rows; after that only
+// rows newer than the newest one held are fetched and appended
 async function refreshHistoryFull() {
-  try {
-    const res = await fetch('/api/history');
-    const rows = await res.json();
-    const tbody = document.getElementById('historyBodyFull');
-    const countEl = document.getElementById('historyCountFull');
-
-    if (!rows?.length) {
-      tbody.innerHTML = `<tr><td colspan="3" class="muted">No change events recorded yet.</td></tr>`;
-      countEl.textContent = '0';
-      return;
-    }
+  const view = getHistoryView();
+  if (!view) return;
 
-    countEl.textContent = rows.length;
-    tbody.innerHTML = rows
-      .reverse()
-      .map(r => `
-        <tr>
-          <td>${fmtTs(r.recorded_at)}</td>
-          <td>${fmtNum(r.temperature, 1)}</td>
-          <td>${fmtNum(r.humidity, 1)}</td>
-        </tr>
-      `)
-      .join('');
+  try {
+    const sinceMs = historyStore.newestTime();
+    if (sinceMs === null) view.table.showMessage("Loading history...");
+    const rows = await fetchHistoryRows({ limit: historyLimit, sinceMs });
+    historyLoaded = true;
+    view.table.showMessage("No change events recorded yet.");
+    historyChanged(historyStore.pushRows(rows));
   } catch (e) {
     console.error('History fetch failed:', e);
-    const tbody = document.getElementById('historyBodyFull');
-    if (tbody) {
-      tbody.innerHTML = `<tr><td colspan="3" class="muted">Failed to load history</td></tr>`;
-    }
+    view.table.showMessage("Failed to load history");
   }
 }
 
+// Append one streamed row once the history has been loaded
+function appendHistoryRow(r) {
+  if (!historyLoaded) return;
+  const added = historyStore.pushRows([r]);
+  if (added) historyChanged(added);
+}
+
 // ------------------------------
 // 7. NAVIGATION HANDLER (SPA)
 // ------------------------------
@@ -148,7 +199,7 @@ function bindNav() {
       btn.classList.add("active");
 
       // Hide all sections
-      const allSections = ["tempCard", "humCard", "settingsCard", "historySection"];
+      const allSections = ["tempCard", "humCard", "telemetryCard", "settingsCard", "historySection"];
       allSections.forEach(id => {
         const el = document.getElementById(id);
         if (el) el.style.display = "none";
@@ -162,8 +213,10 @@ function bindNav() {
         const tempCard = document.getElementById("tempCard");
         const humCard = document.getElementById("humCard");
         const settingsCard = document.getElementById("settingsCard");
+        const telemetryCard = document.getElementById("telemetryCard");
         if (tempCard) tempCard.style.display = "block";
         if (humCard) humCard.style.display = "block";
+        if (telemetryCard) telemetryCard.style.display = "block";
         if (settingsCard) settingsCard.style.display = "block";
         document.querySelector('.main').scrollTo(0, 0);
       } else if (section === "history") {
@@ -171,6 +224,8 @@ function bindNav() {
         const historySection = document.getElementById("historySection");
         if (historySection) {
           historySection.style.display = "block";
+          // Sized now that the section is visible; new rows load meanwhile
+          historyChanged();
           refreshHistoryFull();
 
           const refreshBtn = document.getElementById("refreshHistoryBtn");
@@ -178,10 +233,9 @@ function bindNav() {
           if (refreshBtn) refreshBtn.onclick = refreshHistoryFull;
           if (clearBtn) {
             clearBtn.onclick = () => {
-              const tbody = document.getElementById("historyBodyFull");
-              if (tbody) {
-                tbody.innerHTML = `<tr><td colspan="3" class="muted">Cleared.</td></tr>`;
-              }
+              historyStore.clear();
+              if (historyView) historyView.table.showMessage("Cleared.");
+              historyChanged();
             };
           }
         }
@@ -206,20 +260,38 @@ function bindNav() {
 // 8. SETTINGS HANDLER
 // ------------------------------
 function bindSettings() {
+  if (els.localDevice) els.localDevice.value = localDeviceUrl;
+  if (els.localToken) els.localToken.value = localToken;
+
   if (els.applyBtn) {
     els.applyBtn.addEventListener("click", () => {
       const ms = Number(els.pollMs?.value);
       const lim = Number(els.historyLimit?.value);
       if (ms >= 500) pollIntervalMs = ms;
       if (lim >= 10) historyLimit = lim;
-      startPolling();
+      if (historyStore.capacity !== historyLimit) {
+        historyStore.resize(historyLimit);
+        if (historyView) historyView.chart.setStore(historyStore);
+        historyChanged();
+      }
+      if (els.localDevice) {
+        localDeviceUrl = els.localDevice.value.trim().replace(/\/+$/, "");
+        localStorage.setItem("localDeviceUrl", localDeviceUrl);
+        localReachable = null;
+      }
+      if (els.localToken) {
+        localToken = els.localToken.value.trim();
+        localStorage.setItem("localToken", localToken);
+        localReachable = null;
+      }
+      if (pollTimer) startPolling();
       setStatus("ok", "● Settings applied");
     });
   }
 }
 
 // ------------------------------
-// 9. POLLING
+// 9. LIVE STREAM + POLLING FALLBACK
 // ------------------------------
 let pollTimer = null;
 function startPolling() {
@@ -228,8 +300,83 @@ function startPolling() {
   pollTimer = setInterval(refreshLatest, pollIntervalMs);
 }
 
+function stopPolling() {
+  if (pollTimer) clearInterval(pollTimer);
+  pollTimer = null;
+}
+
+// Readings are pushed over SSE; polling only runs while the stream is down
+let stream = null;
+function startStream() {
+  if (!window.EventSource) {
+    startPolling();
+    return;
+  }
+
+  stream = new EventSource("/api/stream");
+
+  stream.onopen = () => stopPolling();
+
+  stream.addEventListener("reading", (ev) => {
+    const row = JSON.parse(ev.data);
+    // A reconnect's catch-up resends rows: the history store skips the
+    // ids it holds, the cards skip rows they have shown
+    appendHistoryRow(row);
+    // or taken earlier: a board draining its offline log sends old ones
+    if (latestSeenTs && Date.parse(observedTs(row)) <= Date.parse(latestSeenTs)) return;
+
+    applyLatest(row);
+  });
+
+  // EventSource reconnects by itself (the server closes every ~55 s);
+  // poll in the meantime so the cards never go stale
+  stream.onerror = () => {
+    if (!pollTimer) startPolling();
+  };
+}
+
 // ------------------------------
-// 10. INIT
+// 10. DEVICE TELEMETRY
+// ------------------------------
+// Stage timings arrive in microseconds
+function fmtUs(us) {
+  if (!Number.isFinite(us)) return "—";
+  if (us >= 1000000) return (us / 1000000).toFixed(2) + " s";
+  if (us >= 1000) return (us / 1000).toFixed(1) + " ms";
+  return us + " µs";
+}
+
+async function refreshTelemetry() {
+  const tbody = document.getElementById("telemetryBody");
+  const tsEl = document.getElementById("telemetryTs");
+  if (!tbody) return;
+
+  try {
+    const reports = await fetchJson("/api/telemetry");
+    if (!Array.isArray(reports) || reports.length === 0) return;
+
+    // Device ids and stage names come from devices: text only, never markup
+    const rows = [];
+    for (const r of reports) {
+      for (const [stage, s] of Object.entries(r.stages || {})) {
+        const tr = document.createElement("tr");
+        for (const text of [r.device_id, stage, s.n, fmtUs(s.p50), fmtUs(s.p95), fmtUs(s.max)]) {
+          const td = document.createElement("td");
+          td.textContent = String(text);
+          tr.appendChild(td);
+        }
+        rows.push(tr);
+      }
+    }
+    tbody.replaceChildren(...rows);
+    if (tsEl) tsEl.textContent = fmtTs(reports[0].received_at);
+  } catch (e) {
+    console.error("Telemetry fetch failed:", e);
+  }
+}
+
+// ------------------------------
+// 11. INIT
 // ------------------------------
 (function init() {
   console.log("🚀 ClimateCloud Dashboard initializing...");
@@ -248,7 +395,10 @@ function startPolling() {
   bindNav();
   bindSettings();
   setStatus("warn", "● Connecting");
-  startPolling();
+  refreshLatest();
+  startStream();
+  refreshTelemetry();
+  setInterval(refreshTelemetry, 60000);
 
   // Auto-open Dashboard on load
   const dashboardBtn = document.querySelector('.nav-item[data-section="dashboard"]');
@@ -277,33 +427,102 @@ function updateFlashController(delay) {
   if (flashEls.slider) flashEls.slider.value = delay;
 }
 
-// Poll for delay changes
-async function pollFlashDelay() {
+// Watch for delay changes: the server holds the request until the delay
+// differs from ours (or ~8 s pass), then we immediately ask again.
+// Failures (network or non-2xx) keep the current value and retry after a
+// doubling wait, or the server's Retry-After when it sends one.
+const DELAY_RETRY_MIN_MS = 3000;
+const DELAY_RETRY_MAX_MS = 60000;
+let delayRetryMs = DELAY_RETRY_MIN_MS;
+
+async function watchFlashDelay() {
+  let retryAfterMs = 0;
   try {
-    const res = await fetch('/api/delay');
+    const res = await fetch(`/api/delay?since=${flashDelay}&wait=8000`, { cache: "no-store" });
+    if (!res.ok) {
+      retryAfterMs = (Number(res.headers.get("Retry-After")) || 0) * 1000;
+      throw new Error(`HTTP ${res.status}`);
+    }
     const data = await res.json();
-    updateFlashController(data.delay || 500);
+    if (Number.isFinite(data.delay)) updateFlashController(data.delay);
     if (flashEls.status) flashEls.status.textContent = "Connected";
+    delayRetryMs = DELAY_RETRY_MIN_MS;
+    watchFlashDelay();
   } catch (e) {
+    console.warn("Delay watch failed:", e.message);
     if (flashEls.status) flashEls.status.textContent = "Disconnected";
+    setTimeout(watchFlashDelay, Math.max(delayRetryMs, retryAfterMs));
+    delayRetryMs = Math.min(delayRetryMs * 2, DELAY_RETRY_MAX_MS);
+  }
+}
+
+// ------------------------------
+// LOCAL (LAN) CONTROL
+// ------------------------------
+// The device answers on http://<name>.local/delay and forwards local
+// changes to /api/delay itself, so the cloud stays in sync. Requests
+// carry the LAN token; without one the local path is skipped. Browsers
+// block http:// requests from an https:// page (mixed content), so the
+// local path only works when the dashboard itself is served over http.
+const LOCAL_TIMEOUT_MS = 300;
+const LOCAL_RETRY_MS = 30000;
+let localReachable = null;   // null = unknown, retried after a failure
+
+function localAllowed() {
+  if (!localDeviceUrl || !localToken) return false;
+  return !(location.protocol === "https:" && localDeviceUrl.startsWith("http:"));
+}
+
+async function postLocalDelay(delay) {
+  const ctl = new AbortController();
+  const timer = setTimeout(() => ctl.abort(), LOCAL_TIMEOUT_MS);
+  try {
+    const res = await fetch(`${localDeviceUrl}/delay`, {
+      method: 'POST',
+      headers: { 'Content-Type': 'application/json', 'Authorization': `Bearer ${localToken}` },
+      body: JSON.stringify({ delay }),
+      signal: ctl.signal,
+    });
+    return res.ok;
+  } finally {
+    clearTimeout(timer);
+  }
+}
+
+// Local device first, cloud as fallback
+async function sendDelay(delay) {
+  if (localAllowed() && localReachable !== false) {
+    try {
+      if (await postLocalDelay(delay)) {
+        localReachable = true;
+        if (flashEls.status) flashEls.status.textContent = "Connected (LAN)";
+        return;
+      }
+    } catch (e) {
+      // unreachable or timed out: use the cloud
+    }
+    localReachable = false;
+    setTimeout(() => { localReachable = null; }, LOCAL_RETRY_MS);
+  }
+
+  try {
+    await fetch('/api/delay', {
+      method: 'POST',
+      headers: { 'Content-Type': 'application/json' },
+      body: JSON.stringify({ delay })
+    });
+    if (flashEls.status) flashEls.status.textContent = "Connected";
+  } catch (e) {
+    if (flashEls.status) flashEls.status.textContent = "Error";
   }
 }
 
 // Handle slider changes
 if (flashEls.slider) {
-  flashEls.slider.addEventListener('input', async () => {
+  flashEls.slider.addEventListener('input', () => {
     const newDelay = parseInt(flashEls.slider.value);
     updateFlashController(newDelay);
-    try {
-      await fetch('/api/delay', {
-        method: 'POST',
-        headers: { 'Content-Type': 'application/json' },
-        body: JSON.stringify({ delay: newDelay })
-      });
-      if (flashEls.status) flashEls.status.textContent = "Connected";
-    } catch (e) {
-      if (flashEls.status) flashEls.status.textContent = "Error";
-    }
+    sendDelay(newDelay);
   });
 }
 
@@ -312,13 +531,7 @@ if (flashEls.fasterBtn) {
   flashEls.fasterBtn.addEventListener('click', () => {
     const newDelay = Math.max(MIN_DELAY, flashDelay - 50);
     updateFlashController(newDelay);
-
-    
-    fetch('/api/delay', {
-      method: 'POST',
-      headers: { 'Content-Type': 'application/json' },
-      body: JSON.stringify({ delay: newDelay })
-    });
+    sendDelay(newDelay);
   });
 }
 
@@ -326,11 +539,7 @@ if (flashEls.slowerBtn) {
   flashEls.slowerBtn.addEventListener('click', () => {
     const newDelay = Math.min(MAX_DELAY, flashDelay + 50);
     updateFlashController(newDelay);
-    fetch('/api/delay', {
-      method: 'POST',
-      headers: { 'Content-Type': 'application/json' },
-      body: JSON.stringify({ delay: newDelay })
-    });
+    sendDelay(newDelay);
   });
 }
 
@@ -339,16 +548,12 @@ document.querySelectorAll('.btn[data-delay]').forEach(btn => {
   btn.addEventListener('click', () => {
     const delay = parseInt(btn.dataset.delay);
     updateFlashController(delay);
-    fetch('/api/delay', {
-      method: 'POST',
-      headers: { 'Content-Type': 'application/json' },
-      body: JSON.stringify({ delay })
-    });
+    sendDelay(delay);
   });
 });
 
-// Start polling
-setInterval(pollFlashDelay, 3000);
+// Start watching
+watchFlashDelay();
 
 
 
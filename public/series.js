@@ -0,0 +1,497 @@
+// public/series.js
+// History view that stays fast at 100k rows: a ring-buffer series store,
+// a table that only creates the rows in view, and a canvas chart
+// decimated to min/max per pixel column. New readings are appended: the
+// store and chart take O(1) per reading and the table re-renders only
+// the rows on screen. Shared by index.html (History) and history.html;
+// measured by tools/bench_history.html.
+
+// ------------------------------
+// 1. RING-BUFFER SERIES STORE
+// ------------------------------
+// Parallel typed arrays, oldest first by the time the reading was taken
+// (device_recorded_at, else recorded_at). Once full, a push overwrites
+// the oldest reading, so memory stays at 16 bytes per slot (plus its row
+// key) however long the page runs. Rows are told apart by id, not by
+// time: one upload batch can put several readings in one millisecond.
+// Readings drained late from a board's offline log are merged in at their
+// times, all of one pushRows() call in a single pass, and bump `revision`,
+// so the chart rebuilds.
+class SeriesStore {
+  constructor(capacity) {
+    this.allocate(capacity);
+  }
+
+  allocate(capacity) {
+    this.capacity = Math.max(1, capacity | 0);
+    this.times = new Float64Array(this.capacity);
+    this.temperature = new Float32Array(this.capacity);
+    this.humidity = new Float32Array(this.capacity);
+    this.keys = new Array(this.capacity);
+    this.seen = new Set();
+    this.head = 0;      // slot of the oldest reading
+    this.length = 0;
+    this.total = 0;     // readings ever pushed; numbers them across wraps
+    this.revision = 0;  // bumped when a reading lands before the newest
+  }
+
+  // i = 0 is the oldest reading
+  slot(i) {
+    const s = this.head + i;
+    return s < this.capacity ? s : s - this.capacity;
+  }
+
+  time(i) { return this.times[this.slot(i)]; }
+  value(key, i) { return this[key][this.slot(i)]; }
+  newestTime() { return this.length ? this.time(this.length - 1) : null; }
+
+  // Missing values are stored as NaN; key (optional) identifies the row
+  push(time, temperature, humidity, key) {
+    let slot;
+    if (this.length < this.capacity) {
+      slot = this.slot(this.length);
+      this.length++;
+    } else {
+      slot = this.head;
+      this.seen.delete(this.keys[slot]);
+      this.head = this.head + 1 === this.capacity ? 0 : this.head + 1;
+    }
+    this.write(slot, time, temperature, humidity, key);
+    this.total++;
+  }
+
+  write(slot, time, temperature, humidity, key) {
+    this.times[slot] = time;
+    this.temperature[slot] = typeof temperature === "number" ? temperature : NaN;
+    this.humidity[slot] = typeof humidity === "number" ? humidity : NaN;
+    this.keys[slot] = key;
+    if (key !== undefined) this.seen.add(key);
+  }
+
+  // Readings older than the newest ({ time, temperature, humidity, key }),
+  // merged in from the newest end in one pass: O(length + m log m) for m
+  // of them, where inserting one at a time would move the later readings
+  // once each. A full store drops the oldest of old and new alike. Returns
+  // how many were kept.
+  merge(late) {
+    if (late.length === 0) return 0;
+    late.sort((a, b) => a.time - b.time);   // stable: ties keep arrival order
+
+    // Evict first, so the merge below only ever writes into free slots
+    let from = 0;
+    for (let drop = this.length + late.length - this.capacity; drop > 0; drop--) {
+      if (this.length > 0 && (from === late.length || this.time(0) <= late[from].time)) {
+        this.seen.delete(this.keys[this.head]);
+        this.head = this.head + 1 === this.capacity ? 0 : this.head + 1;
+        this.length--;
+      } else {
+        from++;
+      }
+    }
+
+    const kept = late.length - from;
+    let i = this.length - 1;
+    for (let j = late.length - 1, k = this.length + kept - 1; j >= from; k--) {
+      if (i >= 0 && this.time(i) > late[j].time) {
+        this.move(this.slot(i--), this.slot(k));
+      } else {
+        const r = late[j--];
+        this.write(this.slot(k), r.time, r.temperature, r.humidity, r.key);
+      }
+    }
+    this.length += kept;
+    this.total += kept;
+    if (kept) this.revision++;
+    return kept;
+  }
+
+  move(from, to) {
+    this.times[to] = this.times[from];
+    this.temperature[to] = this.temperature[from];
+    this.humidity[to] = this.humidity[from];
+    this.keys[to] = this.keys[from];
+  }
+
+  // Index of the reading with this time and key, or -1
+  indexOf(time, key) {
+    let lo = 0, hi = this.length;
+    while (lo < hi) {
+      const mid = (lo + hi) >> 1;
+      if (this.time(mid) < time) lo = mid + 1; else hi = mid;
+    }
+    for (; lo < this.length && this.time(lo) === time; lo++) {
+      if (this.keys[this.slot(lo)] === key) return lo;
+    }
+    return -1;
+  }
+
+  // API rows ({ id, recorded_at, device_recorded_at, temperature,
+  // humidity }), oldest first; returns how many were not held yet
+  pushRows(rows) {
+    const late = [];
+    const lateKeys = new Set();
+    let added = 0;
+    for (const r of rows) {
+      const key = rowKey(r);
+      if (this.seen.has(key) || lateKeys.has(key)) continue;
+      const t = Date.parse(r.device_recorded_at ?? r.recorded_at);
+      if (!Number.isFinite(t)) continue;
+      if (this.length === 0 || t >= this.newestTime()) {
+        this.push(t, r.temperature, r.humidity, key);
+        added++;
+      } else {
+        late.push({ time: t, temperature: r.temperature, humidity: r.humidity, key });
+        lateKeys.add(key);
+      }
+    }
+    return added + this.merge(late);
+  }
+
+  // Keeps the newest readings that fit
+  resize(capacity) {
+    const keep = Math.min(this.length, Math.max(1, capacity | 0));
+    const times = [], temperature = [], humidity = [], keys = [];
+    for (let i = this.length - keep; i < this.length; i++) {
+      times.push(this.time(i));
+      temperature.push(this.value("temperature", i));
+      humidity.push(this.value("humidity", i));
+      keys.push(this.keys[this.slot(i)]);
+    }
+    const total = this.total;
+    const revision = this.revision;
+    this.allocate(capacity);
+    for (let i = 0; i < keep; i++) this.push(times[i], temperature[i], humidity[i], keys[i]);
+    this.total = total;
+    this.revision = revision + 1;
+  }
+
+  clear() {
+    this.head = 0;
+    this.length = 0;
+    this.seen.clear();
+  }
+}
+
+// The row id, or for rows without one the full timestamps as sent
+// (microseconds kept)
+function rowKey(r) {
+  return r.id !== undefined && r.id !== null ? `#${r.id}` : `${r.recorded_at}|${r.device_recorded_at ?? ""}`;
+}
+
+// ------------------------------
+// 2. HISTORY LOADER
+// ------------------------------
+// Walks the raw pages of /api/history (newest first, keyset cursor) until
+// `limit` rows or, with sinceMs, everything taken from that time on; rows
+// the store already holds are skipped by id. Returns the rows oldest
+// first, ready for SeriesStore.pushRows().
+const HISTORY_PAGE = 1000;
+
+async function fetchHistoryRows({ limit, sinceMs = null }) {
+  const rows = [];
+  let cursor = null;
+  while (rows.length < limit) {
+    const params = new URLSearchParams({ limit: String(Math.min(HISTORY_PAGE, limit - rows.length)) });
+    if (sinceMs !== null) params.set("from", new Date(sinceMs).toISOString());
+    if (cursor) params.set("cursor", cursor);
+
+    const res = await fetch(`/api/history?${params}`, { cache: "no-cache" });
+    if (!res.ok) throw new Error(`HTTP ${res.status}`);
+    const page = await res.json();
+    rows.push(...(page.rows || []));
+    cursor = page.next_cursor;
+    if (!cursor) break;
+  }
+  return rows.reverse();
+}
+
+// ------------------------------
+// 3. VIRTUALIZED TABLE
+// ------------------------------
+// Newest first. The tbody holds a spacer row above and below and a pool
+// of rows for what is in view (plus `overscan` on each side), so the DOM
+// stays a few dozen rows whatever the store holds. Rows must have a fixed
+// height (see .table.virtual in styles.css).
+class VirtualTable {
+  constructor({ scroller, body, store, columns, rowHeight = 40, overscan = 10 }) {
+    this.scroller = scroller;
+    this.body = body;
+    this.store = store;
+    this.columns = columns;     // (store, i) => cell text
+    this.rowHeight = rowHeight;
+    this.overscan = overscan;
+    this.pool = [];
+    this.frame = 0;
+    this.added = false;
+    this.anchor = null;         // the row at the top edge when last rendered
+
+    this.body.textContent = "";
+    this.top = this.spacer();
+    this.bottom = this.spacer();
+    this.message = document.createElement("tr");
+    this.messageCell = document.createElement("td");
+    this.messageCell.colSpan = columns.length;
+    this.messageCell.className = "muted";
+    this.message.appendChild(this.messageCell);
+
+    this.scroller.addEventListener("scroll", () => this.invalidate(), { passive: true });
+  }
+
+  spacer() {
+    const tr = document.createElement("tr");
+    tr.className = "spacer";
+    const td = document.createElement("td");
+    td.colSpan = this.columns.length;
+    tr.appendChild(td);
+    this.body.appendChild(tr);
+    return td;
+  }
+
+  setStore(store) {
+    this.store = store;
+    this.invalidate();
+  }
+
+  // `added` readings arrived. A reader scrolled into the table keeps
+  // looking at the same rows: the scroll position moves by the rows that
+  // landed above them (newer), not by late ones merged in further down
+  append(added) {
+    if (added) this.added = true;
+    this.invalidate();
+  }
+
+  // Shown instead of rows while the store is empty
+  showMessage(text) {
+    this.messageText = text;
+    this.invalidate();
+  }
+
+  invalidate() {
+    if (this.frame) return;
+    this.frame = requestAnimationFrame(() => {
+      this.frame = 0;
+      this.render();
+    });
+  }
+
+  render() {
+    const n = this.store.length;
+    if (n === 0) {
+      this.messageCell.textContent = this.messageText || "No data.";
+      if (!this.message.parentNode) this.body.insertBefore(this.message, this.top.parentNode);
+      this.top.style.height = this.bottom.style.height = "0px";
+      this.pool.forEach(tr => { tr.hidden = true; });
+      return;
+    }
+    if (this.message.parentNode) this.message.remove();
+
+    if (this.added) {
+      const i = this.anchor && this.scroller.scrollTop > 0 ? this.store.indexOf(this.anchor.time, this.anchor.key) : -1;
+      const shift = i < 0 ? 0 : n - 1 - i - this.anchor.row;
+      if (shift > 0) {
+        // Room for the taller table first, or scrollTop would be clamped
+        this.bottom.style.height = `${n * this.rowHeight}px`;
+        this.scroller.scrollTop += shift * this.rowHeight;
+      }
+      this.added = false;
+    }
+
+    const visible = Math.ceil(this.scroller.clientHeight / this.rowHeight) + 2 * this.overscan;
+    const first = Math.min(Math.max(0, Math.floor(this.scroller.scrollTop / this.rowHeight) - this.overscan), n - 1);
+    const count = Math.min(visible, n - first);
+
+    while (this.pool.length < count) {
+      const tr = document.createElement("tr");
+      for (let c = 0; c < this.columns.length; c++) tr.appendChild(document.createElement("td"));
+      this.body.insertBefore(tr, this.bottom.parentNode);
+      this.pool.push(tr);
+    }
+
+    for (let r = 0; r < this.pool.length; r++) {
+      const tr = this.pool[r];
+      tr.hidden = r >= count;
+      if (tr.hidden) continue;
+      const i = n - 1 - (first + r);
+      for (let c = 0; c < this.columns.length; c++) {
+        const text = this.columns[c](this.store, i);
+        const td = tr.cells[c];
+        if (td.textContent !== text) td.textContent = text;
+      }
+    }
+
+    this.top.style.height = `${first * this.rowHeight}px`;
+    this.bottom.style.height = `${(n - first - count) * this.rowHeight}px`;
+
+    const row = Math.min(Math.floor(this.scroller.scrollTop / this.rowHeight), n - 1);
+    const i = n - 1 - row;
+    this.anchor = { row, time: this.store.time(i), key: this.store.keys[this.store.slot(i)] };
+  }
+}
+
+// ------------------------------
+// 4. DECIMATED CANVAS CHART
+// ------------------------------
+// Readings are folded into at most one bucket per device pixel column,
+// keeping min and max per series: the drawn envelope shows every spike,
+// and drawing costs O(width) however many readings there are. Buckets
+// are a power-of-two number of seconds wide. When the data outgrows the
+// canvas, neighbouring buckets are merged in pairs (exact for min/max),
+// so appends never rescan the store. Buckets of evicted readings are not
+// drawn; once they are half the chart it is rebuilt from the store.
+class DecimatedChart {
+  constructor(canvas, store, series) {
+    this.canvas = canvas;
+    this.ctx = canvas.getContext("2d");
+    this.store = store;
+    this.series = series;       // [{ key: "temperature", color, unit }]
+    this.columns = 0;
+    this.frame = 0;
+  }
+
+  setStore(store) {
+    this.store = store;
+    this.columns = 0;           // forces a rebuild
+    this.invalidate();
+  }
+
+  invalidate() {
+    if (this.frame) return;
+    this.frame = requestAnimationFrame(() => {
+      this.frame = 0;
+      this.update();
+      this.draw();
+    });
+  }
+
+  // Sizes the backing store to the element; false while it is hidden
+  fit() {
+    const dpr = window.devicePixelRatio || 1;
+    const width = Math.round(this.canvas.clientWidth * dpr);
+    const height = Math.round(this.canvas.clientHeight * dpr);
+    if (width === 0 || height === 0) return false;
+    if (width !== this.canvas.width || height !== this.canvas.height || width !== this.columns) {
+      this.canvas.width = width;
+      this.canvas.height = height;
+      this.columns = width;
+      this.rebuild();
+    }
+    return true;
+  }
+
+  rebuild() {
+    const store = this.store;
+    this.min = {};
+    this.max = {};
+    for (const s of this.series) {
+      this.min[s.key] = new Float32Array(this.columns).fill(Infinity);
+      this.max[s.key] = new Float32Array(this.columns).fill(-Infinity);
+    }
+
+    const span = store.length ? store.newestTime() - store.time(0) : 0;
+    this.bucketMs = 1000;
+    while (this.bucketMs * this.columns <= span) this.bucketMs *= 2;
+    this.startMs = store.length ? Math.floor(store.time(0) / this.bucketMs) * this.bucketMs : 0;
+    this.used = 0;
+    this.next = store.total - store.length;
+    this.revision = store.revision;
+  }
+
+  // Buckets the readings pushed since the last call
+  update() {
+    if (!this.fit()) return;
+    const store = this.store;
+    if (store.length === 0) {
+      if (this.used) this.rebuild();
+      return;
+    }
+    const oldest = store.total - store.length;
+    if (this.next < oldest || this.revision !== store.revision
+        || (this.used > 1 && store.time(0) >= this.startMs + (this.used / 2) * this.bucketMs)) {
+      this.rebuild();
+    }
+
+    for (; this.next < store.total; this.next++) {
+      const i = this.next - oldest;
+      const t = store.time(i);
+      let b = Math.max(0, Math.floor((t - this.startMs) / this.bucketMs));
+      while (b >= this.columns) {
+        this.mergePairs();
+        b = Math.floor((t - this.startMs) / this.bucketMs);
+      }
+      for (const s of this.series) {
+        const v = store.value(s.key, i);
+        if (Number.isNaN(v)) continue;
+        if (v < this.min[s.key][b]) this.min[s.key][b] = v;
+        if (v > this.max[s.key][b]) this.max[s.key][b] = v;
+      }
+      if (b >= this.used) this.used = b + 1;
+    }
+  }
+
+  mergePairs() {
+    const half = Math.ceil(this.used / 2);
+    for (const s of this.series) {
+      const min = this.min[s.key], max = this.max[s.key];
+      for (let i = 0; i < half; i++) {
+        const j = 2 * i;
+        min[i] = Math.min(min[j], j + 1 < this.used ? min[j + 1] : Infinity);
+        max[i] = Math.max(max[j], j + 1 < this.used ? max[j + 1] : -Infinity);
+      }
+      min.fill(Infinity, half);
+      max.fill(-Infinity, half);
+    }
+    this.used = half;
+    this.bucketMs *= 2;
+  }
+
+  // Each series gets its own vertical scale, labelled on its side
+  draw() {
+    if (!this.columns) return;
+    const { ctx, canvas } = this;
+    const dpr = window.devicePixelRatio || 1;
+    const pad = 8 * dpr;
+    ctx.clearRect(0, 0, canvas.width, canvas.height);
+    if (!this.used || !this.store.length) return;
+
+    // Buckets wholly before the oldest stored reading were evicted
+    const from = Math.min(this.used - 1, Math.max(0, Math.floor((this.store.time(0) - this.startMs) / this.bucketMs)));
+    const step = canvas.width / (this.used - from);
+    ctx.lineWidth = dpr;
+    ctx.font = `${11 * dpr}px ui-sans-serif, system-ui, sans-serif`;
+
+    this.series.forEach((s, n) => {
+      const min = this.min[s.key], max = this.max[s.key];
+      let lo = Infinity, hi = -Infinity;
+      for (let i = from; i < this.used; i++) {
+        if (min[i] < lo) lo = min[i];
+        if (max[i] > hi) hi = max[i];
+      }
+      if (lo > hi) return;
+      if (hi - lo < 0.5) { lo -= 0.25; hi += 0.25; }
+      const y = v => canvas.height - pad - (v - lo) / (hi - lo) * (canvas.height - 2 * pad);
+
+      // Vertical min-max stroke per column, joined to the next column
+      ctx.strokeStyle = s.color;
+      ctx.beginPath();
+      let open = false;
+      for (let i = from; i < this.used; i++) {
+        if (min[i] > max[i]) { open = false; continue; }
+        const x = (i - from + 0.5) * step;
+        if (open) ctx.lineTo(x, y(max[i])); else ctx.moveTo(x, y(max[i]));
+        ctx.lineTo(x, y(min[i]));
+        open = true;
+      }
+      ctx.stroke();
+
+      ctx.fillStyle = s.color;
+      ctx.textAlign = n === 0 ? "left" : "right";
+      const x = n === 0 ? pad : canvas.width - pad;
+      ctx.fillText(`${hi.toFixed(1)} ${s.unit}`, x, pad + 10 * dpr);
+      ctx.fillText(`${lo.toFixed(1)} ${s.unit}`, x, canvas.height - pad);
+    });
+  }
+}
+
+if (typeof module !== "undefined") {
+  module.exports = { SeriesStore, rowKey, fetchHistoryRows, VirtualTable, DecimatedChart };
+}
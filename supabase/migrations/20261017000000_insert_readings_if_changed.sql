@@ -0,0 +1,51 @@
+-- Conditional ingest for /api/sensor: compares each reading with the
+-- previous stored one and inserts only those that moved by more than
+-- p_threshold, all in one round trip. Returns the number of rows stored.
+
+create index if not exists readings_recorded_at_idx
+  on public.readings (recorded_at desc);
+
+create or replace function public.insert_readings_if_changed(
+  p_readings jsonb,
+  p_threshold double precision default 0.1
+)
+returns integer
+language plpgsql
+as $$
+declare
+  last_t double precision;
+  last_h double precision;
+  t double precision;
+  h double precision;
+  r jsonb;
+  stored integer := 0;
+begin
+  -- Serialise concurrent ingests so two batches never compare
+  -- against the same "last" row
+  perform pg_advisory_xact_lock(hashtext('readings_ingest'));
+
+  select temperature, humidity
+    into last_t, last_h
+    from public.readings
+    order by recorded_at desc
+    limit 1;
+
+  for r in select value from jsonb_array_elements(p_readings) loop
+    t := (r->>'temperature')::double precision;
+    h := (r->>'humidity')::double precision;
+
+    if last_t is null
+       or abs(last_t - t) > p_threshold
+       or abs(last_h - h) > p_threshold then
+      -- clock_timestamp() keeps batch rows ordered (now() is per transaction)
+      insert into public.readings (temperature, humidity, recorded_at)
+        values (t, h, clock_timestamp());
+      last_t := t;
+      last_h := h;
+      stored := stored + 1;
+    end if;
+  end loop;
+
+  return stored;
+end;
+$$;
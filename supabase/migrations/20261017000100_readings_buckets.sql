@@ -0,0 +1,38 @@
+-- Time-bucketed history for /api/history?resolution=...: one row per
+-- bucket with min/avg/max per channel, computed next to the data so the
+-- response size depends on the bucket count, not the row count.
+-- Uses readings_recorded_at_idx for the range scan.
+
+create or replace function public.readings_buckets(
+  p_from timestamptz,
+  p_to timestamptz,
+  p_bucket_seconds integer
+)
+returns table (
+  bucket timestamptz,
+  samples bigint,
+  temperature_min double precision,
+  temperature_avg double precision,
+  temperature_max double precision,
+  humidity_min double precision,
+  humidity_avg double precision,
+  humidity_max double precision
+)
+language sql
+stable
+as $$
+  select
+    to_timestamp(floor(extract(epoch from recorded_at) / p_bucket_seconds) * p_bucket_seconds) as bucket,
+    count(*) as samples,
+    min(temperature)::double precision,
+    avg(temperature)::double precision,
+    max(temperature)::double precision,
+    min(humidity)::double precision,
+    avg(humidity)::double precision,
+    max(humidity)::double precision
+  from public.readings
+  where recorded_at >= p_from
+    and recorded_at < p_to
+  group by 1
+  order by 1;
+$$;
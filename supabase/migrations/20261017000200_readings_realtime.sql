@@ -0,0 +1,4 @@
+-- /api/stream pushes new readings from Supabase realtime, which only
+-- broadcasts tables that are part of the supabase_realtime publication.
+
+alter publication supabase_realtime add table public.readings;
@@ -0,0 +1,28 @@
+-- Shared control state for /api/delay. Every serverless instance reads
+-- the same row, so the LED delay survives cold starts and is identical
+-- across concurrent instances. `version` only ever increases and is
+-- exposed to clients as the ETag.
+
+create table if not exists public.control_state (
+  key text primary key,
+  delay integer not null,
+  version bigint not null default 1
+);
+
+insert into public.control_state (key, delay, version)
+values ('delay', 500, 1)
+on conflict (key) do nothing;
+
+-- Stores a new delay and bumps the version in one statement.
+-- Returns the stored row.
+create or replace function public.set_delay(p_delay integer)
+returns table (delay integer, version bigint)
+language sql
+as $$
+  insert into public.control_state as s (key, delay, version)
+  values ('delay', p_delay, 1)
+  on conflict (key) do update
+    set delay = excluded.delay,
+        version = s.version + 1
+  returning s.delay, s.version;
+$$;
@@ -0,0 +1,18 @@
+-- Stage timing reports posted by the firmware to /api/telemetry, one
+-- row per device per report window. `stages` maps stage name to
+-- {n, p50, p95, max, mean} in microseconds.
+
+create table if not exists public.device_telemetry (
+  id bigint generated always as identity primary key,
+  device_id text not null,
+  received_at timestamptz not null default now(),
+  uptime_ms bigint,
+  probe_ns integer,
+  stages jsonb not null
+);
+
+create index if not exists device_telemetry_device_received_idx
+  on public.device_telemetry (device_id, received_at desc);
+
+create index if not exists device_telemetry_received_idx
+  on public.device_telemetry (received_at desc);
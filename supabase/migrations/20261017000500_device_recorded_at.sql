@@ -0,0 +1,53 @@
+-- Capture time reported by the device (SNTP-synced clock), stored next
+-- to recorded_at, the server's insert time. Null for readings from
+-- boards that do not stamp, or that uploaded before their first sync.
+
+alter table public.readings
+  add column if not exists device_recorded_at timestamptz;
+
+-- Same as 20261017000000_insert_readings_if_changed.sql, plus the
+-- optional device_recorded_at of each reading
+create or replace function public.insert_readings_if_changed(
+  p_readings jsonb,
+  p_threshold double precision default 0.1
+)
+returns integer
+language plpgsql
+as $$
+declare
+  last_t double precision;
+  last_h double precision;
+  t double precision;
+  h double precision;
+  r jsonb;
+  stored integer := 0;
+begin
+  -- Serialise concurrent ingests so two batches never compare
+  -- against the same "last" row
+  perform pg_advisory_xact_lock(hashtext('readings_ingest'));
+
+  select temperature, humidity
+    into last_t, last_h
+    from public.readings
+    order by recorded_at desc
+    limit 1;
+
+  for r in select value from jsonb_array_elements(p_readings) loop
+    t := (r->>'temperature')::double precision;
+    h := (r->>'humidity')::double precision;
+
+    if last_t is null
+       or abs(last_t - t) > p_threshold
+       or abs(last_h - h) > p_threshold then
+      -- clock_timestamp() keeps batch rows ordered (now() is per transaction)
+      insert into public.readings (temperature, humidity, recorded_at, device_recorded_at)
+        values (t, h, clock_timestamp(), (r->>'device_recorded_at')::timestamptz);
+      last_t := t;
+      last_h := h;
+      stored := stored + 1;
+    end if;
+  end loop;
+
+  return stored;
+end;
+$$;
@@ -0,0 +1,58 @@
+-- insert_readings_if_changed() took the readings_ingest advisory lock and
+-- read the newest row for every batch, also with p_threshold < 0 (dedupe
+-- off), the path every board that compresses on the device uses. That
+-- serialised all fleet ingest behind one lock. With dedupe off there is
+-- nothing to compare, so the lock and the lookup are skipped and batches
+-- insert concurrently.
+--
+-- Dedupe still compares against the newest row of the whole table:
+-- readings has no device column and the dashboard shows it as a single
+-- stream. It is only meant for the older boards that upload every sample.
+
+create or replace function public.insert_readings_if_changed(
+  p_readings jsonb,
+  p_threshold double precision default 0.1
+)
+returns integer
+language plpgsql
+as $$
+declare
+  last_t double precision;
+  last_h double precision;
+  t double precision;
+  h double precision;
+  r jsonb;
+  stored integer := 0;
+begin
+  if p_threshold >= 0 then
+    -- Serialise concurrent ingests so two batches never compare
+    -- against the same "last" row
+    perform pg_advisory_xact_lock(hashtext('readings_ingest'));
+
+    select temperature, humidity
+      into last_t, last_h
+      from public.readings
+      order by recorded_at desc
+      limit 1;
+  end if;
+
+  for r in select value from jsonb_array_elements(p_readings) loop
+    t := (r->>'temperature')::double precision;
+    h := (r->>'humidity')::double precision;
+
+    if p_threshold < 0
+       or last_t is null
+       or abs(last_t - t) > p_threshold
+       or abs(last_h - h) > p_threshold then
+      -- clock_timestamp() keeps batch rows ordered (now() is per transaction)
+      insert into public.readings (temperature, humidity, recorded_at, device_recorded_at)
+        values (t, h, clock_timestamp(), (r->>'device_recorded_at')::timestamptz);
+      last_t := t;
+      last_h := h;
+      stored := stored + 1;
+    end if;
+  end loop;
+
+  return stored;
+end;
+$$;
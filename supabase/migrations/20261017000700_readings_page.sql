@@ -0,0 +1,62 @@
+-- Raw history pages for /api/history?limit=..&cursor=..: keyset on
+-- (recorded_at, id), newest first. recorded_at alone is not a key:
+-- insert_readings_if_changed stamps each row with clock_timestamp(), so
+-- the rows of a batch are only microseconds apart, and nothing stops two
+-- uploads (dedupe off takes no lock) from getting the same value. A
+-- cursor cut to milliseconds, as a JS Date does, landed inside a batch
+-- and skipped the rest of it. The cursor is the last row's full
+-- timestamp and id; a cursor without an id (older clients) pages on
+-- recorded_at alone.
+
+alter table public.readings
+  add column if not exists id bigint generated by default as identity;
+
+create index if not exists readings_recorded_at_id_idx
+  on public.readings (recorded_at desc, id desc);
+
+create or replace function public.readings_page(
+  p_from timestamptz,
+  p_to timestamptz,
+  p_before_at timestamptz,
+  p_before_id bigint,
+  p_limit integer
+)
+returns table (
+  id bigint,
+  recorded_at timestamptz,
+  device_recorded_at timestamptz,
+  temperature double precision,
+  humidity double precision
+)
+language plpgsql
+stable
+as $$
+begin
+  -- One static query per cursor shape so each is a plain range scan on
+  -- readings_recorded_at_id_idx
+  if p_before_at is null then
+    return query
+      select r.id, r.recorded_at, r.device_recorded_at, r.temperature::double precision, r.humidity::double precision
+      from public.readings r
+      where r.recorded_at >= coalesce(p_from, '-infinity') and r.recorded_at < coalesce(p_to, 'infinity')
+      order by r.recorded_at desc, r.id desc
+      limit p_limit;
+  elsif p_before_id is null then
+    return query
+      select r.id, r.recorded_at, r.device_recorded_at, r.temperature::double precision, r.humidity::double precision
+      from public.readings r
+      where r.recorded_at >= coalesce(p_from, '-infinity') and r.recorded_at < coalesce(p_to, 'infinity')
+        and r.recorded_at < p_before_at
+      order by r.recorded_at desc, r.id desc
+      limit p_limit;
+  else
+    return query
+      select r.id, r.recorded_at, r.device_recorded_at, r.temperature::double precision, r.humidity::double precision
+      from public.readings r
+      where r.recorded_at >= coalesce(p_from, '-infinity') and r.recorded_at < coalesce(p_to, 'infinity')
+        and (r.recorded_at, r.id) < (p_before_at, p_before_id)
+      order by r.recorded_at desc, r.id desc
+      limit p_limit;
+  end if;
+end;
+$$;
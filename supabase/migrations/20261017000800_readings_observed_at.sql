@@ -0,0 +1,104 @@
+-- History on the time a reading was taken: device_recorded_at when the
+-- board stamped it, recorded_at otherwise. Readings drained from a
+-- board's offline log reach the server minutes or hours after they were
+-- taken, so keyed on recorded_at they landed in the buckets and pages of
+-- their upload. observed_at is that coalesce, stored so it can be
+-- indexed; readings_page and readings_buckets now range-scan it.
+
+alter table public.readings
+  add column if not exists observed_at timestamptz
+    generated always as (coalesce(device_recorded_at, recorded_at)) stored;
+
+create index if not exists readings_observed_at_id_idx
+  on public.readings (observed_at desc, id desc);
+
+-- The cursor is now the last row's (observed_at, id); the result gains
+-- observed_at, so the function is replaced rather than redefined
+drop function if exists public.readings_page(timestamptz, timestamptz, timestamptz, bigint, integer);
+
+create function public.readings_page(
+  p_from timestamptz,
+  p_to timestamptz,
+  p_before_at timestamptz,
+  p_before_id bigint,
+  p_limit integer
+)
+returns table (
+  id bigint,
+  recorded_at timestamptz,
+  device_recorded_at timestamptz,
+  observed_at timestamptz,
+  temperature double precision,
+  humidity double precision
+)
+language plpgsql
+stable
+as $$
+begin
+  -- One static query per cursor shape so each is a plain range scan on
+  -- readings_observed_at_id_idx
+  if p_before_at is null then
+    return query
+      select r.id, r.recorded_at, r.device_recorded_at, r.observed_at,
+             r.temperature::double precision, r.humidity::double precision
+      from public.readings r
+      where r.observed_at >= coalesce(p_from, '-infinity') and r.observed_at < coalesce(p_to, 'infinity')
+      order by r.observed_at desc, r.id desc
+      limit p_limit;
+  elsif p_before_id is null then
+    return query
+      select r.id, r.recorded_at, r.device_recorded_at, r.observed_at,
+             r.temperature::double precision, r.humidity::double precision
+      from public.readings r
+      where r.observed_at >= coalesce(p_from, '-infinity') and r.observed_at < coalesce(p_to, 'infinity')
+        and r.observed_at < p_before_at
+      order by r.observed_at desc, r.id desc
+      limit p_limit;
+  else
+    return query
+      select r.id, r.recorded_at, r.device_recorded_at, r.observed_at,
+             r.temperature::double precision, r.humidity::double precision
+      from public.readings r
+      where r.observed_at >= coalesce(p_from, '-infinity') and r.observed_at < coalesce(p_to, 'infinity')
+        and (r.observed_at, r.id) < (p_before_at, p_before_id)
+      order by r.observed_at desc, r.id desc
+      limit p_limit;
+  end if;
+end;
+$$;
+
+-- Same result as 20261017000100_readings_buckets.sql, bucketed by
+-- observed_at
+create or replace function public.readings_buckets(
+  p_from timestamptz,
+  p_to timestamptz,
+  p_bucket_seconds integer
+)
+returns table (
+  bucket timestamptz,
+  samples bigint,
+  temperature_min double precision,
+  temperature_avg double precision,
+  temperature_max double precision,
+  humidity_min double precision,
+  humidity_avg double precision,
+  humidity_max double precision
+)
+language sql
+stable
+as $$
+  select
+    to_timestamp(floor(extract(epoch from observed_at) / p_bucket_seconds) * p_bucket_seconds) as bucket,
+    count(*) as samples,
+    min(temperature)::double precision,
+    avg(temperature)::double precision,
+    max(temperature)::double precision,
+    min(humidity)::double precision,
+    avg(humidity)::double precision,
+    max(humidity)::double precision
+  from public.readings
+  where observed_at >= p_from
+    and observed_at < p_to
+  group by 1
+  order by 1;
+$$;
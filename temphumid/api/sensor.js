@@ -1,67 +1,124 @@
-// /api/sensor.js
-const { createClient } = require('@supabase/supabase-js');
-
-module.exports = async (req, res) => {
-  if (req.method !== 'POST') {
-    return res.status(405).json({ error: 'Only POST allowed' });
-  }
-
-  let data;
-  try {
-    data = JSON.parse(req.body);
-  } catch (e) {
-    return res.status(400).json({ error: 'Invalid JSON' });
-  }
-
-  const { temperature, humidity } = data;
-
-  if (typeof temperature !== 'number' || typeof humidity !== 'number') {
-    return res.status(400).json({ error: 'temperature and humidity must be numbers' });
-  }
-
-  const supabase = createClient(
-    'https://uappuwebcylzwndfaqxo.supabase.co',
-    process.env.SUPABASE_KEY
-  );
-
-  if (!process.env.SUPABASE_KEY) {
-    console.error('❌ SUPABASE_KEY is missing');
-    return res.status(500).json({ error: 'Server misconfiguration' });
-  }
-
-  try {
-    // Fetch last reading using recorded_at
-    const { data: lastReadings, error: fetchErr } = await supabase
-      .from('readings')
-      .select('temperature, humidity')
-      .order('recorded_at', { ascending: false })
-      .limit(1);
-
-    if (fetchErr) {
-      console.error('Supabase fetch error:', fetchErr.message);
-      return res.status(500).json({ error: 'Database fetch failed' });
-    }
-
-    const last = lastReadings?.[0];
-    const hasChanged = !last ||
-      Math.abs(parseFloat(last.temperature) - temperature) > 0.1 ||
-      Math.abs(parseFloat(last.humidity) - humidity) > 0.1;
-
-    if (hasChanged) {
-      const { error: insertErr } = await supabase
-        .from('readings')
-        .insert([{ temperature, humidity }]); // recorded_at auto-filled by now()
-
-      if (insertErr) {
-        console.error('Supabase insert error:', insertErr.message);
-        return res.status(500).json({ error: 'Database insert failed' });
-      }
-    }
-
-    res.status(200).json({ success: true });
-  } catch (err) {
-    console.error('Unexpected error:', err.message);
-    res.status(500).json({ error: 'Internal server error' });
-  }
-};
-
+// /api/sensor.js
+const { createClient } = require('@supabase/supabase-js');
+
+// Upper bound on readings accepted in one batched upload
+const MAX_BATCH = 100;
+
+// Device timestamps outside this window are ignored (clock never synced,
+// or badly off); those readings get the server's time only
+const MIN_DEVICE_TIME = Date.UTC(2024, 0, 1);
+const MAX_DEVICE_CLOCK_AHEAD_MS = 5 * 60 * 1000;
+
+// Vercel hands JSON bodies over parsed; a plain server leaves the stream
+function readBody(req) {
+  if (req.body !== undefined) {
+    return Promise.resolve(typeof req.body === 'string' ? JSON.parse(req.body) : req.body);
+  }
+  return new Promise((resolve, reject) => {
+    const chunks = [];
+    req.on('data', chunk => chunks.push(chunk));
+    req.on('end', () => {
+      try {
+        resolve(JSON.parse(Buffer.concat(chunks).toString('utf8')));
+      } catch (e) {
+        reject(e);
+      }
+    });
+    req.on('error', reject);
+  });
+}
+
+// The board sends {"readings":[{"temp":..,"humid":..,"dt":..}],"base":..}
+// (lib/ClimateCore/src/json_codec.h): dt counts from the previous stamped
+// reading, the first from base. A single {"temp":..,"humid":..} or
+// {"temperature":..,"humidity":..} reading is still accepted.
+function normalizeReadings(data) {
+  const batch = data && Array.isArray(data.readings) ? data.readings : [data];
+  let previous = data && typeof data.base === 'number' ? data.base : undefined;
+  return batch.map((r) => {
+    if (!r) return r;
+    let deviceTime;
+    if (previous !== undefined && typeof r.dt === 'number') {
+      previous += r.dt;
+      deviceTime = previous;
+    }
+    return {
+      temperature: r.temperature ?? r.temp,
+      humidity: r.humidity ?? r.humid,
+      deviceTime,
+    };
+  });
+}
+
+// ISO capture time, or null when the device did not stamp the reading
+function deviceRecordedAt(deviceTime, now) {
+  if (!Number.isFinite(deviceTime)) return null;
+  if (deviceTime < MIN_DEVICE_TIME || deviceTime > now + MAX_DEVICE_CLOCK_AHEAD_MS) return null;
+  return new Date(deviceTime).toISOString();
+}
+
+module.exports = async (req, res) => {
+  if (req.method !== 'POST') {
+    return res.status(405).json({ error: 'Only POST allowed' });
+  }
+
+  let data;
+  try {
+    data = await readBody(req);
+  } catch (e) {
+    return res.status(400).json({ error: 'Invalid JSON' });
+  }
+
+  const readings = normalizeReadings(data);
+
+  if (readings.length === 0 || readings.length > MAX_BATCH) {
+    return res.status(400).json({ error: `Expected 1-${MAX_BATCH} readings` });
+  }
+
+  const valid = readings.every(r =>
+    r && typeof r.temperature === 'number' && typeof r.humidity === 'number'
+  );
+  if (!valid) {
+    return res.status(400).json({ error: 'temperature and humidity must be numbers' });
+  }
+
+  if (!process.env.SUPABASE_KEY) {
+    console.error('❌ SUPABASE_KEY is missing');
+    return res.status(500).json({ error: 'Server misconfiguration' });
+  }
+
+  const supabase = createClient(
+    'https://uappuwebcylzwndfaqxo.supabase.co',
+    process.env.SUPABASE_KEY
+  );
+
+  // The board compresses on its own (swinging door) and sends
+  // ?dedupe=off; otherwise readings within 0.1 of the last are skipped
+  const threshold = req.query?.dedupe === 'off' ? -1 : 0.1;
+
+  try {
+    // Same readings table and RPC as the main app
+    // (supabase/migrations/*_insert_readings_if_changed.sql)
+    const now = Date.now();
+    const { data: stored, error } = await supabase.rpc('insert_readings_if_changed', {
+      p_readings: readings.map(({ temperature, humidity, deviceTime }) => ({
+        temperature,
+        humidity,
+        device_recorded_at: deviceRecordedAt(deviceTime, now),
+      })),
+      p_threshold: threshold,
+    });
+
+    if (error) {
+      console.error('Supabase insert error:', error.message);
+      // 503 keeps the batch on the board for a retry
+      res.setHeader('Retry-After', '5');
+      return res.status(503).json({ error: 'Database insert failed' });
+    }
+
+    res.status(200).json({ success: true, stored: stored ?? 0 });
+  } catch (err) {
+    console.error('Unexpected error:', err.message);
+    res.status(500).json({ error: 'Internal server error' });
+  }
+};
@@ -1,64 +1,32 @@
-#include <Arduino.h>
-#include <WiFi.h>
-#include <HTTPClient.h>
-#include <DHT.h>
-#include <ArduinoJson.h>
-
-#define DHT_PIN 38
-#define DHT_TYPE DHT22
-DHT dht(DHT_PIN, DHT_TYPE);
-
-const char* ssid = "YOUR_WIFI_SSID";
-const char* password = "YOUR_WIFI_PASSWORD";
-const char* serverUrl = "https://YOUR_VERCEL_APP.vercel.app/api/sensor";  // Replace with deployed URL
-
-float lastTemp = -999, lastHumid = -999;
-
-void setup() {
-    Serial.begin(115200);
-    dht.begin();
-    WiFi.begin(ssid, password);
-    while (WiFi.status() != WL_CONNECTED) {
-        delay(1000);
-        Serial.println("Connecting to WiFi...");
-    }
-    Serial.println("WiFi connected");
-}
-
-void loop() {
-    float temp = dht.readTemperature();
-    float humid = dht.readHumidity();
-    
-    if (isnan(temp) || isnan(humid)) {
-        Serial.println("Failed to read from DHT");
-        delay(2000);
-        return;
-    }
-    
-    // Send only if changed
-    if (abs(temp - lastTemp) >= 0.2 || abs(humid - lastHumid) >= 1) {
-        HTTPClient http;
-        http.begin(serverUrl);
-        http.addHeader("Content-Type", "application/json");
-        
-        DynamicJsonDocument doc(200);
-        doc["temp"] = temp;
-        doc["humid"] = humid;
-        String payload;
-        serializeJson(doc, payload);
-        
-        int httpCode = http.POST(payload);
-        if (httpCode == 200) {
-            Serial.printf("Sent: T=%.1f°C H=%.1f%%\n", temp, humid);
-            lastTemp = temp;
-            lastHumid = humid;
-        } else {
-            Serial.printf("HTTP error: %d\n", httpCode);
-        }
-        http.end();
-    } else {
-        Serial.println("No change, skipping");
-    }
-    
-    delay(10000);  // Read every 10s
-}
+#include <Arduino.h>
+
+#include "sensor_node.h"
+
+// Everything not listed here uses SensorNodeDefaults
+// (lib/ClimateNode/src/sensor_node.h)
+struct TempHumidProfile : SensorNodeDefaults {
+    static constexpr const char* wifiSsid() { return "YOUR_WIFI_SSID"; }
+    static constexpr const char* wifiPassword() { return "YOUR_WIFI_PASSWORD"; }
+    static constexpr const char* apiUrl() { return "https://YOUR_VERCEL_APP.vercel.app/api/sensor?dedupe=off"; }  // Replace with deployed URL
+
+    // This board's payload uses {"temp":..,"humid":..}
+    typedef ShortReadingKeys Keys;
+
+    // Read every 10s, no smoothing on top of that
+    static constexpr uint32_t SAMPLE_INTERVAL_MS = 10000;
+    static constexpr size_t FILTER_WINDOW = 1;
+    static constexpr float FILTER_ALPHA = 1.0f;
+    static constexpr float TEMPERATURE_ERROR_BOUND = 0.2f;
+    static constexpr float HUMIDITY_ERROR_BOUND = 1.0f;
+};
+
+SensorNode<TempHumidProfile> node;
+
+void setup() {
+    Serial.begin(115200);
+    node.begin();
+}
+
+void loop() {
+    node.run();
+}
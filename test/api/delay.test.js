@@ -0,0 +1,116 @@
+// test/api/delay.test.js
+// Long-poll and conditional GET of /api/delay over the stand-in
+// control_state store.
+const test = require('node:test');
+const assert = require('node:assert');
+const { useStandin, serve } = require('./serve');
+
+// api/delay.js binds its store when required, so the stand-in goes first
+const db = useStandin();
+const delay = require('../../api/delay');
+
+async function current(base) {
+  const res = await fetch(`${base}/api/delay`);
+  return { etag: res.headers.get('etag'), ...(await res.json()) };
+}
+
+function setDelay(base, value) {
+  return fetch(`${base}/api/delay`, {
+    method: 'POST',
+    headers: { 'Content-Type': 'application/json' },
+    body: JSON.stringify({ delay: value }),
+  });
+}
+
+test('a long-poll is answered as soon as the delay changes', async (t) => {
+  const api = await serve({ '/api/delay': delay }, db);
+  t.after(() => api.close());
+  const { etag } = await current(api.base);
+
+  const start = Date.now();
+  const poll = fetch(`${api.base}/api/delay?wait=5000`, { headers: { 'If-None-Match': etag } });
+  await new Promise(resolve => setTimeout(resolve, 200));
+  const changedAt = Date.now();
+  assert.strictEqual((await setDelay(api.base, 750)).status, 200);
+
+  const res = await poll;
+  const answeredAt = Date.now();
+  assert.strictEqual(res.status, 200);
+  assert.strictEqual((await res.json()).delay, 750);
+  assert.notStrictEqual(res.headers.get('etag'), etag);
+  assert.ok(changedAt - start >= 190, 'held until the change');
+  assert.ok(answeredAt - changedAt < 300, `answered ${answeredAt - changedAt} ms after the change`);
+});
+
+test('an unchanged long-poll ends with a bodyless 304 after wait', async (t) => {
+  const api = await serve({ '/api/delay': delay }, db);
+  t.after(() => api.close());
+  const { etag } = await current(api.base);
+
+  const start = Date.now();
+  const res = await fetch(`${api.base}/api/delay?wait=1500`, { headers: { 'If-None-Match': etag } });
+  const heldMs = Date.now() - start;
+  assert.strictEqual(res.status, 304);
+  assert.strictEqual(await res.text(), '');
+  assert.strictEqual(res.headers.get('etag'), etag);
+  assert.ok(heldMs >= 1400 && heldMs < 2500, `held ${heldMs} ms`);
+});
+
+test('a stale ETag or ?since= is answered at once', async (t) => {
+  const api = await serve({ '/api/delay': delay }, db);
+  t.after(() => api.close());
+  const state = await current(api.base);
+
+  let start = Date.now();
+  let res = await fetch(`${api.base}/api/delay?wait=5000`, { headers: { 'If-None-Match': '"0"' } });
+  assert.strictEqual(res.status, 200);
+  assert.strictEqual((await res.json()).delay, state.delay);
+  assert.ok(Date.now() - start < 500);
+
+  start = Date.now();
+  res = await fetch(`${api.base}/api/delay?wait=5000&since=${state.delay + 1}`);
+  assert.strictEqual(res.status, 200);
+  assert.ok(Date.now() - start < 500);
+});
+
+test('out-of-range delays and bad JSON are rejected', async (t) => {
+  const api = await serve({ '/api/delay': delay }, db);
+  t.after(() => api.close());
+
+  assert.strictEqual((await setDelay(api.base, 10)).status, 400);
+  assert.strictEqual((await setDelay(api.base, 5000)).status, 400);
+  const res = await fetch(`${api.base}/api/delay`, { method: 'POST', body: '{' });
+  assert.strictEqual(res.status, 400);
+});
+
+test('parked long-polls share one store read per recheck', async (t) => {
+  const api = await serve({ '/api/delay': delay }, db);
+  t.after(() => api.close());
+  const { etag } = await current(api.base);
+
+  const polls = Array.from({ length: 50 }, () =>
+    fetch(`${api.base}/api/delay?wait=2500`, { headers: { 'If-None-Match': etag } }));
+  // Once all are parked, only the shared recheck reads the store
+  await new Promise(resolve => setTimeout(resolve, 300));
+  const before = db.roundTrips['select control_state'];
+  const statuses = (await Promise.all(polls)).map(res => res.status);
+  assert.deepStrictEqual(new Set(statuses), new Set([304]));
+
+  // Two rechecks in the remaining ~2.2 s, not two per device
+  const reads = db.roundTrips['select control_state'] - before;
+  assert.ok(reads <= 3, `${reads} store reads for 50 parked long-polls`);
+});
+
+test('a failed store write is answered 503 with Retry-After', async (t) => {
+  const api = await serve({ '/api/delay': delay }, db);
+  const rpc = db.rpc;
+  db.rpc = () => Promise.resolve({ data: null, error: { message: 'stand-in: down' } });
+  t.after(() => {
+    db.rpc = rpc;
+    return api.close();
+  });
+
+  const res = await setDelay(api.base, 800);
+  assert.strictEqual(res.status, 503);
+  assert.ok(Number(res.headers.get('retry-after')) > 0);
+});
@@ -0,0 +1,145 @@
+// test/api/history.test.js
+// Raw history pages: the (observed_at, id) keyset returns every row once
+// and in order, also when a page ends inside an ingest batch whose rows
+// are microseconds apart (clock_timestamp()) and share a millisecond. Readings drained late from a board's offline log
+// are paged and bucketed at their device time, and are not the latest
+// reading. Plus cursor validation and bucketed ranges.
+const test = require('node:test');
+const assert = require('node:assert');
+const sensor = require('../../api/sensor');
+const history = require('../../api/history');
+const latest = require('../../api/latest');
+const { useReadingsBackend, createSupabaseBackend } = require('../../api/_lib/readings_cache');
+const { serve } = require('./serve');
+
+async function post(base, body) {
+  const res = await fetch(`${base}/api/sensor?dedupe=off`, {
+    method: 'POST',
+    headers: { 'Content-Type': 'application/json' },
+    body: JSON.stringify(body),
+  });
+  assert.strictEqual(res.status, 200);
+}
+
+async function ingest(base, batches, size) {
+  for (let b = 0; b < batches; b++) {
+    await post(base, { readings: Array.from({ length: size }, (_, i) => ({ temperature: b * size + i, humidity: 50 })) });
+  }
+}
+
+async function page(base, params) {
+  const res = await fetch(`${base}/api/history?${new URLSearchParams(params)}`);
+  return { status: res.status, body: await res.json() };
+}
+
+test('pages split inside a batch return every row once, newest first', async (t) => {
+  const api = await serve({ '/api/sensor': sensor, '/api/history': history });
+  t.after(() => api.close());
+
+  await ingest(api.base, 4, 10);
+  // Every row has its own recorded_at, but a batch's rows share a
+  // millisecond: a cursor cut to a JS Date would skip or repeat them
+  const recorded = api.db.readings.map(r => r.recorded_at);
+  assert.strictEqual(new Set(recorded).size, 40);
+  assert.ok(new Set(recorded.map(Date.parse)).size < 40);
+
+  const seen = [];
+  let cursor = null;
+  let pages = 0;
+  do {
+    const params = { limit: '3' };
+    if (cursor) params.cursor = cursor;
+    const { status, body } = await page(api.base, params);
+    assert.strictEqual(status, 200);
+    seen.push(...body.rows.map(r => r.temperature));
+    cursor = body.next_cursor;
+    pages++;
+  } while (cursor);
+
+  assert.deepStrictEqual(seen, Array.from({ length: 40 }, (_, i) => 39 - i));
+  assert.strictEqual(pages, 14);
+});
+
+test('readings drained late are paged and bucketed at their device time', async (t) => {
+  const api = await serve({ '/api/sensor': sensor, '/api/history': history });
+  t.after(() => api.close());
+
+  const hour = 3600000;
+  const now = Math.floor(Date.now() / hour) * hour;
+  // Live readings first, then a batch from the offline log taken two
+  // hours earlier, then one from a board without a clock
+  await post(api.base, { base: now + 1000, readings: [{ temperature: 21, humidity: 50, dt: 0 }, { temperature: 22, humidity: 50, dt: 2000 }] });
+  await post(api.base, { base: now - 2 * hour, readings: [{ temperature: 11, humidity: 50, dt: 0 }, { temperature: 12, humidity: 50, dt: 2000 }] });
+  await post(api.base, { readings: [{ temperature: 31, humidity: 50 }] });
+
+  const { body } = await page(api.base, { limit: '2' });
+  assert.deepStrictEqual(body.rows.map(r => r.temperature), [31, 22]);
+  const rest = await page(api.base, { limit: '10', cursor: body.next_cursor });
+  assert.deepStrictEqual(rest.body.rows.map(r => r.temperature), [21, 12, 11]);
+  assert.strictEqual(Date.parse(rest.body.rows[2].observed_at), now - 2 * hour);
+
+  const buckets = await page(api.base, {
+    from: new Date(now - 3 * hour).toISOString(),
+    to: new Date(now + hour).toISOString(),
+    resolution: '3600',
+  });
+  assert.deepStrictEqual(buckets.body.buckets.map(b => [b.bucket, b.samples]), [
+    [new Date(now - 2 * hour).toISOString(), 2],
+    [new Date(now).toISOString(), 3],
+  ]);
+});
+
+test('the latest reading and the recent rows are the newest taken, not the newest stored', async (t) => {
+  const api = await serve({ '/api/sensor': sensor, '/api/history': history, '/api/latest': latest });
+  useReadingsBackend(createSupabaseBackend(api.db));
+  t.after(() => api.close());
+
+  // A live reading, then two drained from the offline log an hour late
+  const now = Date.now();
+  await post(api.base, { readings: [{ temperature: 21, humidity: 50 }] });
+  await post(api.base, { base: now - 3600000, readings: [{ temperature: 11, humidity: 50, dt: 0 }, { temperature: 12, humidity: 50, dt: 2000 }] });
+
+  const newest = await (await fetch(`${api.base}/api/latest`)).json();
+  assert.strictEqual(newest.temperature, 21);
+  const recent = await (await fetch(`${api.base}/api/history`)).json();
+  assert.deepStrictEqual(recent.map(r => r.temperature), [21, 12, 11]);
+  assert.ok(recent.every(r => Number.isInteger(r.id)));
+});
+
+test('a bare timestamp cursor pages on observed_at alone', async (t) => {
+  const api = await serve({ '/api/sensor': sensor, '/api/history': history });
+  t.after(() => api.close());
+
+  await ingest(api.base, 1, 5);
+  const third = api.db.readings[2].recorded_at;
+  const { status, body } = await page(api.base, { cursor: third, limit: '10' });
+  assert.strictEqual(status, 200);
+  assert.deepStrictEqual(body.rows.map(r => r.temperature), [1, 0]);
+  assert.strictEqual(body.next_cursor, null);
+});
+
+test('malformed cursors are rejected', async (t) => {
+  const api = await serve({ '/api/history': history });
+  t.after(() => api.close());
+
+  for (const cursor of ['yesterday', '2026-10-17T12:00:00Z|abc', '2026-10-17T12:00:00Z|1|2', '2026-13-45T12:00:00Z']) {
+    assert.strictEqual((await page(api.base, { cursor })).status, 400, cursor);
+  }
+  const ok = await page(api.base, { cursor: '2026-10-17T12:00:00.123456+00:00|42' });
+  assert.strictEqual(ok.status, 200);
+});
+
+test('buckets summarise a time range', async (t) => {
+  const api = await serve({ '/api/sensor': sensor, '/api/history': history });
+  t.after(() => api.close());
+
+  await ingest(api.base, 2, 5);
+  const to = new Date(Date.now() + 60000).toISOString();
+  const from = new Date(Date.now() - 3600000).toISOString();
+  const { status, body } = await page(api.base, { from, to, resolution: '3600' });
+  assert.strictEqual(status, 200);
+  const samples = body.buckets.reduce((n, b) => n + b.samples, 0);
+  assert.strictEqual(samples, 10);
+  assert.strictEqual(Math.min(...body.buckets.map(b => b.temperature_min)), 0);
+  assert.strictEqual(Math.max(...body.buckets.map(b => b.temperature_max)), 9);
+});
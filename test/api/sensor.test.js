@@ -0,0 +1,75 @@
+// test/api/sensor.test.js
+// Batched ingest: one RPC per upload, order kept, legacy payloads
+// accepted, database failures answered with Retry-After.
+const test = require('node:test');
+const assert = require('node:assert');
+const sensor = require('../../api/sensor');
+const { useStandin, serve } = require('./serve');
+
+function post(base, body, query = '') {
+  return fetch(`${base}/api/sensor${query}`, {
+    method: 'POST',
+    headers: { 'Content-Type': 'application/json' },
+    body: typeof body === 'string' ? body : JSON.stringify(body),
+  });
+}
+
+test('a batch is stored in one round trip, oldest first', async (t) => {
+  const api = await serve({ '/api/sensor': sensor });
+  t.after(() => api.close());
+
+  const readings = Array.from({ length: 10 }, (_, i) => ({ temperature: 20 + i, humidity: 40 + i }));
+  const res = await post(api.base, { readings }, '?dedupe=off');
+  assert.strictEqual(res.status, 200);
+  assert.deepStrictEqual(await res.json(), { success: true, stored: 10 });
+
+  assert.strictEqual(api.db.roundTrips.insert_readings_if_changed, 1);
+  // The stand-in keeps rows newest first
+  assert.deepStrictEqual(api.db.readings.map(r => r.temperature).reverse(), readings.map(r => r.temperature));
+});
+
+test('server-side dedupe drops readings within 0.1 of the last stored one', async (t) => {
+  const api = await serve({ '/api/sensor': sensor });
+  t.after(() => api.close());
+
+  const readings = [
+    { temperature: 21.0, humidity: 45.0 },
+    { temperature: 21.05, humidity: 45.05 },
+    { temperature: 21.3, humidity: 45.0 },
+  ];
+  const res = await post(api.base, { readings });
+  assert.deepStrictEqual(await res.json(), { success: true, stored: 2 });
+});
+
+test('single readings and the short temp/humid keys are accepted', async (t) => {
+  const api = await serve({ '/api/sensor': sensor });
+  t.after(() => api.close());
+
+  assert.strictEqual((await post(api.base, { temperature: 21, humidity: 45 })).status, 200);
+  assert.strictEqual((await post(api.base, { temp: 25, humid: 50 })).status, 200);
+  assert.strictEqual((await post(api.base, [{ temp: 26, humid: 51 }, { temp: 27, humid: 52 }])).status, 200);
+  assert.deepStrictEqual(api.db.readings.map(r => r.temperature), [27, 26, 25, 21]);
+  assert.strictEqual(api.db.roundTrips.insert_readings_if_changed, 3);
+});
+
+test('invalid batches are rejected before the database', async (t) => {
+  const api = await serve({ '/api/sensor': sensor });
+  t.after(() => api.close());
+
+  const tooMany = Array.from({ length: 101 }, () => ({ temperature: 1, humidity: 1 }));
+  assert.strictEqual((await post(api.base, { readings: tooMany })).status, 400);
+  assert.strictEqual((await post(api.base, { readings: [] })).status, 400);
+  assert.strictEqual((await post(api.base, { readings: [{ temperature: '21', humidity: 45 }] })).status, 400);
+  assert.strictEqual((await post(api.base, 'not json')).status, 400);
+  assert.strictEqual((await post(api.base, '')).status, 400);
+  assert.strictEqual(api.db.roundTrips.insert_readings_if_changed, undefined);
+});
+
+test('a database failure asks the device to retry later', async (t) => {
+  const api = await serve({ '/api/sensor': sensor }, useStandin({ errorRate: 1 }));
+  t.after(() => api.close());
+
+  const res = await post(api.base, { readings: [{ temperature: 21, humidity: 45 }] });
+  assert.strictEqual(res.status, 503);
+  assert.strictEqual(res.headers.get('retry-after'), '30');
+});
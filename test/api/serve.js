@@ -0,0 +1,35 @@
+// test/api/serve.js
+// Serves api/ handlers on a local port over a fresh stand-in database
+// (tools/standin_supabase.js) for the node:test suites.
+const { useSupabaseClient } = require('../../api/_lib/supabase');
+const { createStandinSupabase } = require('../../tools/standin_supabase');
+const { vercelAdapter, listen } = require('../../tools/harness');
+
+// getSupabase() only hands out the client when a key is configured
+process.env.SUPABASE_KEY = process.env.SUPABASE_KEY || 'test';
+
+// Installs a fresh stand-in as the shared client. Handlers that bind the
+// client when they are required (api/delay.js) must be required after this.
+function useStandin(options = {}) {
+  const db = createStandinSupabase({ latencyMs: 0, jitterMs: 0, ...options });
+  useSupabaseClient(db);
+  return db;
+}
+
+async function serve(routes, db = useStandin()) {
+  const adapted = {};
+  for (const [path, handler] of Object.entries(routes)) adapted[path] = vercelAdapter(handler);
+  const server = await listen(adapted);
+  const base = `http://127.0.0.1:${server.address().port}`;
+
+  return {
+    db,
+    base,
+    close() {
+      server.closeAllConnections();
+      return new Promise(resolve => server.close(resolve));
+    },
+  };
+}
+
+module.exports = { useStandin, serve };
@@ -0,0 +1,126 @@
+// test/api/stream.test.js
+// Server-sent events: several dashboards streaming from one instance share
+// its Supabase client, so each stream must get its own realtime channel.
+// Event ids are (observed_at, id) cursors: a reconnect catches up from
+// the last one, and readings drained late neither lead nor move it back.
+const test = require('node:test');
+const assert = require('node:assert');
+const http = require('http');
+const stream = require('../../api/stream');
+const { serve } = require('./serve');
+
+// Opens /api/stream and collects the reading events it receives
+function open(base, headers = {}) {
+  return new Promise((resolve, reject) => {
+    const req = http.get(`${base}/api/stream`, { headers }, (res) => {
+      const client = { status: res.statusCode, readings: [], ids: [], close: () => req.destroy() };
+      let buffer = '';
+      res.setEncoding('utf8');
+      res.on('data', (chunk) => {
+        buffer += chunk;
+        let end;
+        while ((end = buffer.indexOf('\n\n')) >= 0) {
+          const event = buffer.slice(0, end);
+          buffer = buffer.slice(end + 2);
+          const lines = event.split('\n');
+          const data = lines.find(line => line.startsWith('data: '));
+          const id = lines.find(line => line.startsWith('id: '));
+          if (event.includes('event: reading') && data) {
+            client.readings.push(JSON.parse(data.slice(6)));
+            client.ids.push(id && id.slice(4));
+          }
+        }
+      });
+      res.on('error', () => {});
+      resolve(client);
+    });
+    req.on('error', reject);
+  });
+}
+
+async function until(condition, ms = 2000) {
+  const deadline = Date.now() + ms;
+  while (!condition()) {
+    if (Date.now() > deadline) throw new Error('timed out');
+    await new Promise(resolve => setTimeout(resolve, 5));
+  }
+}
+
+function insert(db, temperature, deviceTime) {
+  return db.rpc('insert_readings_if_changed', {
+    p_readings: [{ temperature, humidity: 45, device_recorded_at: deviceTime ? new Date(deviceTime).toISOString() : null }],
+    p_threshold: -1,
+  });
+}
+
+test('concurrent streams each get every insert, and closing one leaves the other', async (t) => {
+  const api = await serve({ '/api/stream': stream });
+  t.after(() => api.close());
+
+  const a = await open(api.base);
+  const b = await open(api.base);
+  assert.strictEqual(a.status, 200);
+  assert.strictEqual(b.status, 200);
+  await until(() => api.db.channels.size === 2);
+
+  await insert(api.db, 21.5);
+  await until(() => a.readings.length === 1 && b.readings.length === 1);
+  assert.strictEqual(b.readings[0].temperature, 21.5);
+
+  a.close();
+  await until(() => api.db.channels.size === 1);
+
+  await insert(api.db, 22.5);
+  await until(() => b.readings.length === 2);
+  assert.deepStrictEqual(b.readings.map(r => r.temperature), [21.5, 22.5]);
+  assert.strictEqual(a.readings.length, 1);
+  b.close();
+});
+
+test('the first event is the newest reading taken, not a late one from the offline log', async (t) => {
+  const api = await serve({ '/api/stream': stream });
+  t.after(() => api.close());
+
+  await insert(api.db, 21.5);
+  const live = api.db.readings[0];
+  await insert(api.db, 11.5, Date.now() - 3600000);
+
+  const a = await open(api.base);
+  await until(() => a.readings.length === 1);
+  assert.strictEqual(a.readings[0].temperature, 21.5);
+  assert.strictEqual(a.ids[0], `${live.recorded_at}|${live.id}`);
+
+  // Pushed live, but the event id stays on the newest reading taken
+  await until(() => api.db.channels.size === 1);
+  await insert(api.db, 12.5, Date.now() - 3500000);
+  await until(() => a.readings.length === 2);
+  assert.strictEqual(a.readings[1].temperature, 12.5);
+  assert.strictEqual(a.ids[1], a.ids[0]);
+  a.close();
+});
+
+test('a reconnect catches up from Last-Event-ID on (observed_at, id)', async (t) => {
+  const api = await serve({ '/api/stream': stream });
+  t.after(() => api.close());
+
+  await api.db.rpc('insert_readings_if_changed', {
+    p_readings: [20, 21, 22].map(temperature => ({ temperature, humidity: 45 })),
+    p_threshold: -1,
+  });
+  const [newest, middle] = api.db.readings;
+
+  const a = await open(api.base, { 'Last-Event-ID': `${middle.recorded_at}|${middle.id}` });
+  await until(() => a.readings.length === 1);
+  assert.strictEqual(a.readings[0].temperature, 22);
+  a.close();
+
+  // Taken before the cursor: history has it, the catch-up does not
+  await insert(api.db, 10, Date.now() - 3600000);
+  await insert(api.db, 23);
+  const b = await open(api.base, { 'Last-Event-ID': `${newest.recorded_at}|${newest.id}` });
+  await until(() => b.readings.length === 1);
+  await new Promise(resolve => setTimeout(resolve, 20));
+  assert.deepStrictEqual(b.readings.map(r => r.temperature), [23]);
+  assert.strictEqual(b.readings[0].id, api.db.readings[0].id);
+  b.close();
+});
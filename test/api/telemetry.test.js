@@ -0,0 +1,50 @@
+// test/api/telemetry.test.js
+// Telemetry reports: device ids and stage names are shown on the
+// dashboard, so anything but the plain names the firmware sends is
+// refused before it is stored.
+const test = require('node:test');
+const assert = require('node:assert');
+const telemetry = require('../../api/telemetry');
+const { serve } = require('./serve');
+
+const STAGE = { n: 12, p50: 900, p95: 1800, max: 4100, mean: 1010 };
+
+function report(base, body) {
+  return fetch(`${base}/api/telemetry`, {
+    method: 'POST',
+    headers: { 'Content-Type': 'application/json' },
+    body: JSON.stringify(body),
+  });
+}
+
+test('a firmware report is stored and listed per device', async (t) => {
+  const api = await serve({ '/api/telemetry': telemetry });
+  t.after(() => api.close());
+
+  const res = await report(api.base, { device: '0a1b2c3d', uptime_ms: 60000, stages: { dht_read: STAGE, tls_connect: STAGE } });
+  assert.strictEqual(res.status, 200);
+
+  const list = await (await fetch(`${api.base}/api/telemetry`)).json();
+  assert.strictEqual(list.length, 1);
+  assert.strictEqual(list[0].device_id, '0a1b2c3d');
+  assert.deepStrictEqual(Object.keys(list[0].stages), ['dht_read', 'tls_connect']);
+});
+
+test('markup in the device id or a stage name is rejected', async (t) => {
+  const api = await serve({ '/api/telemetry': telemetry });
+  t.after(() => api.close());
+
+  const bad = [
+    { device: '<img src=x onerror=alert(1)>', stages: { dht_read: STAGE } },
+    { device: '0a1b2c3d', stages: { '<script>alert(1)</script>': STAGE } },
+    { device: 'a'.repeat(33), stages: { dht_read: STAGE } },
+    { device: '', stages: { dht_read: STAGE } },
+    { device: '0a1b2c3d', stages: { 'Dht Read': STAGE } },
+    { device: '0a1b2c3d', stages: Object.fromEntries(Array.from({ length: 17 }, (_, i) => [`s${i}`, STAGE])) },
+    { device: '0a1b2c3d', stages: { dht_read: { ...STAGE, p95: '1800' } } },
+  ];
+  for (const body of bad) {
+    assert.strictEqual((await report(api.base, body)).status, 400, JSON.stringify(body).slice(0, 60));
+  }
+  assert.deepStrictEqual(await (await fetch(`${api.base}/api/telemetry`)).json(), []);
+});
@@ -0,0 +1,81 @@
+// test/api/temphumid_sensor.test.js
+// The temphumid deployment's own /api/sensor: the board's batched
+// short-key uploads are stored, not refused.
+const test = require('node:test');
+const assert = require('node:assert');
+const { useStandin, serve } = require('./serve');
+
+// temphumid/api builds its own client; hand it the stand-in instead
+let db;
+require.cache[require.resolve('@supabase/supabase-js')] = {
+  exports: { createClient: () => db },
+};
+const sensor = require('../../temphumid/api/sensor');
+
+function post(base, body, query = '') {
+  return fetch(`${base}/api/sensor${query}`, {
+    method: 'POST',
+    headers: { 'Content-Type': 'application/json' },
+    body: typeof body === 'string' ? body : JSON.stringify(body),
+  });
+}
+
+test('a short-key batch from the board is stored with its device times', async (t) => {
+  db = useStandin();
+  const api = await serve({ '/api/sensor': sensor }, db);
+  t.after(() => api.close());
+
+  const base = Date.now() - 60000;
+  const body = {
+    readings: [
+      { temp: 21.5, humid: 45, dt: 0 },
+      { temp: 21.9, humid: 46, dt: 10000 },
+      { temp: 22.4, humid: 47 },
+    ],
+    base,
+  };
+  const res = await post(api.base, body, '?dedupe=off');
+  assert.strictEqual(res.status, 200);
+  assert.deepStrictEqual(await res.json(), { success: true, stored: 3 });
+
+  const rows = db.readings.slice().reverse();
+  assert.deepStrictEqual(rows.map(r => r.temperature), [21.5, 21.9, 22.4]);
+  assert.deepStrictEqual(rows.map(r => r.device_recorded_at), [
+    new Date(base).toISOString(),
+    new Date(base + 10000).toISOString(),
+    null,
+  ]);
+});
+
+test('single readings in either key style are still accepted', async (t) => {
+  db = useStandin();
+  const api = await serve({ '/api/sensor': sensor }, db);
+  t.after(() => api.close());
+
+  assert.strictEqual((await post(api.base, { temp: 25, humid: 50 })).status, 200);
+  assert.strictEqual((await post(api.base, { temperature: 26, humidity: 51 })).status, 200);
+  // Within 0.1 of the last stored reading
+  assert.deepStrictEqual(await (await post(api.base, { temp: 26.05, humid: 51 })).json(), { success: true, stored: 0 });
+  assert.deepStrictEqual(db.readings.map(r => r.temperature), [26, 25]);
+});
+
+test('invalid bodies are refused before the database', async (t) => {
+  db = useStandin();
+  const api = await serve({ '/api/sensor': sensor }, db);
+  t.after(() => api.close());
+
+  assert.strictEqual((await post(api.base, '{not json')).status, 400);
+  assert.strictEqual((await post(api.base, { readings: [] })).status, 400);
+  assert.strictEqual((await post(api.base, { readings: [{ temp: 'x', humid: 1 }] })).status, 400);
+  assert.strictEqual(db.roundTrips.insert_readings_if_changed, undefined);
+});
+
+test('a database failure is answered with 503 and Retry-After', async (t) => {
+  db = useStandin({ errorRate: 1 });
+  const api = await serve({ '/api/sensor': sensor }, db);
+  t.after(() => api.close());
+
+  const res = await post(api.base, { readings: [{ temp: 21, humid: 45 }] });
+  assert.strictEqual(res.status, 503);
+  assert.strictEqual(res.headers.get('retry-after'), '5');
+});
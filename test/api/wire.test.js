@@ -0,0 +1,118 @@
+// test/api/wire.test.js
+// Binary upload format: decoding what the firmware encodes (GOLDEN is
+// checked byte for byte in MERGED/test/test_wire_format), round trips,
+// malformed payloads, and the size against the JSON batch.
+const test = require('node:test');
+const assert = require('node:assert');
+const { CONTENT_TYPE, decodeReadings, encodeReadings, isWireContentType } = require('../../api/_lib/wire');
+const sensor = require('../../api/sensor');
+const { serve } = require('./serve');
+
+const GOLDEN = Buffer.from(
+  '43430204040302010700000000 6c50c4a0010000 66 08ad 11 01 cdfe 0f27 a11f 9808a00f 00 a208aa0fe807'
+    .replace(/ /g, ''),
+  'hex',
+);
+
+const T0 = 1790000000000;
+
+function tenReadings() {
+  return Array.from({ length: 10 }, (_, i) => ({
+    temperature: +(21 + i * 0.13).toFixed(2),
+    humidity: +(45 - i * 0.27).toFixed(2),
+    deviceTime: T0 + i * 2000,
+  }));
+}
+
+test('decodes what the firmware encodes', () => {
+  const { deviceId, sequence, readings } = decodeReadings(GOLDEN);
+  assert.strictEqual(deviceId, 0x01020304);
+  assert.strictEqual(sequence, 7);
+  assert.deepStrictEqual(readings, [
+    { temperature: 21.5, humidity: 45.25, deviceTime: T0 },
+    { temperature: -3.07, humidity: 99.99, deviceTime: T0 + 2000 },
+    { temperature: 22, humidity: 40, deviceTime: null },
+    { temperature: 22.1, humidity: 40.1, deviceTime: T0 + 1500 },
+  ]);
+  assert.deepStrictEqual(encodeReadings(decodeReadings(GOLDEN)), GOLDEN);
+});
+
+test('round trips readings at 0.01 resolution', () => {
+  const readings = [];
+  for (let i = 0; i < 255; i++) {
+    readings.push({
+      temperature: Math.round((Math.sin(i) * 60) * 100) / 100,
+      humidity: Math.round((50 + Math.cos(i) * 50) * 100) / 100,
+      deviceTime: i % 7 === 3 ? null : T0 + i * 2000 + (i % 5) * 37,
+    });
+  }
+  const decoded = decodeReadings(encodeReadings({ deviceId: 42, sequence: 0xffffffff, readings }));
+  assert.strictEqual(decoded.deviceId, 42);
+  assert.strictEqual(decoded.sequence, 0xffffffff);
+  assert.deepStrictEqual(decoded.readings, readings);
+});
+
+test('version 1 payloads still decode', () => {
+  const v1 = Buffer.from('4343010109000000030000006608ad11', 'hex');
+  assert.deepStrictEqual(decodeReadings(v1), {
+    deviceId: 9,
+    sequence: 3,
+    readings: [{ temperature: 21.5, humidity: 45.25 }],
+  });
+});
+
+test('malformed payloads are rejected', () => {
+  assert.throws(() => decodeReadings(Buffer.from('4242020000000000', 'hex')), /Bad magic/);
+  assert.throws(() => decodeReadings(Buffer.concat([Buffer.from([0x43, 0x43, 9]), Buffer.alloc(17)])), /Unsupported version/);
+  assert.throws(() => decodeReadings(GOLDEN.subarray(0, 16)), /Truncated header/);
+  assert.throws(() => decodeReadings(GOLDEN.subarray(0, GOLDEN.length - 1)), /Truncated varint|Length/);
+  assert.throws(() => decodeReadings(Buffer.concat([GOLDEN, Buffer.from([0])])), /Length/);
+});
+
+test('content type matching ignores parameters', () => {
+  assert.ok(isWireContentType(CONTENT_TYPE));
+  assert.ok(isWireContentType(`${CONTENT_TYPE}; v=2`));
+  assert.ok(!isWireContentType('application/json'));
+  assert.ok(!isWireContentType(undefined));
+});
+
+test('a binary batch is a fraction of the JSON one', () => {
+  const readings = tenReadings();
+  const binary = encodeReadings({ deviceId: 1, sequence: 1, readings }).length;
+  // Same shape as encodeJsonBatch() in lib/ClimateCore/src/json_codec.h
+  let previous = T0;
+  const json = Buffer.byteLength(JSON.stringify({
+    readings: readings.map(({ temperature, humidity, deviceTime }) => {
+      const dt = deviceTime - previous;
+      previous = deviceTime;
+      return { temperature, humidity, dt };
+    }),
+    base: T0,
+  }));
+  console.log(`10 readings: binary ${binary} bytes, JSON ${json} bytes`);
+  assert.strictEqual(binary, 20 + 10 * 4 + 1 + 9 * 2);
+  assert.ok(binary * 5 < json);
+});
+
+test('api/sensor stores binary batches with device time', async (t) => {
+  const api = await serve({ '/api/sensor': sensor });
+  t.after(() => api.close());
+
+  const readings = tenReadings().map(r => ({ ...r, deviceTime: Date.now() - 60000 + r.deviceTime - T0 }));
+  const res = await fetch(`${api.base}/api/sensor?dedupe=off`, {
+    method: 'POST',
+    headers: { 'Content-Type': CONTENT_TYPE },
+    body: encodeReadings({ deviceId: 1, sequence: 1, readings }),
+  });
+  assert.strictEqual(res.status, 200);
+  const stored = api.db.readings.slice().reverse();
+  assert.deepStrictEqual(stored.map(r => r.temperature), readings.map(r => r.temperature));
+  assert.deepStrictEqual(stored.map(r => Date.parse(r.device_recorded_at)), readings.map(r => r.deviceTime));
+
+  const bad = await fetch(`${api.base}/api/sensor`, {
+    method: 'POST',
+    headers: { 'Content-Type': CONTENT_TYPE },
+    body: GOLDEN.subarray(0, 30),
+  });
+  assert.strictEqual(bad.status, 400);
+});
@@ -0,0 +1,158 @@
+// test/public/series.test.js
+// The dashboard's history store: readings are keyed by row id (several can
+// share a millisecond), placed at their device time, and evicted keys can
+// come back. The table holds a reader's rows in place as readings arrive.
+const test = require('node:test');
+const assert = require('node:assert');
+const { SeriesStore, VirtualTable } = require('../../public/series');
+
+function row(id, deviceMs, temperature, recordedMs = deviceMs) {
+  return {
+    id,
+    recorded_at: new Date(recordedMs).toISOString().replace('Z', '123+00:00'),
+    device_recorded_at: deviceMs === null ? null : new Date(deviceMs).toISOString(),
+    temperature,
+    humidity: 50,
+  };
+}
+
+const values = (store, key = 'temperature') => Array.from({ length: store.length }, (_, i) => store.value(key, i));
+const times = store => Array.from({ length: store.length }, (_, i) => store.time(i));
+
+test('rows of one batch in the same millisecond are all kept, repeats are not', () => {
+  const store = new SeriesStore(100);
+  const t = Date.UTC(2026, 9, 17, 12);
+  const batch = [row(1, null, 20, t), row(2, null, 21, t), row(3, null, 22, t)];
+  assert.strictEqual(store.pushRows(batch), 3);
+
+  // An incremental fetch from newestTime() returns the boundary rows again
+  assert.strictEqual(store.pushRows([...batch, row(4, null, 23, t)]), 1);
+  assert.deepStrictEqual(values(store), [20, 21, 22, 23]);
+});
+
+test('readings are plotted at their device time', () => {
+  const store = new SeriesStore(100);
+  const t = Date.UTC(2026, 9, 17, 12);
+  // Uploaded together, taken 2 s apart
+  store.pushRows([row(1, t - 4000, 20, t), row(2, t - 2000, 21, t), row(3, t, 22, t)]);
+  assert.deepStrictEqual(times(store), [t - 4000, t - 2000, t]);
+  assert.strictEqual(store.newestTime(), t);
+});
+
+test('a reading drained late is inserted at its time', () => {
+  const store = new SeriesStore(5);
+  const t = Date.UTC(2026, 9, 17, 12);
+  store.pushRows([row(1, t, 20), row(2, t + 2000, 21), row(3, t + 4000, 22)]);
+  const revision = store.revision;
+
+  assert.strictEqual(store.pushRows([row(9, t + 1000, 99, t + 60000)]), 1);
+  assert.deepStrictEqual(values(store), [20, 99, 21, 22]);
+  assert.notStrictEqual(store.revision, revision);
+
+  // Full: the oldest goes, and one older than everything kept is dropped
+  store.pushRows([row(4, t + 6000, 23), row(5, t + 3000, 98)]);
+  assert.deepStrictEqual(values(store), [99, 21, 98, 22, 23]);
+  assert.strictEqual(store.pushRows([row(6, t - 9000, 0)]), 0);
+  assert.strictEqual(store.length, 5);
+});
+
+test('evicted rows can be pushed again; resize keeps the keys', () => {
+  const store = new SeriesStore(3);
+  const t = Date.UTC(2026, 9, 17, 12);
+  store.pushRows([1, 2, 3, 4].map(n => row(n, t + n * 1000, n)));
+  assert.deepStrictEqual(values(store), [2, 3, 4]);
+  assert.strictEqual(store.seen.size, 3);
+
+  store.resize(10);
+  assert.strictEqual(store.pushRows([row(3, t + 3000, 3), row(4, t + 4000, 4)]), 0);
+  assert.strictEqual(store.pushRows([row(1, t + 1000, 1)]), 1);
+  assert.deepStrictEqual(values(store), [1, 2, 3, 4]);
+});
+
+test('a late drain is merged in one pass, in order, up to capacity', () => {
+  const store = new SeriesStore(6);
+  const t = Date.UTC(2026, 9, 17, 12);
+  store.pushRows([row(1, t, 1), row(2, t + 4000, 2), row(3, t + 8000, 3)]);
+  const revision = store.revision;
+
+  // Out of order and mixed with one new reading; 7 repeats 6
+  const drained = [row(5, t + 6000, 5), row(4, t + 2000, 4), row(8, t + 9000, 8),
+    row(6, t - 1000, 6), row(7, t + 4000, 7), row(7, t + 4000, 7)];
+  assert.strictEqual(store.pushRows(drained), 4);
+  assert.deepStrictEqual(values(store), [6, 1, 4, 2, 7, 5, 3, 8].slice(2));
+  assert.deepStrictEqual(times(store), [2000, 4000, 4000, 6000, 8000, 9000].map(d => t + d));
+  assert.strictEqual(store.revision, revision + 1);
+  assert.strictEqual(store.seen.size, 6);
+  assert.ok(!store.seen.has('#6') && !store.seen.has('#1'));
+});
+
+test('a large late drain does not move the stored readings once per row', () => {
+  const n = 50000;
+  const store = new SeriesStore(2 * n);
+  const t = Date.UTC(2026, 9, 17, 12);
+  store.pushRows(Array.from({ length: n }, (_, i) => row(i, t + i * 2000, 20)));
+  const late = Array.from({ length: n }, (_, i) => row(n + i, t + i * 2000 + 1000, 21));
+
+  const start = process.hrtime.bigint();
+  assert.strictEqual(store.pushRows(late), n);
+  const ms = Number(process.hrtime.bigint() - start) / 1e6;
+
+  const v = values(store);
+  assert.ok(v.every((x, i) => x === (i % 2 ? 21 : 20)));
+  // One row at a time this is n * n / 2 slot moves, seconds at this size
+  assert.ok(ms < 2000, `${ms} ms`);
+});
+
+// Just enough DOM for VirtualTable.render()
+function fakeTable(store, rows = 10, rowHeight = 40) {
+  const element = tag => ({
+    tagName: tag, style: {}, children: [], cells: [], textContent: '', parentNode: null,
+    appendChild(c) { this.children.push(c); c.parentNode = this; if (tag === 'tr') this.cells.push(c); return c; },
+    insertBefore(c) { return this.appendChild(c); },
+    addEventListener() {},
+    remove() { this.parentNode = null; },
+  });
+  global.document = { createElement: element };
+  global.requestAnimationFrame = () => 1;
+  const scroller = { scrollTop: 0, clientHeight: rows * rowHeight, addEventListener() {} };
+  const table = new VirtualTable({
+    scroller, body: element('tbody'), store, rowHeight, overscan: 0,
+    columns: [(s, i) => String(s.value('temperature', i))],
+  });
+  const render = () => { table.frame = 0; table.render(); };
+  const topRow = () => table.pool[0].cells[0].textContent;
+  return { table, scroller, render, topRow };
+}
+
+test('the table scrolls only for rows that land above the viewport', () => {
+  const store = new SeriesStore(1000);
+  const t = Date.UTC(2026, 9, 17, 12);
+  store.pushRows(Array.from({ length: 100 }, (_, i) => row(i, t + i * 2000, i)));
+  const { table, scroller, render, topRow } = fakeTable(store);
+  render();
+
+  // Scrolled to reading 49 (newest first: row 50)
+  scroller.scrollTop = 50 * 40;
+  render();
+  assert.strictEqual(topRow(), '49');
+
+  // Late readings well below the viewport: nothing moves
+  table.append(store.pushRows([row(200, t + 3000, -1), row(201, t + 5000, -2)]));
+  render();
+  assert.strictEqual(scroller.scrollTop, 50 * 40);
+  assert.strictEqual(topRow(), '49');
+
+  // A new reading and a late one above the viewport: two rows down
+  table.append(store.pushRows([row(202, t + 200 * 2000, 500), row(203, t + 80 * 2000 + 1000, -3)]));
+  render();
+  assert.strictEqual(scroller.scrollTop, 52 * 40);
+  assert.strictEqual(topRow(), '49');
+
+  // At the top, new readings come into view instead
+  scroller.scrollTop = 0;
+  render();
+  table.append(store.pushRows([row(204, t + 201 * 2000, 501)]));
+  render();
+  assert.strictEqual(scroller.scrollTop, 0);
+  assert.strictEqual(topRow(), '501');
+});
@@ -0,0 +1,217 @@
+// tools/bench_dashboard.js
+// Request rate per open dashboard, before and after the live stream: the
+// old client polled /api/latest every 2 s and /api/delay every 3 s; the
+// current one (public/app.js) holds an EventSource on /api/stream and
+// long-polls /api/delay?since=..&wait=8000. Both run against the real
+// handlers served locally over the stand-in database
+// (tools/standin_supabase.js).
+//
+//   node tools/bench_dashboard.js [--clients 50] [--seconds 60]
+//                                 [--change-every 15] [--db-latency 10]
+//
+// A device inserts a reading every 2 s and an operator posts a new delay
+// every --change-every seconds. Reports, per mode, requests per second
+// per client, database round trips per second, and how many readings
+// and delay changes each client saw (both modes should see them all).
+// /api/stream ends every 55 s and the client reconnects with
+// Last-Event-ID, so run for a minute or more to include reconnects.
+const http = require('http');
+const { useSupabaseClient } = require('../api/_lib/supabase');
+const { createStandinSupabase } = require('./standin_supabase');
+const { option, vercelAdapter, listen } = require('./harness');
+
+const CLIENTS = option('clients', 50);
+const SECONDS = option('seconds', 60);
+const CHANGE_EVERY_S = option('change-every', 15);
+const DB_LATENCY_MS = option('db-latency', 10);
+
+// public/app.js before and after api/stream
+const LATEST_POLL_MS = 2000;
+const DELAY_POLL_MS = 3000;
+const DELAY_LONG_POLL_WAIT = 8000;
+const STREAM_RETRY_MS = 1000;     // the stream's "retry:" field
+const INSERT_EVERY_MS = 2000;
+
+process.env.SUPABASE_KEY = process.env.SUPABASE_KEY || 'bench-dashboard';
+const db = createStandinSupabase({ latencyMs: DB_LATENCY_MS, jitterMs: DB_LATENCY_MS / 2 });
+useSupabaseClient(db);
+
+// delay.js builds its store at require time
+const delayHandler = require('../api/delay');
+const latestHandler = require('../api/latest');
+const streamHandler = require('../api/stream');
+
+const agent = new http.Agent({ keepAlive: true, maxSockets: Infinity });
+let port;
+
+function request({ method = 'GET', path, headers = {}, body }) {
+  return new Promise((resolve) => {
+    const req = http.request({ agent, host: '127.0.0.1', port, method, path, headers }, (res) => {
+      const chunks = [];
+      res.on('data', chunk => chunks.push(chunk));
+      res.on('end', () => resolve({ status: res.statusCode, headers: res.headers, body: Buffer.concat(chunks) }));
+    });
+    req.on('error', () => resolve({ status: 0 }));
+    if (body) req.write(body);
+    req.end();
+  });
+}
+
+const sleep = ms => new Promise(resolve => setTimeout(resolve, ms));
+
+// Old dashboard: two independent interval timers
+async function pollingClient(until, seen) {
+  let requests = 0;
+  const poll = async (path, everyMs, onBody) => {
+    while (Date.now() < until) {
+      const res = await request({ path });
+      requests++;
+      if (res.status === 200) onBody(JSON.parse(res.body));
+      await sleep(everyMs);
+    }
+  };
+  await Promise.all([
+    poll('/api/latest', LATEST_POLL_MS, latest => seen.readings.add(latest.recorded_at)),
+    poll('/api/delay', DELAY_POLL_MS, ({ delay }) => seen.delays.add(delay)),
+  ]);
+  return requests;
+}
+
+// One /api/stream response, until the server ends it or `until`; returns
+// the last event id
+function streamOnce(lastEventId, until, onReading) {
+  return new Promise((resolve) => {
+    let id = lastEventId;
+    const headers = lastEventId ? { 'Last-Event-ID': lastEventId } : {};
+    const req = http.get({ host: '127.0.0.1', port, path: '/api/stream', headers }, (res) => {
+      let buffer = '';
+      res.setEncoding('utf8');
+      res.on('data', (chunk) => {
+        buffer += chunk;
+        let end;
+        while ((end = buffer.indexOf('\n\n')) >= 0) {
+          const lines = buffer.slice(0, end).split('\n');
+          buffer = buffer.slice(end + 2);
+          const idLine = lines.find(line => line.startsWith('id: '));
+          const data = lines.find(line => line.startsWith('data: '));
+          if (idLine) id = idLine.slice(4);
+          if (data) onReading(JSON.parse(data.slice(6)));
+        }
+      });
+      res.on('end', () => resolve(id));
+      res.on('error', () => resolve(id));
+    });
+    req.on('error', () => resolve(id));
+    const timer = setTimeout(() => req.destroy(), Math.max(0, until - Date.now()));
+    req.on('close', () => clearTimeout(timer));
+  });
+}
+
+// Current dashboard: EventSource plus the delay long-poll
+async function streamingClient(until, seen) {
+  let requests = 0;
+  const stream = async () => {
+    let lastEventId;
+    while (Date.now() < until) {
+      requests++;
+      lastEventId = await streamOnce(lastEventId, until, row => seen.readings.add(row.id));
+      if (Date.now() < until) await sleep(STREAM_RETRY_MS);
+    }
+  };
+  const watchDelay = async () => {
+    let delay = 500;
+    while (Date.now() < until) {
+      const res = await request({ path: `/api/delay?since=${delay}&wait=${DELAY_LONG_POLL_WAIT}` });
+      requests++;
+      if (res.status !== 200) {
+        await sleep(DELAY_POLL_MS);
+        continue;
+      }
+      delay = JSON.parse(res.body).delay;
+      seen.delays.add(delay);
+    }
+  };
+  await Promise.all([stream(), watchDelay()]);
+  return requests;
+}
+
+async function runMode(mode, client) {
+  const until = Date.now() + SECONDS * 1000;
+  const before = { ...db.roundTrips };
+  const inserted = new Set();
+  const changes = new Set();
+
+  const writer = setInterval(async () => {
+    const { data } = await db.rpc('insert_readings_if_changed', {
+      p_readings: [{ temperature: 20 + Math.random(), humidity: 50 }],
+      p_threshold: -1,
+    });
+    if (data) inserted.add(db.readings[0].id);
+  }, INSERT_EVERY_MS);
+  let value = 500;
+  const operator = setInterval(async () => {
+    value = value >= 1900 ? 100 : value + 100;
+    const res = await request({
+      method: 'POST',
+      path: '/api/delay',
+      headers: { 'Content-Type': 'application/json' },
+      body: JSON.stringify({ delay: value }),
+    });
+    if (res.status === 200) changes.add(value);
+  }, CHANGE_EVERY_S * 1000);
+
+  const seen = [];
+  const clients = [];
+  for (let i = 0; i < CLIENTS; i++) {
+    const s = { readings: new Set(), delays: new Set() };
+    seen.push(s);
+    // Tabs are opened at different times
+    clients.push(sleep(Math.random() * LATEST_POLL_MS).then(() => client(until, s)));
+  }
+  const requests = (await Promise.all(clients)).reduce((a, b) => a + b, 0);
+  clearInterval(writer);
+  clearInterval(operator);
+
+  const roundTrips = Object.entries(db.roundTrips)
+    .filter(([op]) => op !== 'insert_readings_if_changed' && op !== 'set_delay')
+    .reduce((sum, [op, n]) => sum + n - (before[op] || 0), 0);
+  const mean = values => values.reduce((a, b) => a + b, 0) / values.length;
+
+  return {
+    mode,
+    requests_per_client_s: requests / CLIENTS / SECONDS,
+    db_reads_per_s: roundTrips / SECONDS,
+    readings_seen: mean(seen.map(s => s.readings.size)),
+    readings_inserted: inserted.size,
+    delays_seen: mean(seen.map(s => [...s.delays].filter(d => changes.has(d)).length)),
+    delay_changes: changes.size,
+  };
+}
+
+async function main() {
+  const server = await listen({
+    '/api/latest': vercelAdapter(latestHandler),
+    '/api/delay': vercelAdapter(delayHandler),
+    '/api/stream': vercelAdapter(streamHandler),
+  });
+  port = server.address().port;
+
+  console.log(`${CLIENTS} dashboards, ${SECONDS} s per mode, a reading every ${INSERT_EVERY_MS / 1000} s,`
+    + ` a delay change every ${CHANGE_EVERY_S} s, db ${DB_LATENCY_MS} ms\n`);
+  for (const [mode, client] of [['polling', pollingClient], ['stream', streamingClient]]) {
+    const r = await runMode(mode, client);
+    console.log(`${mode.padEnd(8)} requests/client/s ${r.requests_per_client_s.toFixed(3).padStart(6)}`
+      + `  db reads/s ${r.db_reads_per_s.toFixed(1).padStart(6)}`
+      + `  readings seen ${r.readings_seen.toFixed(1)}/${r.readings_inserted}`
+      + `  delay changes seen ${r.delays_seen.toFixed(1)}/${r.delay_changes}`);
+  }
+
+  agent.destroy();
+  server.closeAllConnections();
+  server.close();
+}
+
+main().catch((e) => {
+  console.error(e);
+  process.exit(1);
+});
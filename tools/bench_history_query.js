@@ -0,0 +1,142 @@
+// tools/bench_history_query.js
+// /api/history over a stand-in database seeded with --rows readings (one
+// every 2 s, uploaded in batches of 10 whose recorded_at are microseconds
+// apart, like the boards' uploads through insert_readings_if_changed). Times the real handler over local HTTP for raw pages at the
+// head and deep in the table, a cursor walk, and bucketed day/week/full
+// ranges, and reports latency and response size.
+//
+//   node tools/bench_history_query.js [--rows 1000000] [--repeat 50]
+//                                     [--db-latency 0] [--seed 1]
+//
+// The stand-in answers pages and buckets with a binary search on its
+// (observed_at, id)-ordered array, the way the indexes serve them, so the
+// numbers are handler and response cost plus --db-latency, not Postgres.
+const http = require('http');
+const { useSupabaseClient } = require('../api/_lib/supabase');
+const { createStandinSupabase, timestamptz } = require('./standin_supabase');
+const { option, vercelAdapter, listen, percentile, createRandom } = require('./harness');
+
+const ROWS = option('rows', 1000000);
+const REPEAT = option('repeat', 50);
+const DB_LATENCY_MS = option('db-latency', 0);
+const SEED = option('seed', 1);
+
+const SAMPLE_MS = 2000;
+const BATCH = 10;
+
+const random = createRandom(SEED);
+
+process.env.SUPABASE_KEY = process.env.SUPABASE_KEY || 'bench-history';
+const db = createStandinSupabase({ latencyMs: DB_LATENCY_MS, jitterMs: 0, random });
+useSupabaseClient(db);
+const history = require('../api/history');
+
+const agent = new http.Agent({ keepAlive: true });
+let port;
+
+function get(path) {
+  return new Promise((resolve, reject) => {
+    const start = process.hrtime.bigint();
+    http.get({ agent, host: '127.0.0.1', port, path }, (res) => {
+      const chunks = [];
+      res.on('data', chunk => chunks.push(chunk));
+      res.on('end', () => resolve({
+        status: res.statusCode,
+        ms: Number(process.hrtime.bigint() - start) / 1e6,
+        body: Buffer.concat(chunks),
+      }));
+    }).on('error', reject);
+  });
+}
+
+// Newest first, as the stand-in keeps them
+function seed() {
+  const endMs = Date.UTC(2026, 9, 17);
+  const startMs = endMs - ROWS * SAMPLE_MS;
+  const rows = db.readings;
+  rows.length = ROWS;
+  for (let i = 0; i < ROWS; i++) {
+    const deviceMs = startMs + i * SAMPLE_MS;
+    const batchEnd = startMs + (Math.floor(i / BATCH) * BATCH + BATCH - 1) * SAMPLE_MS;
+    const deviceRecordedAt = new Date(deviceMs).toISOString();
+    rows[ROWS - 1 - i] = {
+      id: db.nextId(),
+      recorded_at: timestamptz((batchEnd + 300) * 1000 + i % BATCH),
+      device_recorded_at: deviceRecordedAt,
+      observed_at: deviceRecordedAt,
+      temperature: +(21 + 2 * Math.sin(i / 4000) + (random() - 0.5) * 0.2).toFixed(2),
+      humidity: +(45 + 5 * Math.cos(i / 6000) + (random() - 0.5) * 0.4).toFixed(2),
+    };
+  }
+  return { startMs, endMs };
+}
+
+async function measure(name, pathFor) {
+  const times = [];
+  let bytes = 0;
+  let count = 0;
+  for (let k = 0; k < REPEAT; k++) {
+    const res = await get(pathFor(k));
+    if (res.status !== 200) throw new Error(`${name}: HTTP ${res.status} ${res.body}`);
+    times.push(res.ms);
+    bytes = res.body.length;
+    const body = JSON.parse(res.body);
+    count = (body.rows || body.buckets).length;
+  }
+  times.sort((a, b) => a - b);
+  console.log(`${name.padEnd(34)} p50 ${percentile(times, 50).toFixed(2).padStart(7)} ms`
+    + `  p99 ${percentile(times, 99).toFixed(2).padStart(7)} ms  ${String(count).padStart(5)} rows`
+    + `  ${(bytes / 1024).toFixed(1).padStart(7)} KiB`);
+}
+
+async function main() {
+  const seedStart = Date.now();
+  const { endMs } = seed();
+  console.log(`${ROWS} rows seeded in ${Date.now() - seedStart} ms, db latency ${DB_LATENCY_MS} ms, ${REPEAT} requests each\n`);
+
+  const server = await listen({ '/api/history': vercelAdapter(history) });
+  port = server.address().port;
+  // The stand-in sorts the seeded rows by observed_at on the first call
+  await get('/api/history?limit=1');
+
+  const cursorAt = (i) => {
+    const r = db.readings[i];
+    return encodeURIComponent(`${r.observed_at}|${r.id}`);
+  };
+  const range = (days, resolution) => {
+    const to = new Date(endMs).toISOString();
+    const from = new Date(endMs - days * 86400000).toISOString();
+    return `/api/history?from=${from}&to=${to}&resolution=${resolution}`;
+  };
+
+  await measure('newest page (limit 1000)', () => '/api/history?limit=1000');
+  await measure('deep page, random cursor', () =>
+    `/api/history?limit=1000&cursor=${cursorAt(Math.floor(random() * (ROWS - 1000)))}`);
+  await measure('day of raw rows, page 1', () =>
+    `/api/history?limit=1000&from=${new Date(endMs - 86400000 * 10).toISOString()}&to=${new Date(endMs - 86400000 * 9).toISOString()}`);
+
+  // A client walking back through 20 pages
+  const walk = [];
+  for (let k = 0; k < REPEAT; k++) {
+    let cursor = cursorAt(Math.floor(random() * (ROWS / 2)));
+    const start = process.hrtime.bigint();
+    for (let p = 0; p < 20; p++) {
+      const res = await get(`/api/history?limit=1000&cursor=${cursor}`);
+      cursor = encodeURIComponent(JSON.parse(res.body).next_cursor);
+    }
+    walk.push(Number(process.hrtime.bigint() - start) / 1e6);
+  }
+  walk.sort((a, b) => a - b);
+  console.log(`${'cursor walk, 20 pages of 1000'.padEnd(34)} p50 ${percentile(walk, 50).toFixed(2).padStart(7)} ms`
+    + `  p99 ${percentile(walk, 99).toFixed(2).padStart(7)} ms`);
+
+  await measure('buckets, 1 day auto', () => range(1, 'auto'));
+  await measure('buckets, 7 days auto', () => range(7, 'auto'));
+  await measure(`buckets, all ${Math.round(ROWS * SAMPLE_MS / 86400000)} days auto`,
+    () => range(ROWS * SAMPLE_MS / 86400000, 'auto'));
+
+  agent.destroy();
+  server.close();
+}
+
+main();
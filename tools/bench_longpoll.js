@@ -0,0 +1,142 @@
+// tools/bench_longpoll.js
+// Delay propagation: the old fixed 3 s poll of /api/delay against the
+// long-poll (If-None-Match + wait=8000), on the real api/delay.js handler
+// served locally over the stand-in database (tools/standin_supabase.js).
+//
+//   node tools/bench_longpoll.js [--devices 50] [--seconds 30]
+//                                [--change-every 10] [--db-latency 10] [--seed 1]
+//
+// An operator posts a new delay every --change-every seconds. Reports, per
+// mode, how long devices took to see each change (p50/p95/max), requests
+// per device per minute and database round trips per second.
+const http = require('http');
+const { useSupabaseClient } = require('../api/_lib/supabase');
+const { createStandinSupabase } = require('./standin_supabase');
+const { option, vercelAdapter, listen, percentile, createRandom } = require('./harness');
+
+const DEVICES = option('devices', 50);
+const SECONDS = option('seconds', 30);
+const CHANGE_EVERY_S = option('change-every', 10);
+const DB_LATENCY_MS = option('db-latency', 10);
+const SEED = option('seed', 1);
+
+// MERGED/src/main.cpp before and after the long-poll
+const POLL_INTERVAL = 3000;
+const DELAY_LONG_POLL_WAIT = 8000;
+
+const random = createRandom(SEED);
+
+process.env.SUPABASE_KEY = process.env.SUPABASE_KEY || 'bench-longpoll';
+const db = createStandinSupabase({ latencyMs: DB_LATENCY_MS, jitterMs: DB_LATENCY_MS / 2, random });
+useSupabaseClient(db);
+
+// delay.js builds its store at require time
+const delayHandler = require('../api/delay');
+
+const agent = new http.Agent({ keepAlive: true, maxSockets: Infinity });
+let port;
+
+function request({ method = 'GET', path, headers = {}, body }) {
+  return new Promise((resolve) => {
+    const req = http.request({ agent, host: '127.0.0.1', port, method, path, headers }, (res) => {
+      const chunks = [];
+      res.on('data', chunk => chunks.push(chunk));
+      res.on('end', () => resolve({ status: res.statusCode, headers: res.headers, body: Buffer.concat(chunks) }));
+    });
+    req.on('error', () => resolve({ status: 0 }));
+    if (body) req.write(body);
+    req.end();
+  });
+}
+
+const sleep = ms => new Promise(resolve => setTimeout(resolve, ms));
+
+async function runDevice(mode, until, onDelay) {
+  let etag;
+  // Devices boot at different times
+  await sleep(random() * POLL_INTERVAL);
+  let requests = 0;
+
+  while (Date.now() < until) {
+    const longPoll = mode === 'long-poll';
+    const res = await request({
+      path: longPoll ? `/api/delay?wait=${DELAY_LONG_POLL_WAIT}` : '/api/delay',
+      headers: longPoll && etag ? { 'If-None-Match': etag } : {},
+    });
+    requests++;
+    if (res.status === 200) {
+      etag = res.headers.etag;
+      onDelay(JSON.parse(res.body).delay);
+    }
+    if (!longPoll || res.status !== 200 && res.status !== 304) await sleep(POLL_INTERVAL);
+  }
+  return requests;
+}
+
+async function runMode(mode) {
+  const changedAt = new Map();
+  const latencies = [];
+  const until = Date.now() + SECONDS * 1000;
+  let value = 500;
+
+  const devices = [];
+  for (let i = 0; i < DEVICES; i++) {
+    let seen;
+    devices.push(runDevice(mode, until, (delay) => {
+      if (delay === seen) return;
+      seen = delay;
+      const at = changedAt.get(delay);
+      if (at !== undefined) latencies.push(Date.now() - at);
+    }));
+  }
+
+  const before = { ...db.roundTrips };
+  const start = Date.now();
+  await sleep(POLL_INTERVAL);
+  while (Date.now() + CHANGE_EVERY_S * 1000 < until) {
+    value = value >= 1900 ? 100 : value + 100;
+    const res = await request({
+      method: 'POST',
+      path: '/api/delay',
+      headers: { 'Content-Type': 'application/json' },
+      body: JSON.stringify({ delay: value }),
+    });
+    if (res.status === 200) changedAt.set(value, Date.now());
+    await sleep(CHANGE_EVERY_S * 1000);
+  }
+
+  const requests = (await Promise.all(devices)).reduce((a, b) => a + b, 0);
+  const elapsedS = (Date.now() - start) / 1000;
+  const roundTrips = Object.entries(db.roundTrips)
+    .reduce((sum, [op, n]) => sum + n - (before[op] || 0), 0);
+  latencies.sort((a, b) => a - b);
+
+  return {
+    mode,
+    changes: changedAt.size,
+    propagation_p50_ms: percentile(latencies, 50),
+    propagation_p95_ms: percentile(latencies, 95),
+    propagation_max_ms: latencies[latencies.length - 1],
+    requests_per_device_min: +(requests / DEVICES / (elapsedS / 60)).toFixed(1),
+    db_round_trips_per_s: +(roundTrips / elapsedS).toFixed(1),
+  };
+}
+
+async function main() {
+  const server = await listen({ '/api/delay': vercelAdapter(delayHandler) });
+  port = server.address().port;
+
+  console.log(`${DEVICES} devices, ${SECONDS} s per mode, a change every ${CHANGE_EVERY_S} s, db ${DB_LATENCY_MS} ms\n`);
+  for (const mode of ['poll 3 s', 'long-poll']) {
+    const r = await runMode(mode);
+    console.log(`${mode.padEnd(10)} propagation p50 ${String(r.propagation_p50_ms).padStart(5)} ms`
+      + `  p95 ${String(r.propagation_p95_ms).padStart(5)} ms  max ${String(r.propagation_max_ms).padStart(5)} ms`
+      + `  requests/device/min ${String(r.requests_per_device_min).padStart(5)}`
+      + `  db round trips/s ${r.db_round_trips_per_s}  (${r.changes} changes)`);
+  }
+
+  agent.destroy();
+  server.close();
+}
+
+main();
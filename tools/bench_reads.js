@@ -0,0 +1,94 @@
+// tools/bench_reads.js
+// Read-path benchmark against a local stand-in backend: serves /api/latest
+// and /api/history over HTTP twice, once with one backend query per request
+// (how the handlers worked before api/_lib/readings_cache.js) and once
+// through the real handlers and their shared cache, and reports latency
+// percentiles and backend query counts for each.
+//
+//   node tools/bench_reads.js [--clients 20] [--seconds 10] [--latency 40]
+//
+// --latency is the simulated database round trip in ms. A reading is
+// inserted every 2 s, like a device uploading; inserts bypass the cache
+// (as uploads landing on another instance would).
+const http = require('http');
+const { createMemoryBackend, useReadingsBackend } = require('../api/_lib/readings_cache');
+const { option, vercelAdapter, listen, percentile } = require('./harness');
+
+process.env.SUPABASE_KEY = process.env.SUPABASE_KEY || 'bench';   // handlers refuse to run without one
+
+const CLIENTS = option('clients', 20);
+const SECONDS = option('seconds', 10);
+const LATENCY_MS = option('latency', 40);
+const INSERT_EVERY_MS = 2000;
+const HISTORY_SHARE = 0.2;      // the rest of the requests go to /api/latest
+
+function get(agent, port, path, etag) {
+  return new Promise((resolve, reject) => {
+    const headers = etag ? { 'If-None-Match': etag } : {};
+    const req = http.get({ agent, host: '127.0.0.1', port, path, headers }, (res) => {
+      res.resume();
+      res.on('end', () => resolve({ status: res.statusCode, etag: res.headers.etag }));
+    });
+    req.on('error', reject);
+  });
+}
+
+async function load(port) {
+  const agent = new http.Agent({ keepAlive: true, maxSockets: CLIENTS });
+  const latencies = [];
+  const statuses = {};
+  const deadline = Date.now() + SECONDS * 1000;
+
+  async function client() {
+    const etags = {};
+    while (Date.now() < deadline) {
+      const path = Math.random() < HISTORY_SHARE ? '/api/history' : '/api/latest';
+      const start = process.hrtime.bigint();
+      const { status, etag } = await get(agent, port, path, etags[path]);
+      latencies.push(Number(process.hrtime.bigint() - start) / 1e6);
+      statuses[status] = (statuses[status] || 0) + 1;
+      if (etag) etags[path] = etag;
+    }
+  }
+
+  await Promise.all(Array.from({ length: CLIENTS }, client));
+  agent.destroy();
+  return { latencies: latencies.sort((a, b) => a - b), statuses };
+}
+
+async function run(label, backend, routes) {
+  for (let i = 0; i < 50; i++) backend.insert(20 + i / 100, 50);
+  const writer = setInterval(() => backend.insert(20 + Math.random(), 50), INSERT_EVERY_MS);
+
+  const server = await listen(routes);
+  const { latencies, statuses } = await load(server.address().port);
+  clearInterval(writer);
+  server.close();
+
+  console.log(`${label}`);
+  console.log(`  requests ${latencies.length} (${(latencies.length / SECONDS).toFixed(0)}/s), statuses ${JSON.stringify(statuses)}`);
+  console.log(`  latency p50 ${percentile(latencies, 50).toFixed(2)} ms, p95 ${percentile(latencies, 95).toFixed(2)} ms, max ${latencies[latencies.length - 1].toFixed(2)} ms`);
+  console.log(`  backend queries ${backend.queries} (${(backend.queries / SECONDS).toFixed(1)}/s)`);
+}
+
+async function main() {
+  console.log(`${CLIENTS} clients, ${SECONDS} s each, ${LATENCY_MS} ms backend latency\n`);
+
+  const direct = createMemoryBackend({ latencyMs: LATENCY_MS });
+  await run('Uncached (one query per request)', direct, {
+    '/api/latest': vercelAdapter(async (req, res) => res.json(await direct.latest())),
+    '/api/history': vercelAdapter(async (req, res) => res.json(await direct.recent(50))),
+  });
+
+  const cached = createMemoryBackend({ latencyMs: LATENCY_MS });
+  useReadingsBackend(cached);
+  await run('\nCached (api/latest.js, api/history.js)', cached, {
+    '/api/latest': vercelAdapter(require('../api/latest')),
+    '/api/history': vercelAdapter(require('../api/history')),
+  });
+}
+
+main().catch((e) => {
+  console.error(e);
+  process.exit(1);
+});
@@ -0,0 +1,399 @@
+// tools/fleet_load.js
+// Device-fleet load test for the ingest and control endpoints. Simulates
+// N MERGED boards against the real api/sensor.js and api/delay.js
+// handlers, served locally on top of a stand-in database
+// (tools/standin_supabase.js), and reports throughput, latency
+// percentiles, error rates and database round trips per reading.
+//
+//   node tools/fleet_load.js [--devices 1000] [--seconds 60] [--seed 1]
+//                            [--format binary|json] [--delay-changes 6]
+//                            [--db-latency 10] [--db-jitter 5]
+//                            [--db-errors 0] [--ramp 20] [--json]
+//
+// Each simulated device follows MERGED/src/main.cpp:
+// - samples every SENSOR_POLL_INTERVAL (2 s) with ±5% timer jitter;
+// - stamps each sample at capture with an SNTP-synced clock (a few ms off);
+// - keeps a reading once it moves more than 0.1 from the last kept one,
+//   or after MAX_SILENCE (an approximation of the swinging door);
+// - uploads BATCH_SIZE (10) kept readings, or the queue once the oldest
+//   is BATCH_MAX_AGE (20 s) old, to /api/sensor?dedupe=off;
+// - keeps one long-poll on /api/delay?since=..&wait=8000 with
+//   If-None-Match, and retries after DELAY_RETRY_INTERVAL (3 s) on errors.
+// Devices power up spread over --ramp seconds (a fleet that booted in the
+// same instant would upload in lockstep). An operator posts a new delay
+// --delay-changes times per minute; the time until each device sees it is
+// reported as propagation latency.
+//
+// Devices and server share one Node process: check the reported event
+// loop delay before blaming the handlers for a slow run.
+//
+// Use the same --seed before and after a backend change to compare runs.
+const http = require('http');
+const { monitorEventLoopDelay } = require('perf_hooks');
+const { useSupabaseClient } = require('../api/_lib/supabase');
+const { CONTENT_TYPE, encodeReadings } = require('../api/_lib/wire');
+const { createStandinSupabase } = require('./standin_supabase');
+const { option, flag, vercelAdapter, listen, percentile, createRandom } = require('./harness');
+
+const DEVICES = option('devices', 1000);
+const SECONDS = option('seconds', 60);
+const SEED = option('seed', 1);
+const FORMAT = option('format', 'binary');
+const DELAY_CHANGES_PER_MIN = option('delay-changes', 6);
+const DB_LATENCY_MS = option('db-latency', 10);
+const DB_JITTER_MS = option('db-jitter', 5);
+const DB_ERROR_RATE = option('db-errors', 0);
+const RAMP_SECONDS = option('ramp', 20);
+const JSON_OUTPUT = flag('json');
+
+// MERGED/src/main.cpp
+const SENSOR_POLL_INTERVAL = 2000;
+const TIMER_JITTER = 0.05;
+const ERROR_BOUND = 0.1;
+const MAX_SILENCE = 300000;
+const BATCH_SIZE = 10;
+const BATCH_MAX_AGE = 20000;
+const BATCH_CAPACITY = 60;
+const DELAY_LONG_POLL_WAIT = 8000;
+const DELAY_RETRY_INTERVAL = 3000;
+const MIN_DELAY = 50;
+const MAX_DELAY = 2000;
+
+const random = createRandom(SEED);
+
+process.env.SUPABASE_KEY = process.env.SUPABASE_KEY || 'fleet-load';
+const db = createStandinSupabase({
+  latencyMs: DB_LATENCY_MS,
+  jitterMs: DB_JITTER_MS,
+  errorRate: DB_ERROR_RATE,
+  random,
+});
+useSupabaseClient(db);
+
+// Handlers are loaded after the stand-in is installed (delay.js builds its
+// store at require time)
+const sensorHandler = require('../api/sensor');
+const delayHandler = require('../api/delay');
+
+function createEndpointStats() {
+  return { latencies: [], statuses: {}, networkErrors: 0 };
+}
+
+const stats = {
+  sensor: createEndpointStats(),
+  delayPoll: createEndpointStats(),
+  delaySet: createEndpointStats(),
+  sampled: 0,
+  kept: 0,
+  uploaded: 0,
+  dropped: 0,
+  propagation: [],
+};
+
+let stopping = false;
+let agent;
+let port;
+
+function request(endpoint, { method, path, headers, body }) {
+  const start = process.hrtime.bigint();
+  return new Promise((resolve) => {
+    const req = http.request({ agent, host: '127.0.0.1', port, method, path, headers }, (res) => {
+      const chunks = [];
+      res.on('data', chunk => chunks.push(chunk));
+      res.on('end', () => {
+        if (!stopping) {
+          endpoint.latencies.push(Number(process.hrtime.bigint() - start) / 1e6);
+          endpoint.statuses[res.statusCode] = (endpoint.statuses[res.statusCode] || 0) + 1;
+        }
+        resolve({ status: res.statusCode, headers: res.headers, body: Buffer.concat(chunks) });
+      });
+    });
+    req.on('error', () => {
+      if (!stopping) endpoint.networkErrors++;
+      resolve({ status: 0 });
+    });
+    if (body) req.write(body);
+    req.end();
+  });
+}
+
+function jittered(ms) {
+  return ms * (1 + (random() * 2 - 1) * TIMER_JITTER);
+}
+
+// Set times of every delay value the operator posted, for propagation
+const delaySetAt = new Map();
+
+// Same shape as encodeJsonBatch() in lib/ClimateCore/src/json_codec.h
+function jsonBatch(readings) {
+  const base = readings[0].deviceTime;
+  let previous = base;
+  return {
+    base,
+    readings: readings.map(({ temperature, humidity, deviceTime }) => {
+      const dt = deviceTime - previous;
+      previous = deviceTime;
+      return { temperature, humidity, dt };
+    }),
+  };
+}
+
+class Device {
+  constructor(id) {
+    this.id = id;
+    this.temperature = 18 + random() * 10;
+    this.humidity = 35 + random() * 30;
+    this.lastKept = null;
+    this.lastKeptAt = 0;
+    this.queue = [];            // { temperature, humidity, at }
+    this.sequence = 0;
+    this.uploading = false;
+    this.delay = 500;
+    this.etag = null;
+    this.syncedAt = Infinity;   // first delay response; later changes count as propagation
+    this.clockErrorMs = (random() - 0.5) * 20;
+  }
+
+  start() {
+    const bootAt = random() * RAMP_SECONDS * 1000;
+    setTimeout(() => this.sample(), bootAt + random() * SENSOR_POLL_INTERVAL);
+    setTimeout(() => this.watchDelay(), bootAt + random() * 1000);
+  }
+
+  // Slow random walk with the occasional step (a door opening, heating on)
+  sample() {
+    if (stopping) return;
+    const now = Date.now();
+    this.temperature += (random() - 0.5) * 0.06 + (random() < 0.005 ? (random() - 0.5) * 2 : 0);
+    this.humidity += (random() - 0.5) * 0.1 + (random() < 0.005 ? (random() - 0.5) * 6 : 0);
+    stats.sampled++;
+
+    const moved = !this.lastKept
+      || Math.abs(this.temperature - this.lastKept.temperature) > ERROR_BOUND
+      || Math.abs(this.humidity - this.lastKept.humidity) > ERROR_BOUND;
+    if (moved || now - this.lastKeptAt >= MAX_SILENCE) {
+      this.lastKept = { temperature: this.temperature, humidity: this.humidity };
+      this.lastKeptAt = now;
+      this.queue.push({ temperature: this.temperature, humidity: this.humidity, at: now });
+      stats.kept++;
+      if (this.queue.length > BATCH_CAPACITY) {
+        this.queue.shift();
+        stats.dropped++;
+      }
+    }
+
+    if (this.queue.length >= BATCH_SIZE || (this.queue.length > 0 && now - this.queue[0].at >= BATCH_MAX_AGE)) {
+      this.flush();
+    }
+    setTimeout(() => this.sample(), jittered(SENSOR_POLL_INTERVAL));
+  }
+
+  async flush() {
+    if (this.uploading) return;
+    this.uploading = true;
+
+    const batch = this.queue.slice(0, BATCH_SIZE);
+    const readings = batch.map(r => ({
+      temperature: Math.round(r.temperature * 100) / 100,
+      humidity: Math.round(r.humidity * 100) / 100,
+      deviceTime: Math.round(r.at + this.clockErrorMs),
+    }));
+    const body = FORMAT === 'json'
+      ? Buffer.from(JSON.stringify(jsonBatch(readings)))
+      : encodeReadings({ deviceId: this.id, sequence: this.sequence, readings });
+    const contentType = FORMAT === 'json' ? 'application/json' : CONTENT_TYPE;
+
+    const { status } = await request(stats.sensor, {
+      method: 'POST',
+      path: '/api/sensor?dedupe=off',
+      headers: { 'Content-Type': contentType, 'Content-Length': body.length },
+      body,
+    });
+
+    // Failed batches stay queued and go out with the next flush
+    if (status === 200 || status === 201) {
+      this.queue.splice(0, batch.length);
+      this.sequence++;
+      if (!stopping) stats.uploaded += batch.length;
+    }
+    this.uploading = false;
+  }
+
+  async watchDelay() {
+    while (!stopping) {
+      const headers = this.etag ? { 'If-None-Match': this.etag } : {};
+      const { status, headers: resHeaders, body } = await request(stats.delayPoll, {
+        method: 'GET',
+        path: `/api/delay?since=${this.delay}&wait=${DELAY_LONG_POLL_WAIT}`,
+        headers,
+      });
+
+      if (status === 200) {
+        const { delay } = JSON.parse(body);
+        const setAt = delaySetAt.get(delay);
+        if (delay !== this.delay && setAt >= this.syncedAt && !stopping) {
+          stats.propagation.push(Date.now() - setAt);
+        }
+        this.delay = delay;
+        if (this.syncedAt === Infinity) this.syncedAt = Date.now();
+        this.etag = resHeaders.etag || null;
+      } else if (status === 304) {
+        if (this.syncedAt === Infinity) this.syncedAt = Date.now();
+      } else {
+        await new Promise(resolve => setTimeout(resolve, DELAY_RETRY_INTERVAL));
+      }
+    }
+  }
+}
+
+async function operator() {
+  if (DELAY_CHANGES_PER_MIN <= 0) return;
+  const every = 60000 / DELAY_CHANGES_PER_MIN;
+  while (!stopping) {
+    await new Promise(resolve => setTimeout(resolve, every));
+    if (stopping) return;
+
+    // Fresh values only, so propagation is attributed to one POST
+    let delay;
+    do {
+      delay = MIN_DELAY + Math.floor(random() * (MAX_DELAY - MIN_DELAY + 1));
+    } while (delaySetAt.has(delay));
+    delaySetAt.set(delay, Date.now());
+
+    const body = JSON.stringify({ delay });
+    await request(stats.delaySet, {
+      method: 'POST',
+      path: '/api/delay',
+      headers: { 'Content-Type': 'application/json', 'Content-Length': Buffer.byteLength(body) },
+      body,
+    });
+  }
+}
+
+function summarize(endpoint) {
+  const sorted = endpoint.latencies.slice().sort((a, b) => a - b);
+  const total = sorted.length + endpoint.networkErrors;
+  const failures = endpoint.networkErrors + Object.entries(endpoint.statuses)
+    .filter(([status]) => Number(status) >= 400)
+    .reduce((sum, [, n]) => sum + n, 0);
+  return {
+    requests: total,
+    perSecond: total / SECONDS,
+    p50Ms: percentile(sorted, 50),
+    p99Ms: percentile(sorted, 99),
+    maxMs: sorted.length ? sorted[sorted.length - 1] : NaN,
+    errorRate: total ? failures / total : 0,
+    statuses: endpoint.statuses,
+    networkErrors: endpoint.networkErrors,
+  };
+}
+
+function report(loopDelay) {
+  const ingestTrips = db.roundTrips.insert_readings_if_changed || 0;
+  const controlTrips = (db.roundTrips['select control_state'] || 0) + (db.roundTrips.set_delay || 0);
+  const propagation = stats.propagation.slice().sort((a, b) => a - b);
+  // How far server time (recorded_at) lags the capture time on the device
+  const storeLag = db.readings
+    .filter(r => r.device_recorded_at)
+    .map(r => Date.parse(r.recorded_at) - Date.parse(r.device_recorded_at))
+    .sort((a, b) => a - b);
+
+  const result = {
+    config: {
+      devices: DEVICES, seconds: SECONDS, seed: SEED, format: FORMAT, rampSeconds: RAMP_SECONDS,
+      delayChangesPerMin: DELAY_CHANGES_PER_MIN, dbLatencyMs: DB_LATENCY_MS,
+      dbJitterMs: DB_JITTER_MS, dbErrorRate: DB_ERROR_RATE,
+    },
+    readings: {
+      sampled: stats.sampled,
+      kept: stats.kept,
+      uploaded: stats.uploaded,
+      stored: db.readings.length,
+      droppedOnDevice: stats.dropped,
+      uploadedPerSecond: stats.uploaded / SECONDS,
+    },
+    sensor: summarize(stats.sensor),
+    delayPoll: summarize(stats.delayPoll),
+    delaySet: summarize(stats.delaySet),
+    captureToStore: {
+      readings: storeLag.length,
+      p50Ms: percentile(storeLag, 50),
+      p99Ms: percentile(storeLag, 99),
+    },
+    delayPropagation: {
+      observations: propagation.length,
+      p50Ms: percentile(propagation, 50),
+      p99Ms: percentile(propagation, 99),
+    },
+    eventLoopDelay: {
+      p50Ms: loopDelay.percentile(50) / 1e6,
+      p99Ms: loopDelay.percentile(99) / 1e6,
+    },
+    db: {
+      roundTrips: db.roundTrips,
+      ingestRoundTripsPerReading: stats.uploaded ? ingestTrips / stats.uploaded : NaN,
+      controlRoundTripsPerSecond: controlTrips / SECONDS,
+    },
+  };
+
+  if (JSON_OUTPUT) {
+    console.log(JSON.stringify(result, null, 2));
+    return;
+  }
+
+  const ms = v => (Number.isFinite(v) ? `${v.toFixed(1)} ms` : '-');
+  const line = (name, s) => console.log(
+    `  ${name.padEnd(12)} ${String(s.requests).padStart(7)} req  ${s.perSecond.toFixed(1).padStart(7)}/s` +
+    `  p50 ${ms(s.p50Ms).padStart(9)}  p99 ${ms(s.p99Ms).padStart(9)}` +
+    `  errors ${(s.errorRate * 100).toFixed(2)}%  ${JSON.stringify(s.statuses)}`);
+
+  const r = result.readings;
+  console.log(`${DEVICES} devices, ${SECONDS} s, seed ${SEED}, ${FORMAT} uploads, ` +
+              `db ${DB_LATENCY_MS}+${DB_JITTER_MS} ms, db errors ${DB_ERROR_RATE}`);
+  console.log(`Readings: ${r.sampled} sampled, ${r.kept} kept, ${r.uploaded} uploaded ` +
+              `(${r.uploadedPerSecond.toFixed(1)}/s), ${r.stored} stored, ${r.droppedOnDevice} dropped on device`);
+  console.log('Endpoints:');
+  line('sensor', result.sensor);
+  line('delay poll', result.delayPoll);
+  line('delay set', result.delaySet);
+  console.log('  (delay poll latency includes the long-poll hold of up to ' +
+              `${DELAY_LONG_POLL_WAIT} ms)`);
+  console.log(`Capture to store: p50 ${ms(result.captureToStore.p50Ms)}, ` +
+              `p99 ${ms(result.captureToStore.p99Ms)} (recorded_at minus device_recorded_at)`);
+  console.log(`Delay propagation: ${propagation.length} observations, ` +
+              `p50 ${ms(result.delayPropagation.p50Ms)}, p99 ${ms(result.delayPropagation.p99Ms)}`);
+  console.log(`DB: ${result.db.ingestRoundTripsPerReading.toFixed(3)} ingest round trips per reading, ` +
+              `${result.db.controlRoundTripsPerSecond.toFixed(1)} control round trips/s`);
+  console.log(`    ${JSON.stringify(db.roundTrips)}`);
+  console.log(`Event loop delay: p50 ${ms(result.eventLoopDelay.p50Ms)}, p99 ${ms(result.eventLoopDelay.p99Ms)}`);
+}
+
+async function main() {
+  const server = await listen({
+    '/api/sensor': vercelAdapter(sensorHandler),
+    '/api/delay': vercelAdapter(delayHandler),
+  });
+  port = server.address().port;
+  const loopDelay = monitorEventLoopDelay({ resolution: 10 });
+  loopDelay.enable();
+  agent = new http.Agent({ keepAlive: true, maxSockets: Infinity });
+
+  const devices = Array.from({ length: DEVICES }, (_, i) => new Device(i + 1));
+  devices.forEach(d => d.start());
+  operator();
+
+  await new Promise(resolve => setTimeout(resolve, SECONDS * 1000));
+  stopping = true;
+  loopDelay.disable();
+  report(loopDelay);
+
+  agent.destroy();
+  server.closeAllConnections();
+  server.close();
+  process.exit(0);
+}
+
+main().catch((e) => {
+  console.error(e);
+  process.exit(1);
+});
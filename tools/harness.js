@@ -0,0 +1,67 @@
+// tools/harness.js
+// Shared pieces for the local benchmarks: run the api/ handlers behind a
+// plain Node HTTP server and summarise latencies.
+const http = require('http');
+
+// --name value from the command line, as a number unless fallback is a string
+function option(name, fallback) {
+  const i = process.argv.indexOf(`--${name}`);
+  if (i < 0 || i + 1 >= process.argv.length) return fallback;
+  const value = process.argv[i + 1];
+  return typeof fallback === 'string' ? value : Number(value);
+}
+
+function flag(name) {
+  return process.argv.includes(`--${name}`);
+}
+
+// Minimal stand-in for the Vercel request/response helpers
+function vercelAdapter(handler) {
+  return (req, res) => {
+    const url = new URL(req.url, 'http://localhost');
+    req.query = Object.fromEntries(url.searchParams);
+    res.status = (code) => { res.statusCode = code; return res; };
+    res.json = (value) => {
+      res.setHeader('Content-Type', 'application/json');
+      res.end(JSON.stringify(value));
+    };
+    res.send = (body) => res.end(body);
+    handler(req, res).catch((e) => {
+      res.statusCode = 500;
+      res.end(e.message);
+    });
+  };
+}
+
+// Serves { '/api/x': vercelAdapter(...) } on an ephemeral local port
+function listen(routes) {
+  const server = http.createServer((req, res) => {
+    const route = routes[new URL(req.url, 'http://localhost').pathname];
+    if (!route) {
+      res.statusCode = 404;
+      return res.end();
+    }
+    route(req, res);
+  });
+  return new Promise(resolve => server.listen(0, '127.0.0.1', 4096, () => resolve(server)));
+}
+
+// sorted ascending
+function percentile(sorted, p) {
+  if (sorted.length === 0) return NaN;
+  return sorted[Math.min(sorted.length - 1, Math.floor(sorted.length * p / 100))];
+}
+
+// Deterministic PRNG (mulberry32) so runs with the same --seed match
+function createRandom(seed) {
+  let a = seed >>> 0;
+  return () => {
+    a = (a + 0x6D2B79F5) >>> 0;
+    let t = a;
+    t = Math.imul(t ^ (t >>> 15), t | 1);
+    t ^= t + Math.imul(t ^ (t >>> 7), t | 61);
+    return ((t ^ (t >>> 14)) >>> 0) / 4294967296;
+  };
+}
+
+module.exports = { option, flag, vercelAdapter, listen, percentile, createRandom };
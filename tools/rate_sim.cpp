@@ -0,0 +1,131 @@
+// tools/rate_sim.cpp
+// Host simulation of lib/ClimateCore/src/rate_controller.h on a fake clock.
+//
+//   g++ -std=c++17 -O1 -I lib/ClimateCore/src tools/rate_sim.cpp -o /tmp/rate_sim && /tmp/rate_sim
+//
+// Sampling: three hours of a synthetic room (DHT22-like noise and 0.1
+// rounding) through the firmware's filter and swinging door, sampled at the
+// old fixed 2 s and with AdaptiveSampler. Reports samples taken, readings
+// kept for upload, and the error of the last filtered temperature against
+// the true one (checked every second).
+//
+// Incident: a fleet of devices with a backlog in the offline log (drained
+// once a second, like drainStep) while the API answers 503 for five
+// minutes, with and without Retry-After, compared to retrying every drain.
+// Reports requests during the outage and how long after it devices
+// were uploading again (median and last).
+#include <math.h>
+#include <stdio.h>
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include "rate_controller.h"
+#include "sample_filter.h"
+#include "swinging_door.h"
+
+struct Scenario {
+    const char* name;
+    double (*temperature)(double ms);
+    double (*humidity)(double ms);
+};
+
+const double HOUR_MS = 3600000.0;
+
+double steadyT(double) { return 21.0; }
+double steadyH(double) { return 45.0; }
+double driftT(double ms) { return 20.0 + 0.5 * ms / HOUR_MS; }
+double driftH(double ms) { return 45.0 - ms / HOUR_MS; }
+// Heater switched on after 30 min: +3 °C / -6 %RH over two minutes
+double stepT(double ms) { double s = ms / 1000; return s < 1800 ? 21 : s < 1920 ? 21 + 3 * (s - 1800) / 120 : 24; }
+double stepH(double ms) { double s = ms / 1000; return s < 1800 ? 45 : s < 1920 ? 45 - 6 * (s - 1800) / 120 : 39; }
+// A 4-hour swing, much faster than a real day
+double swingT(double ms) { return 21 + 2 * sin(ms / HOUR_MS * M_PI / 2); }
+double swingH(double ms) { return 45 + 5 * cos(ms / HOUR_MS * M_PI / 2); }
+
+const float ERROR_BOUNDS[2] = { 0.1f, 0.1f };
+
+void simulateSampling(const Scenario& scenario, bool adaptive) {
+    std::mt19937 rng(1);
+    std::normal_distribution<double> noise(0, 0.05);
+    AdaptiveSampler<2> sampler(ERROR_BOUNDS, RateLimits());
+    SampleFilter<5> temperatureFilter(0.5f), humidityFilter(0.5f);
+    SwingingDoor<2> door(ERROR_BOUNDS, 300000);
+
+    const uint32_t endMs = 3 * 3600 * 1000;
+    uint32_t nextMs = 0;
+    int samples = 0, kept = 0, checks = 0;
+    float lastT = 0;
+    double sumError = 0, maxError = 0;
+
+    for (uint32_t t = 0; t < endMs; t += 1000) {
+        if ((int32_t)(t - nextMs) >= 0) {
+            float raw[2] = { (float)(round((scenario.temperature(t) + noise(rng)) * 10) / 10),
+                             (float)(round((scenario.humidity(t) + noise(rng)) * 10) / 10) };
+            SwingingDoor<2>::Sample sample = { t, { temperatureFilter.add(raw[0]), humidityFilter.add(raw[1]) } };
+            SwingingDoor<2>::Sample out;
+            if (door.offer(sample, out)) kept++;
+            lastT = sample.values[0];
+            samples++;
+            nextMs = t + (adaptive ? sampler.onSample(t, raw) : 2000);
+        }
+        if (samples > 5) {
+            double error = fabs(lastT - scenario.temperature(t));
+            sumError += error;
+            if (error > maxError) maxError = error;
+            checks++;
+        }
+    }
+    printf("%-7s %-8s samples %5d  kept %3d  mean|err| %.3f °C  max|err| %.2f °C\n",
+           scenario.name, adaptive ? "adaptive" : "fixed", samples, kept, sumError / checks, maxError);
+}
+
+enum class Retry { EveryDrain, Backoff, RetryAfter };
+
+void simulateIncident(int devices, Retry mode) {
+    const uint32_t downFromMs = 60000, downToMs = 360000, endMs = 900000;
+    std::mt19937 rng(2);
+    std::vector<UploadThrottle> fleet;
+    std::vector<uint32_t> phase;
+    for (int i = 0; i < devices; i++) {
+        fleet.emplace_back(UploadThrottleConfig(), (uint32_t)rng());
+        phase.push_back(rng() % 1000);
+    }
+
+    long during = 0;
+    std::vector<uint32_t> backAfterMs(devices, 0);
+    for (uint32_t second = 0; second < endMs / 1000; second++) {
+        for (int i = 0; i < devices; i++) {
+            uint32_t now = second * 1000 + phase[i];
+            if (mode != Retry::EveryDrain && !fleet[i].allowed(now)) continue;
+            bool down = now >= downFromMs && now < downToMs;
+            if (down) during++;
+            if (!down && now >= downToMs && backAfterMs[i] == 0) backAfterMs[i] = now - downToMs + 1;
+            fleet[i].onResult(now, down ? 503 : 200, down && mode == Retry::RetryAfter ? 30000 : 0);
+        }
+    }
+    std::sort(backAfterMs.begin(), backAfterMs.end());
+    const char* names[] = { "retry every drain", "backoff, no hint", "Retry-After: 30" };
+    printf("%-18s requests during outage %6ld  back after median %5.1f s, last %5.1f s\n",
+           names[(int)mode], during, backAfterMs[devices / 2] / 1000.0, backAfterMs[devices - 1] / 1000.0);
+}
+
+int main() {
+    const Scenario scenarios[] = {
+        { "steady", steadyT, steadyH },
+        { "drift", driftT, driftH },
+        { "step", stepT, stepH },
+        { "swing", swingT, swingH },
+    };
+    printf("Sampling, 3 h per scenario\n");
+    for (const Scenario& scenario : scenarios) {
+        simulateSampling(scenario, false);
+        simulateSampling(scenario, true);
+    }
+
+    printf("\nIncident, 500 devices, 5 min of 503\n");
+    simulateIncident(500, Retry::EveryDrain);
+    simulateIncident(500, Retry::Backoff);
+    simulateIncident(500, Retry::RetryAfter);
+    return 0;
+}
@@ -0,0 +1,74 @@
+#!/bin/sh
+# tools/size_report.sh
+# Flash and RAM per firmware env at two revisions, from the size summary
+# PlatformIO prints after linking ("RAM: ... (used N bytes ...)").
+# Each revision is checked out into a temporary git worktree and every
+# sketch is built there with its esp32-s3-devkitm-1 env.
+#
+#   tools/size_report.sh <before-rev> [after-rev]     after defaults to HEAD
+#
+# e.g. before and after the shared core:
+#   tools/size_report.sh '749aab1^' 749aab1
+set -e
+
+ENV=esp32-s3-devkitm-1
+PROJECTS="MERGED
+espfirm
+firmware
+temphumid/firmware
+Variable firmware/variableESP"
+
+before=$1
+after=${2:-HEAD}
+if [ -z "$before" ]; then
+    echo "usage: $0 <before-rev> [after-rev]" >&2
+    exit 2
+fi
+command -v pio >/dev/null || { echo "pio not found (pip install platformio)" >&2; exit 2; }
+
+root=$(git rev-parse --show-toplevel)
+work=$(mktemp -d)
+cleanup() {
+    git -C "$root" worktree remove --force "$work/before" 2>/dev/null || true
+    git -C "$root" worktree remove --force "$work/after" 2>/dev/null || true
+    rm -rf "$work"
+}
+trap cleanup EXIT
+
+git -C "$root" worktree add --detach --quiet "$work/before" "$before"
+git -C "$root" worktree add --detach --quiet "$work/after" "$after"
+
+# "<flash> <ram>" in bytes for one project, "- -" when it has no such
+# env at that revision or does not build
+sizes() {
+    dir=$1/$2
+    if [ ! -f "$dir/platformio.ini" ] || ! grep -q "^\[env:$ENV\]" "$dir/platformio.ini"; then
+        echo "- -"
+        return
+    fi
+    log=$work/build.log
+    if ! pio run -d "$dir" -e "$ENV" >"$log" 2>&1; then
+        echo "build failed: $dir (see below)" >&2
+        tail -20 "$log" >&2
+        echo "- -"
+        return
+    fi
+    flash=$(sed -n 's/^Flash:.*(used \([0-9]*\) bytes.*/\1/p' "$log" | tail -1)
+    ram=$(sed -n 's/^RAM:.*(used \([0-9]*\) bytes.*/\1/p' "$log" | tail -1)
+    echo "${flash:--} ${ram:--}"
+}
+
+delta() {
+    if [ "$1" = "-" ] || [ "$2" = "-" ]; then echo "-"; else echo $(($2 - $1)); fi
+}
+
+printf '%-30s %10s %10s %8s   %8s %8s %7s\n' "env ($ENV)" "flash $before" "flash $after" "delta" "RAM bef." "RAM aft." "delta"
+echo "$PROJECTS" | while IFS= read -r project; do
+    set -- $(sizes "$work/before" "$project")
+    flash_before=$1 ram_before=$2
+    set -- $(sizes "$work/after" "$project")
+    flash_after=$1 ram_after=$2
+    printf '%-30s %10s %10s %8s   %8s %8s %7s\n' "$project" \
+        "$flash_before" "$flash_after" "$(delta "$flash_before" "$flash_after")" \
+        "$ram_before" "$ram_after" "$(delta "$ram_before" "$ram_after")"
+done
@@ -0,0 +1,310 @@
+// tools/standin_supabase.js
+// In-process stand-in for the parts of the Supabase client the ingest and
+// control handlers use, with the same semantics as the migrations:
+//   rpc('insert_readings_if_changed')  serialised like the advisory lock
+//                                      unless p_threshold < 0 (dedupe off),
+//                                      stores only readings past p_threshold
+//   rpc('set_delay')                   bumps control_state.version
+//   rpc('readings_page')               keyset page on (observed_at, id)
+//   rpc('readings_buckets')            min/avg/max per observed_at bucket
+//   from('control_state' | 'readings' | 'device_telemetry')
+//                                      select/eq/gt/gte/lt/order/limit/
+//                                      maybeSingle; readings ordered by
+//                                      observed_at come from that index
+//   from('device_telemetry').insert(row)   kept newest first
+//   from(...).insert(row)              elsewhere accepted and dropped
+//   channel(topic).on('postgres_changes', ...).subscribe(), removeChannel
+//                                      realtime INSERTs on readings; like
+//                                      realtime-js, one channel per topic
+//                                      and no .on() after subscribe()
+// Every call is one simulated round trip of latencyMs (+ up to jitterMs)
+// and fails with probability errorRate. `roundTrips` counts calls per
+// operation so callers can report round trips per reading.
+//
+// recorded_at is clock_timestamp() as in the RPC: every row gets its own
+// microsecond timestamp, so the rows of one batch are microseconds apart
+// and usually share a millisecond. Timestamps are returned with six
+// fractional digits; timestamp parameters are compared at that precision.
+//
+// `readings` is newest first, i.e. sorted by (recorded_at, id) descending
+// like readings_recorded_at_id_idx. The history RPCs binary-search a
+// second array of the same rows sorted by (observed_at, id) descending,
+// observed_at = device_recorded_at ?? recorded_at as in the migration. A
+// caller seeding `readings` directly (bench_history_query.js) must keep
+// its order and take ids from nextId(); that index is rebuilt from it on
+// the next history call.
+
+// ISO timestamp with microseconds from microseconds since the epoch
+function timestamptz(micros) {
+  const ms = Math.floor(micros / 1000);
+  return `${new Date(ms).toISOString().slice(0, 23)}${String(micros - ms * 1000).padStart(3, '0')}Z`;
+}
+
+// Microseconds since the epoch of an ISO timestamp (Date.parse stops at ms)
+function microsOf(iso) {
+  const fraction = /\.(\d+)/.exec(iso);
+  return Date.parse(iso) * 1000 + (fraction ? Number((fraction[1] + '000000').slice(3, 6)) : 0);
+}
+
+// A timestamp parameter in the stand-in's own format, so ISO strings compare
+// in time order
+const normalizeTime = iso => timestamptz(microsOf(iso));
+
+function createStandinSupabase({ latencyMs = 10, jitterMs = 5, errorRate = 0, random = Math.random } = {}) {
+  const readings = [];      // newest first
+  let observed = [];        // by (observed_at, id), newest first
+  let lastId = 0;
+  const nextId = () => ++lastId;
+  let lastMicros = 0;
+  // clock_timestamp(): the wall clock per row, never repeating
+  function clockTimestamp() {
+    lastMicros = Math.max(Date.now() * 1000, lastMicros + 1);
+    return timestamptz(lastMicros);
+  }
+  const controlState = { key: 'delay', delay: 500, version: 1 };
+  const roundTrips = {};
+  let ingestLock = Promise.resolve();
+
+  function roundTrip(operation, work) {
+    roundTrips[operation] = (roundTrips[operation] || 0) + 1;
+    const ms = latencyMs + random() * jitterMs;
+    return new Promise(resolve => setTimeout(resolve, ms)).then(() => {
+      if (random() < errorRate) return { data: null, error: { message: 'stand-in: injected failure' } };
+      return { data: work(), error: null };
+    });
+  }
+
+  function insertIfChanged({ p_readings, p_threshold = 0.1 }) {
+    let last = readings[0];
+    let stored = 0;
+    for (const r of p_readings) {
+      if (!last || p_threshold < 0 || Math.abs(last.temperature - r.temperature) > p_threshold
+          || Math.abs(last.humidity - r.humidity) > p_threshold) {
+        last = {
+          id: nextId(),
+          temperature: r.temperature,
+          humidity: r.humidity,
+          recorded_at: clockTimestamp(),
+          device_recorded_at: r.device_recorded_at ?? null,
+        };
+        readings.unshift(last);
+        indexObserved(last);
+        broadcast('readings', last);
+        stored++;
+      }
+    }
+    return stored;
+  }
+
+  function withObservedAt(row) {
+    row.observed_at = normalizeTime(row.device_recorded_at ?? row.recorded_at);
+    return row;
+  }
+
+  function newerFirst(a, b) {
+    if (a.observed_at !== b.observed_at) return a.observed_at < b.observed_at ? 1 : -1;
+    return b.id - a.id;
+  }
+
+  function indexObserved(row) {
+    if (observed.length !== readings.length - 1) return;   // rebuilt on the next read
+    withObservedAt(row);
+    observed.splice(olderThan(row.observed_at, row.id), 0, row);
+  }
+
+  // Sorted view of readings for the history RPCs
+  function byObservedAt() {
+    if (observed.length !== readings.length) observed = readings.map(withObservedAt).sort(newerFirst);
+    return observed;
+  }
+
+  // First index in `observed` whose row is older than (at, id); ISO
+  // strings compare in time order. id null compares on observed_at only.
+  function olderThan(at, id) {
+    let lo = 0;
+    let hi = observed.length;
+    while (lo < hi) {
+      const mid = (lo + hi) >> 1;
+      const r = observed[mid];
+      const older = r.observed_at < at || (id !== null && r.observed_at === at && r.id < id);
+      if (older) hi = mid; else lo = mid + 1;
+    }
+    return lo;
+  }
+
+  function readingsPage({ p_from, p_to, p_before_at, p_before_id, p_limit }) {
+    [p_from, p_to, p_before_at] = [p_from, p_to, p_before_at].map(t => t && normalizeTime(t));
+    const rows = [];
+    const sorted = byObservedAt();
+    let start = p_to ? olderThan(p_to, null) : 0;
+    if (p_before_at) start = Math.max(start, olderThan(p_before_at, p_before_id === null ? null : Number(p_before_id)));
+    for (let i = start; i < sorted.length && rows.length < p_limit; i++) {
+      if (p_from && sorted[i].observed_at < p_from) break;
+      rows.push({ ...sorted[i] });
+    }
+    return rows;
+  }
+
+  function readingsBuckets({ p_from, p_to, p_bucket_seconds }) {
+    [p_from, p_to] = [p_from, p_to].map(normalizeTime);
+    const bucketMs = p_bucket_seconds * 1000;
+    const buckets = new Map();
+    const sorted = byObservedAt();
+    for (let i = olderThan(p_to, null); i < sorted.length && sorted[i].observed_at >= p_from; i++) {
+      const r = sorted[i];
+      const key = Math.floor(Date.parse(r.observed_at) / bucketMs) * bucketMs;
+      let b = buckets.get(key);
+      if (!b) {
+        b = { key, samples: 0, tSum: 0, hSum: 0, tMin: Infinity, tMax: -Infinity, hMin: Infinity, hMax: -Infinity };
+        buckets.set(key, b);
+      }
+      b.samples++;
+      b.tSum += r.temperature;
+      b.hSum += r.humidity;
+      b.tMin = Math.min(b.tMin, r.temperature);
+      b.tMax = Math.max(b.tMax, r.temperature);
+      b.hMin = Math.min(b.hMin, r.humidity);
+      b.hMax = Math.max(b.hMax, r.humidity);
+    }
+    return [...buckets.values()].reverse().map(b => ({
+      bucket: new Date(b.key).toISOString(),
+      samples: b.samples,
+      temperature_min: b.tMin,
+      temperature_avg: b.tSum / b.samples,
+      temperature_max: b.tMax,
+      humidity_min: b.hMin,
+      humidity_avg: b.hSum / b.samples,
+      humidity_max: b.hMax,
+    }));
+  }
+
+  const rpcs = {
+    insert_readings_if_changed(params) {
+      const run = () => roundTrip('insert_readings_if_changed', () => insertIfChanged(params));
+      // Dedupe off compares nothing and takes no lock
+      if (params.p_threshold < 0) return run();
+      // pg_advisory_xact_lock: one ingest at a time
+      const result = ingestLock.then(run);
+      ingestLock = result.catch(() => {});
+      return result;
+    },
+    set_delay({ p_delay }) {
+      return roundTrip('set_delay', () => {
+        controlState.delay = p_delay;
+        controlState.version++;
+        return [{ delay: controlState.delay, version: controlState.version }];
+      });
+    },
+    readings_page(params) {
+      return roundTrip('readings_page', () => readingsPage(params));
+    },
+    readings_buckets(params) {
+      return roundTrip('readings_buckets', () => readingsBuckets(params));
+    },
+  };
+
+  const telemetry = [];      // newest first
+
+  // Realtime: delivered after the inserting call has returned
+  const channels = new Map();    // topic -> channel
+
+  function broadcast(table, row) {
+    for (const channel of channels.values()) {
+      if (!channel.subscribed) continue;
+      for (const { filter, callback } of channel.listeners) {
+        if (filter.event === 'INSERT' && filter.table === table) {
+          setImmediate(() => callback({ eventType: 'INSERT', table, new: { ...row } }));
+        }
+      }
+    }
+  }
+
+  function channel(topic) {
+    if (channels.has(topic)) return channels.get(topic);
+    const created = {
+      topic,
+      listeners: [],
+      subscribed: false,
+      on(type, filter, callback) {
+        if (created.subscribed) {
+          throw new Error(`cannot add \`${type}\` callbacks for realtime:${topic} after \`subscribe()\`.`);
+        }
+        created.listeners.push({ filter, callback });
+        return created;
+      },
+      subscribe() {
+        created.subscribed = true;
+        return created;
+      },
+    };
+    channels.set(topic, created);
+    return created;
+  }
+
+  const tables = {
+    control_state: () => [controlState],
+    readings: orderedBy => (orderedBy === 'observed_at' ? byObservedAt() : readings),
+    device_telemetry: () => telemetry,
+  };
+
+  // recorded_at and observed_at are kept in the stand-in's format
+  const comparable = (column, value) => (column === 'recorded_at' || column === 'observed_at' ? normalizeTime(value) : value);
+
+  // Thenable query builder covering the calls made under api/
+  function query(table) {
+    const filters = [];
+    let limit = Infinity;
+    let orderedBy = null;
+    let single = false;
+    let insertRow = null;
+
+    const builder = {
+      select() { return builder; },
+      // Rows are kept newest first; only the first key picks the order
+      order(column) { orderedBy = orderedBy || column; return builder; },
+      eq(column, value) { filters.push(row => row[column] === value); return builder; },
+      gt(column, value) { value = comparable(column, value); filters.push(row => row[column] > value); return builder; },
+      gte(column, value) { value = comparable(column, value); filters.push(row => row[column] >= value); return builder; },
+      lt(column, value) { value = comparable(column, value); filters.push(row => row[column] < value); return builder; },
+      limit(n) { limit = n; return builder; },
+      maybeSingle() { single = true; return builder; },
+      insert(row) { insertRow = row; return builder; },
+      then(resolve, reject) {
+        const operation = `${insertRow ? 'insert' : 'select'} ${table}`;
+        return roundTrip(operation, () => {
+          if (insertRow) {
+            if (table === 'device_telemetry') telemetry.unshift({ received_at: new Date().toISOString(), ...insertRow });
+            return null;
+          }
+          const rows = (tables[table] ? tables[table](orderedBy) : [])
+            .filter(row => filters.every(f => f(row)))
+            .slice(0, limit)
+            .map(row => ({ ...row }));
+          return single ? rows[0] || null : rows;
+        }).then(resolve, reject);
+      },
+    };
+    return builder;
+  }
+
+  return {
+    roundTrips,
+    readings,
+    nextId,
+    rpc(name, params) {
+      const fn = rpcs[name];
+      if (!fn) return Promise.resolve({ data: null, error: { message: `stand-in: no rpc ${name}` } });
+      return fn(params);
+    },
+    from: query,
+    channel,
+    channels,
+    removeChannel(removed) {
+      removed.subscribed = false;
+      channels.delete(removed.topic);
+      return Promise.resolve('ok');
+    },
+  };
+}
+
+module.exports = { createStandinSupabase, timestamptz };